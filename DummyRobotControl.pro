@@ -1,26 +1,15 @@
-QT       += core gui serialport
-
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
-
-CONFIG += c++11
-
-# You can make your code fail to compile if it uses deprecated APIs.
-# In order to do so, uncomment the following line.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
-
-SOURCES += \
-    main.cpp \
-    mainwidget.cpp \
-    serialsender.cpp
-
-HEADERS += \
-    mainwidget.h \
-    serialsender.h
-
-FORMS += \
-    mainwidget.ui
-
-# Default rules for deployment.
-qnx: target.path = /tmp/$${TARGET}/bin
-else: unix:!android: target.path = /opt/$${TARGET}/bin
-!isEmpty(target.path): INSTALLS += target
+TEMPLATE = subdirs
+
+# core:   dummycore静态库，串口链路、指令编码、应答解析、记录、回放和网络桥，不依赖QtGui
+# gui:    Qt Widgets上位机
+# daemon: 基于QCoreApplication的无界面守护进程，用于没有显示屏的板子
+# benchmarks: 性能基准，bridge_bench链接dummycore
+SUBDIRS += \
+    core \
+    gui \
+    daemon \
+    benchmarks
+
+gui.depends = core
+daemon.depends = core
+benchmarks.depends = core
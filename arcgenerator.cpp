@@ -0,0 +1,167 @@
+#include "arcgenerator.h"
+#include "posemath.h"
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+//半径或夹角小于该值视为退化
+#define ARC_EPSILON 1e-4
+
+//按位置反求时间，速度规划单调递增，二分即可
+static double timeAtPosition(const MotionProfile& profile, double position)
+{
+    double low = 0;
+    double high = profile.duration();
+    for(int i = 0; i < 48; ++i)
+    {
+        double mid = (low + high) / 2;
+        if(profile.position(mid) < position)
+        {
+            low = mid;
+        }else{
+            high = mid;
+        }
+    }
+    return high;
+}
+
+bool ArcGenerator::plan(const float *start, const QVector3D &center, const float *end, ArcGeometry &arc,
+                        bool bMajorArc)
+{
+    QVector3D startPoint(start[0], start[1], start[2]);
+    QVector3D endPoint(end[0], end[1], end[2]);
+    QVector3D toStart = startPoint - center;
+    QVector3D toEnd = endPoint - center;
+
+    arc.center = center;
+    arc.startRadius = toStart.length();
+    arc.endRadius = toEnd.length();
+    if(arc.startRadius < ARC_EPSILON || arc.endRadius < ARC_EPSILON)
+    {
+        return false;
+    }
+
+    //法向量由起点转向终点，决定运动方向；共线时（含起点终点重合）平面不确定
+    QVector3D normal = QVector3D::crossProduct(toStart, toEnd);
+    if(normal.length() < ARC_EPSILON * arc.startRadius * arc.endRadius)
+    {
+        return false;
+    }
+    normal.normalize();
+
+    float cosSweep = QVector3D::dotProduct(toStart, toEnd) / (arc.startRadius * arc.endRadius);
+    arc.sweep = std::acos(qBound(-1.0f, cosSweep, 1.0f));
+    //优弧：绕反向的法向量转过剩下的角度
+    if(bMajorArc)
+    {
+        normal = -normal;
+        arc.sweep = float(2 * M_PI) - arc.sweep;
+    }
+
+    arc.u = toStart / arc.startRadius;
+    arc.v = QVector3D::crossProduct(normal, arc.u).normalized();
+
+    arc.startOrientation = PoseMath::fromAbc(start + 3);
+    arc.endOrientation = PoseMath::fromAbc(end + 3);
+    return true;
+}
+
+int ArcGenerator::segmentCount(const ArcGeometry &arc, double chordTolerance)
+{
+    //弦高 e = r(1 - cos(dθ/2))，取较大的半径
+    double radius = qMax(arc.startRadius, arc.endRadius);
+    double step = M_PI;
+    if(chordTolerance > 0 && chordTolerance < radius)
+    {
+        step = 2 * std::acos(1 - chordTolerance / radius);
+    }
+    int nCount = static_cast<int>(std::ceil(arc.sweep / step));
+    return qMax(nCount, 1);
+}
+
+void ArcGenerator::evaluate(const ArcGeometry &arc, const float *ratios, int count,
+                            float *x, float *y, float *z)
+{
+    //按分量分开的连续数组，循环内没有分支；每点一次std::cos/std::sin是标量库调用，
+    //这个循环不会被向量化，耗时主要在三角函数上
+    const float cx = arc.center.x();
+    const float cy = arc.center.y();
+    const float cz = arc.center.z();
+    const float ux = arc.u.x();
+    const float uy = arc.u.y();
+    const float uz = arc.u.z();
+    const float vx = arc.v.x();
+    const float vy = arc.v.y();
+    const float vz = arc.v.z();
+    const float r0 = arc.startRadius;
+    const float dr = arc.endRadius - arc.startRadius;
+    const float sweep = arc.sweep;
+    for(int i = 0; i < count; ++i)
+    {
+        float angle = ratios[i] * sweep;
+        float radius = r0 + dr * ratios[i];
+        float c = radius * std::cos(angle);
+        float s = radius * std::sin(angle);
+        x[i] = cx + c * ux + s * vx;
+        y[i] = cy + c * uy + s * vy;
+        z[i] = cz + c * uz + s * vz;
+    }
+}
+
+int ArcGenerator::generate(const float *start, const QVector3D &center, const float *end,
+                           const PathOptions &options, quint32 startTimeMs, QVector<TrajectoryRecord> &out,
+                           bool bMajorArc)
+{
+    ArcGeometry arc;
+    if(!plan(start, center, end, arc, bMajorArc))
+    {
+        return -1;
+    }
+
+    double distance = arc.length();
+    MotionProfile profile;
+    if(!profile.plan(options.profile, distance, options.limits))
+    {
+        return -1;
+    }
+
+    //点数由弦高决定，但最高速度下相邻两点的时间间隔不能小于调度线程的发送能力
+    int nCount = segmentCount(arc, options.chordTolerance);
+    double minSpacing = profile.peakVelocity() * LinearGenerator::MIN_SAMPLE_MS / 1000.0;
+    int nMaxCount = (minSpacing > 0) ? static_cast<int>(distance / minSpacing) : nCount;
+    nCount = qMax(1, qMin(nCount, nMaxCount));
+
+    QVector<float> ratios(nCount);
+    QVector<float> xs(nCount);
+    QVector<float> ys(nCount);
+    QVector<float> zs(nCount);
+    for(int i = 0; i < nCount; ++i)
+    {
+        ratios[i] = float(i + 1) / nCount;
+    }
+    evaluate(arc, ratios.constData(), nCount, xs.data(), ys.data(), zs.data());
+
+    out.reserve(out.size() + nCount);
+    for(int i = 0; i < nCount; ++i)
+    {
+        TrajectoryRecord record;
+        record.pose[0] = xs[i];
+        record.pose[1] = ys[i];
+        record.pose[2] = zs[i];
+        QQuaternion orientation = QQuaternion::slerp(arc.startOrientation, arc.endOrientation, ratios[i]);
+        PoseMath::toAbc(orientation, record.pose + 3);
+        double t = timeAtPosition(profile, distance * ratios[i]);
+        record.timestampMs = startTimeMs + static_cast<quint32>(std::lround(t * 1000));
+        record.speed = 0;
+        record.flags = 0;
+        out.append(record);
+    }
+
+    //终点取原值
+    for(int i = 0; i < 6; ++i)
+    {
+        out.last().pose[i] = end[i];
+    }
+    return nCount;
+}
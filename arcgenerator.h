@@ -0,0 +1,49 @@
+#ifndef ARCGENERATOR_H
+#define ARCGENERATOR_H
+
+#include <QVector>
+#include <QVector3D>
+#include <QQuaternion>
+#include "lineargenerator.h"
+
+// 圆弧的几何描述：在u、v张成的平面内从u方向转过sweep弧度
+// 起点和终点到圆心距离不同时半径沿圆弧线性过渡
+struct ArcGeometry
+{
+    QVector3D center;
+    QVector3D u;            //圆心指向起点的单位向量
+    QVector3D v;            //平面内与u垂直、指向运动方向的单位向量
+    float startRadius = 0;
+    float endRadius = 0;
+    float sweep = 0;        //弧度，劣弧(0, pi)，优弧(pi, 2pi)
+    QQuaternion startOrientation;
+    QQuaternion endOrientation;
+
+    //弧长
+    double length() const { return sweep * (startRadius + endRadius) / 2.0; }
+};
+
+// 三点圆弧插补：从起点绕圆心转到终点，默认走小于180度的劣弧，bMajorArc为true时反向走优弧
+// 点数由弦高误差和半径决定，姿态沿圆弧球面线性插值
+class ArcGenerator
+{
+public:
+    //起点、终点与圆心共线时无法确定平面，返回false：
+    //  起点与终点重合（整圆）和起点终点关于圆心对称（半圆）都属于这种情况，需分成两段圆弧添加
+    static bool plan(const float* start, const QVector3D& center, const float* end, ArcGeometry& arc,
+                     bool bMajorArc = false);
+
+    //弦高不超过chordTolerance所需的分段数
+    static int segmentCount(const ArcGeometry& arc, double chordTolerance);
+
+    //批量求位置：ratios为0~1的弧长比例，结果按分量分别写入x、y、z
+    static void evaluate(const ArcGeometry& arc, const float* ratios, int count,
+                         float* x, float* y, float* z);
+
+    //插补并按速度规划加时间戳，追加到out（不含起点），返回追加的点数，失败返回-1
+    static int generate(const float* start, const QVector3D& center, const float* end,
+                        const PathOptions& options, quint32 startTimeMs, QVector<TrajectoryRecord>& out,
+                        bool bMajorArc = false);
+};
+
+#endif // ARCGENERATOR_H
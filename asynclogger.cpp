@@ -0,0 +1,320 @@
+#include "asynclogger.h"
+#include "monotonicclock.h"
+#include <QFile>
+#include <QMutexLocker>
+#include <cstdio>
+#include <cstring>
+
+AsyncLogger::AsyncLogger()
+    : m_nEnqueuePos(0)
+    , m_nLevel(LOG_INFO)
+    , m_bStop(0)
+    , m_nDropped(0)
+    , m_nWritten(0)
+    , m_bReopen(0)
+    , m_nStartNs(monotonicNs())
+{
+    //槽位序号等于下标表示可写
+    for(int i = 0; i < RING_SIZE; ++i)
+    {
+        m_slots[i].sequence.store(quint32(i));
+    }
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    stop();
+}
+
+AsyncLogger *AsyncLogger::instance()
+{
+    static AsyncLogger s_logger;
+    return &s_logger;
+}
+
+bool AsyncLogger::isEnabled(LOG_LEVEL level)
+{
+    return level >= instance()->m_nLevel.load();
+}
+
+void AsyncLogger::fillHeader(LogRecord &record, LOG_LEVEL level, const char *format)
+{
+    record.timestampNs = monotonicNs();
+    record.format = format;
+    record.level = quint8(level);
+    record.argCount = 0;
+    record.dataSize = 0;
+    record.bTruncated = 0;
+}
+
+void AsyncLogger::log(LOG_LEVEL level, const char *format)
+{
+    log(level, format, nullptr, 0);
+}
+
+void AsyncLogger::log(LOG_LEVEL level, const char *format, double a0)
+{
+    if(!isEnabled(level))
+    {
+        return;
+    }
+    LogRecord record;
+    fillHeader(record, level, format);
+    record.args[0] = a0;
+    record.argCount = 1;
+    instance()->push(record);
+}
+
+void AsyncLogger::log(LOG_LEVEL level, const char *format, double a0, double a1)
+{
+    if(!isEnabled(level))
+    {
+        return;
+    }
+    LogRecord record;
+    fillHeader(record, level, format);
+    record.args[0] = a0;
+    record.args[1] = a1;
+    record.argCount = 2;
+    instance()->push(record);
+}
+
+void AsyncLogger::log(LOG_LEVEL level, const char *format, const float *values, int count)
+{
+    if(!isEnabled(level))
+    {
+        return;
+    }
+    LogRecord record;
+    fillHeader(record, level, format);
+    int nCount = qMin(count, int(LogRecord::MAX_ARGS));
+    for(int i = 0; i < nCount; ++i)
+    {
+        record.args[i] = values[i];
+    }
+    record.argCount = quint8(qMax(nCount, 0));
+    instance()->push(record);
+}
+
+void AsyncLogger::logData(LOG_LEVEL level, const char *format, const char *data, int size)
+{
+    if(!isEnabled(level))
+    {
+        return;
+    }
+    LogRecord record;
+    fillHeader(record, level, format);
+    //长度作为第一个参数，方便截断时仍能看到实际大小
+    record.args[0] = size;
+    record.argCount = 1;
+    int nSize = qMin(qMax(size, 0), int(LogRecord::MAX_DATA));
+    memcpy(record.data, data, size_t(nSize));
+    record.dataSize = quint8(nSize);
+    record.bTruncated = (size > nSize) ? 1 : 0;
+    instance()->push(record);
+}
+
+void AsyncLogger::setLevel(LOG_LEVEL level)
+{
+    m_nLevel.store(level);
+}
+
+LOG_LEVEL AsyncLogger::level() const
+{
+    return static_cast<LOG_LEVEL>(m_nLevel.load());
+}
+
+void AsyncLogger::setOutputFile(const QString &filePath)
+{
+    QMutexLocker locker(&m_fileMutex);
+    m_strFilePath = filePath;
+    m_bReopen.store(1);
+}
+
+void AsyncLogger::stop()
+{
+    if(!isRunning())
+    {
+        return;
+    }
+    m_bStop.store(1);
+    wait();
+    m_bStop.store(0);
+}
+
+quint32 AsyncLogger::droppedCount() const
+{
+    return m_nDropped.load();
+}
+
+quint32 AsyncLogger::writtenCount() const
+{
+    return m_nWritten.load();
+}
+
+const char *AsyncLogger::levelName(LOG_LEVEL level)
+{
+    switch(level)
+    {
+    case LOG_TRACE: return "T";
+    case LOG_DEBUG: return "D";
+    case LOG_INFO: return "I";
+    case LOG_WARN: return "W";
+    case LOG_ERROR: return "E";
+    default: return "?";
+    }
+}
+
+void AsyncLogger::run()
+{
+    QFile output;
+    m_bReopen.store(0);
+    openOutput(output);
+
+    //队列空时按固定间隔轮询，写日志的线程不需要唤醒后台线程
+    while(!m_bStop.load())
+    {
+        if(m_bReopen.fetchAndStoreRelaxed(0))
+        {
+            output.close();
+            openOutput(output);
+        }
+        if(drain(output) == 0)
+        {
+            QThread::msleep(FLUSH_INTERVAL_MS);
+        }
+    }
+    drain(output);
+    output.close();
+}
+
+bool AsyncLogger::push(const LogRecord &record)
+{
+    //多生产者：先抢占写位置，再写内容，最后更新槽位序号交给后台线程
+    quint32 pos = m_nEnqueuePos.load();
+    Slot* slot;
+    for(;;)
+    {
+        slot = &m_slots[pos & (RING_SIZE - 1)];
+        qint32 diff = qint32(slot->sequence.loadAcquire() - pos);
+        if(diff == 0)
+        {
+            if(m_nEnqueuePos.testAndSetRelaxed(pos, pos + 1, pos))
+            {
+                break;
+            }
+        }else if(diff < 0)
+        {
+            //后台线程还没取走，队列已满
+            m_nDropped.fetchAndAddRelaxed(1);
+            return false;
+        }else{
+            pos = m_nEnqueuePos.load();
+        }
+    }
+    slot->record = record;
+    slot->sequence.storeRelease(pos + 1);
+    return true;
+}
+
+bool AsyncLogger::pop(LogRecord &record)
+{
+    Slot& slot = m_slots[m_nDequeuePos & (RING_SIZE - 1)];
+    if(qint32(slot.sequence.loadAcquire() - (m_nDequeuePos + 1)) < 0)
+    {
+        return false;
+    }
+    record = slot.record;
+    slot.sequence.storeRelease(m_nDequeuePos + RING_SIZE);
+    ++m_nDequeuePos;
+    return true;
+}
+
+int AsyncLogger::drain(QFile &output)
+{
+    QByteArray text;
+    LogRecord record;
+    int nCount = 0;
+    while(pop(record))
+    {
+        text += format(record);
+        ++nCount;
+    }
+
+    quint32 nDropped = m_nDropped.load();
+    if(nDropped != m_nReportedDrops)
+    {
+        text += QString("[log] dropped %1 records\n").arg(nDropped - m_nReportedDrops).toLatin1();
+        m_nReportedDrops = nDropped;
+    }
+
+    if(!text.isEmpty())
+    {
+        output.write(text);
+        output.flush();
+        m_nWritten.fetchAndAddRelaxed(quint32(nCount));
+    }
+    return nCount;
+}
+
+void AsyncLogger::openOutput(QFile &output)
+{
+    QString filePath;
+    {
+        QMutexLocker locker(&m_fileMutex);
+        filePath = m_strFilePath;
+    }
+
+    if(!filePath.isEmpty())
+    {
+        output.setFileName(filePath);
+        if(output.open(QIODevice::WriteOnly | QIODevice::Append))
+        {
+            return;
+        }
+        fprintf(stderr, "[log] failed to open %s, using stderr\n", qPrintable(filePath));
+    }
+    output.open(stderr, QIODevice::WriteOnly);
+}
+
+QByteArray AsyncLogger::format(const LogRecord &record) const
+{
+    QString message = QString::fromLatin1(record.format);
+    for(int i = 0; i < record.argCount; ++i)
+    {
+        message = message.arg(record.args[i]);
+    }
+
+    if(record.dataSize > 0 || record.bTruncated)
+    {
+        QString data;
+        for(int i = 0; i < record.dataSize; ++i)
+        {
+            uchar c = uchar(record.data[i]);
+            if(c == '\r')
+            {
+                data += "\\r";
+            }else if(c == '\n')
+            {
+                data += "\\n";
+            }else if(c >= 0x20 && c < 0x7f)
+            {
+                data += QChar(c);
+            }else{
+                data += QString("\\x%1").arg(c, 2, 16, QChar('0'));
+            }
+        }
+        if(record.bTruncated)
+        {
+            data += "...";
+        }
+        message = message.arg(data);
+    }
+
+    double seconds = (record.timestampNs - m_nStartNs) / 1e9;
+    return QString("[%1] %2 %3\n")
+            .arg(seconds, 11, 'f', 6)
+            .arg(levelName(static_cast<LOG_LEVEL>(record.level)))
+            .arg(message)
+            .toUtf8();
+}
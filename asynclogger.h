@@ -0,0 +1,108 @@
+#ifndef ASYNCLOGGER_H
+#define ASYNCLOGGER_H
+
+#include <QThread>
+#include <QAtomicInteger>
+#include <QString>
+#include <QMutex>
+
+class QFile;
+
+typedef enum LogLevel
+{
+    LOG_TRACE,
+    LOG_DEBUG,
+    LOG_INFO,
+    LOG_WARN,
+    LOG_ERROR,
+    LOG_OFF
+}LOG_LEVEL;
+
+// 一条日志：固定大小，入队时只做拷贝，格式化放到后台线程
+// format必须是字符串常量，%1 %2...依次替换为数值参数，最后一个占位符为数据
+struct LogRecord
+{
+    static const int MAX_ARGS = 6;
+    static const int MAX_DATA = 32;
+
+    qint64 timestampNs;
+    const char* format;
+    quint8 level;
+    quint8 argCount;
+    quint8 dataSize;
+    quint8 bTruncated;      //数据超过MAX_DATA被截断
+    double args[MAX_ARGS];
+    char data[MAX_DATA];
+};
+
+// 异步日志：各线程把记录写入无锁环形队列，后台线程批量格式化后写到stderr或文件
+// 队列满时直接丢弃并计数，调用方不会阻塞；低于当前级别的日志只有一次原子读的开销
+class AsyncLogger : public QThread
+{
+    Q_OBJECT
+public:
+    static const int RING_SIZE = 2048;  //必须是2的幂
+    static const int FLUSH_INTERVAL_MS = 20;
+
+    static AsyncLogger* instance();
+    ~AsyncLogger();
+
+    static bool isEnabled(LOG_LEVEL level);
+    static void log(LOG_LEVEL level, const char* format);
+    static void log(LOG_LEVEL level, const char* format, double a0);
+    static void log(LOG_LEVEL level, const char* format, double a0, double a1);
+    //values最多取MAX_ARGS个
+    static void log(LOG_LEVEL level, const char* format, const float* values, int count);
+    //data按可打印字符输出，其余字节转成\xNN
+    static void logData(LOG_LEVEL level, const char* format, const char* data, int size);
+
+    void setLevel(LOG_LEVEL level);
+    LOG_LEVEL level() const;
+    //空字符串表示输出到stderr，在start之前或运行中都可以切换，打不开时退回stderr
+    void setOutputFile(const QString& filePath);
+    //停止后台线程，剩余的日志写完再返回
+    void stop();
+
+    //队列满被丢弃的条数
+    quint32 droppedCount() const;
+    quint32 writtenCount() const;
+
+    static const char* levelName(LOG_LEVEL level);
+
+protected:
+    void run() override;
+
+private:
+    AsyncLogger();
+    bool push(const LogRecord& record);
+    bool pop(LogRecord& record);
+    //取出所有日志并写出，返回条数
+    int drain(QFile& output);
+    void openOutput(QFile& output);
+    QByteArray format(const LogRecord& record) const;
+    static void fillHeader(LogRecord& record, LOG_LEVEL level, const char* format);
+
+private:
+    struct Slot
+    {
+        QAtomicInteger<quint32> sequence;
+        LogRecord record;
+    };
+
+    Slot m_slots[RING_SIZE];
+    QAtomicInteger<quint32> m_nEnqueuePos;
+    quint32 m_nDequeuePos = 0;      //只有后台线程访问
+
+    QAtomicInt m_nLevel;
+    QAtomicInt m_bStop;
+    QAtomicInteger<quint32> m_nDropped;
+    QAtomicInteger<quint32> m_nWritten;
+    quint32 m_nReportedDrops = 0;
+
+    QAtomicInt m_bReopen;
+    QMutex m_fileMutex;
+    QString m_strFilePath;
+    qint64 m_nStartNs;
+};
+
+#endif // ASYNCLOGGER_H
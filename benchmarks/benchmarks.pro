@@ -0,0 +1,12 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    bridge_bench \
+    cmdencoder_bench \
+    commandring_bench \
+    replyparser_bench
+
+# 串口链路基准带着伪终端模拟控制器（posix_openpt），Windows上不构建
+unix {
+    SUBDIRS += seriallink_bench
+}
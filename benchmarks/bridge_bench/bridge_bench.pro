@@ -0,0 +1,18 @@
+QT       -= gui
+QT       += core serialport network
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = bridge_bench
+
+# 串口链路和网络桥直接链接dummycore，core在顶层工程的构建目录下
+DUMMYCORE_BUILD = $$OUT_PWD/../../core
+include(../../dummycore.pri)
+
+SOURCES += \
+    bridgebench.cpp \
+    main.cpp
+
+HEADERS += \
+    bridgebench.h
@@ -0,0 +1,271 @@
+#include "bridgebench.h"
+#include "serialsender.h"
+#include "networkbridge.h"
+#include "commandencoder.h"
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QTimer>
+
+//打开链路、连接客户端和等待客户端追上的超时
+#define OPEN_TIMEOUT_MS 3000
+#define DRAIN_TIMEOUT_MS 10000
+//停止轮询后等待在途应答的时间
+#define SETTLE_MS 200
+
+BenchClient::BenchClient(QObject *parent)
+    : QObject(parent)
+    , m_socket(new QTcpSocket(this))
+{
+    connect(m_socket, &QTcpSocket::readyRead, this, &BenchClient::onReadyRead);
+}
+
+void BenchClient::connectTo(quint16 port)
+{
+    m_socket->connectToHost(QHostAddress(QHostAddress::LocalHost).toString(), port);
+}
+
+void BenchClient::setPaused(bool bPaused)
+{
+    m_bPaused = bPaused;
+    m_socket->setReadBufferSize(bPaused ? 1 : 0);
+    if(!bPaused)
+    {
+        onReadyRead();
+    }
+}
+
+void BenchClient::sendLine(const QByteArray &line)
+{
+    m_socket->write(line);
+    m_socket->write("\n");
+}
+
+bool BenchClient::isConnected() const
+{
+    return m_socket->state() == QAbstractSocket::ConnectedState;
+}
+
+void BenchClient::onReadyRead()
+{
+    if(m_bPaused)
+    {
+        return;
+    }
+    m_buffer += m_socket->readAll();
+    int nStart = 0;
+    int nEnd;
+    while((nEnd = m_buffer.indexOf('\n', nStart)) >= 0)
+    {
+        handleLine(m_buffer.mid(nStart, nEnd - nStart));
+        nStart = nEnd + 1;
+    }
+    m_buffer.remove(0, nStart);
+}
+
+void BenchClient::handleLine(const QByteArray &line)
+{
+    if(line.startsWith("bridge dropped "))
+    {
+        m_nDropNotices++;
+        m_nDroppedFrames += line.mid(15).toLongLong();
+        return;
+    }
+    if(line == "bridge busy")
+    {
+        m_nBusy++;
+        return;
+    }
+    if(line.startsWith("bridge err"))
+    {
+        m_nErrors++;
+        return;
+    }
+
+    //"<接收时刻us> <指令> <应答>"，时间戳不能倒退
+    int nFirst = line.indexOf(' ');
+    int nSecond = (nFirst < 0) ? -1 : line.indexOf(' ', nFirst + 1);
+    if(nSecond < 0)
+    {
+        m_nOrderErrors++;
+        return;
+    }
+    qint64 nTimestampUs = line.left(nFirst).toLongLong();
+    if(nTimestampUs < m_nLastTimestampUs)
+    {
+        m_nOrderErrors++;
+    }
+    m_nLastTimestampUs = nTimestampUs;
+    if(!m_commandTag.isEmpty() && line.mid(nFirst + 1, nSecond - nFirst - 1) == m_commandTag)
+    {
+        m_nTaggedLines++;
+    }
+    m_nLines++;
+}
+
+BridgeBench::BridgeBench(QObject *parent) : QObject(parent)
+{
+    m_sender = new SerialSender(this);
+    m_bridge = new NetworkBridge(m_sender, this);
+    connect(m_sender, &SerialSender::signalOpened, this, &BridgeBench::onOpened);
+    m_commandTimer = new QTimer(this);
+    connect(m_commandTimer, &QTimer::timeout, this, &BridgeBench::onSendCommand);
+}
+
+QJsonObject BridgeBench::run(int durationMs, int fastClients, int commandIntervalMs)
+{
+    QJsonObject result;
+    result["duration_ms"] = durationMs;
+    result["fast_clients"] = fastClients;
+
+    m_sender->open(LOOPBACK_PORT_NAME, 0, PROTOCOL_ASCII);
+    if(!waitUntil([this]() { return m_bOpened; }, OPEN_TIMEOUT_MS)
+            || !m_bridge->listen(QHostAddress(QHostAddress::LocalHost), 0))
+    {
+        result["error"] = QStringLiteral("failed to open link or listen");
+        return result;
+    }
+
+    //没有客户端时的帧率作为基准
+    qint64 nBaseline = poll(durationMs);
+    result["baseline_frames_per_s"] = nBaseline * 1000.0 / durationMs;
+
+    QList<BenchClient*> clients;
+    for(int i = 0; i <= fastClients; ++i)
+    {
+        BenchClient* client = new BenchClient(this);
+        client->setCommandTag(CommandEncoder::spec(GETLPOS).text);
+        client->connectTo(m_bridge->serverPort());
+        clients.append(client);
+    }
+    BenchClient* slowClient = clients.last();
+    slowClient->setPaused(true);
+    if(!waitUntil([this, &clients]() { return m_bridge->clientCount() == clients.size(); }, OPEN_TIMEOUT_MS))
+    {
+        result["error"] = QStringLiteral("clients failed to connect");
+        return result;
+    }
+
+    //第一个快客户端同时通过网络桥发指令
+    m_commandClient = clients.first();
+    if(commandIntervalMs > 0)
+    {
+        m_commandTimer->start(commandIntervalMs);
+    }
+    qint64 nStart = m_bridge->telemetryCount();
+    qint64 nBridged = poll(durationMs);
+    result["bridged_frames_per_s"] = nBridged * 1000.0 / durationMs;
+    result["rate_ratio"] = nBaseline > 0 ? double(nBridged) / nBaseline : 0.0;
+
+    //快客户端必须收到接入之后的每一帧
+    qint64 nExpected = m_bridge->telemetryCount() - nStart;
+    result["expected_frames"] = nExpected;
+    waitUntil([&clients, nExpected]() {
+        for(int i = 0; i < clients.size() - 1; ++i)
+        {
+            if(clients.at(i)->lines() < nExpected)
+            {
+                return false;
+            }
+        }
+        return true;
+    }, DRAIN_TIMEOUT_MS);
+
+    QString strError;
+    qint64 nMinLines = nExpected;
+    int nOrderErrors = 0;
+    for(int i = 0; i < clients.size() - 1; ++i)
+    {
+        nMinLines = qMin(nMinLines, clients.at(i)->lines());
+        nOrderErrors += clients.at(i)->orderErrors();
+        if(clients.at(i)->lines() != nExpected || clients.at(i)->dropNotices() > 0)
+        {
+            strError = QString("fast client %1 received %2 of %3 frames")
+                    .arg(i).arg(clients.at(i)->lines()).arg(nExpected);
+        }
+    }
+    result["fast_min_frames"] = nMinLines;
+    result["order_errors"] = nOrderErrors;
+    result["command_replies"] = m_commandClient->taggedLines();
+    result["busy_replies"] = m_commandClient->busyReplies();
+    result["error_replies"] = m_commandClient->errorReplies();
+    if(nOrderErrors > 0)
+    {
+        strError = QStringLiteral("telemetry out of order");
+    }else if(commandIntervalMs > 0 && m_commandClient->taggedLines() == 0)
+    {
+        strError = QStringLiteral("no reply to bridged commands");
+    }
+
+    //慢客户端恢复读取，收到的加上通知丢掉的应该正好是全部遥测，丢掉的帧数和网络桥的统计一致
+    slowClient->setPaused(false);
+    waitUntil([slowClient, nExpected]() {
+        return slowClient->lines() + slowClient->droppedFrames() >= nExpected;
+    }, DRAIN_TIMEOUT_MS);
+    result["slow_frames"] = slowClient->lines();
+    result["slow_dropped_frames"] = slowClient->droppedFrames();
+    result["bridge_dropped_frames"] = double(m_bridge->droppedCount());
+    if(strError.isEmpty() && slowClient->lines() + slowClient->droppedFrames() != nExpected)
+    {
+        strError = QString("slow client accounted for %1 of %2 frames")
+                .arg(slowClient->lines() + slowClient->droppedFrames()).arg(nExpected);
+    }else if(strError.isEmpty() && slowClient->droppedFrames() != qint64(m_bridge->droppedCount()))
+    {
+        strError = QStringLiteral("slow client drop notices do not match bridge statistics");
+    }
+    if(!strError.isEmpty())
+    {
+        result["error"] = strError;
+    }
+
+    m_bridge->close();
+    m_sender->close();
+    return result;
+}
+
+void BridgeBench::onOpened()
+{
+    m_bOpened = true;
+}
+
+void BridgeBench::onSendCommand()
+{
+    char buf[CommandEncoder::MAX_CMD_SIZE];
+    int nSize = CommandEncoder::encodeAscii(GETLPOS, nullptr, 0, buf, sizeof(buf));
+    //去掉\r\n，由客户端按行发送
+    while(nSize > 0 && (buf[nSize - 1] == '\n' || buf[nSize - 1] == '\r'))
+    {
+        nSize--;
+    }
+    m_commandClient->sendLine(QByteArray(buf, nSize));
+}
+
+qint64 BridgeBench::poll(int durationMs)
+{
+    char buf[CommandEncoder::MAX_CMD_SIZE];
+    int nSize = CommandEncoder::encodeAscii(GETJPOS, nullptr, 0, buf, sizeof(buf));
+    qint64 nStart = m_bridge->telemetryCount();
+    m_sender->startPolling(QByteArray(buf, nSize), 0);
+    waitUntil([]() { return false; }, durationMs);
+    m_sender->stopPolling();
+    m_commandTimer->stop();
+    //在途的应答也算进这一段
+    waitUntil([]() { return false; }, SETTLE_MS);
+    return m_bridge->telemetryCount() - nStart;
+}
+
+bool BridgeBench::waitUntil(const std::function<bool()> &condition, int timeoutMs)
+{
+    QEventLoop loop;
+    QTimer timer;
+    connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
+    timer.start(5);
+    QElapsedTimer clock;
+    clock.start();
+    while(!condition() && clock.elapsed() < timeoutMs)
+    {
+        loop.exec();
+    }
+    return condition();
+}
@@ -0,0 +1,88 @@
+#ifndef BRIDGEBENCH_H
+#define BRIDGEBENCH_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QJsonObject>
+#include <functional>
+
+class QTcpSocket;
+class QTimer;
+class SerialSender;
+class NetworkBridge;
+
+// 回环上的遥测客户端：按行统计收到的遥测，检查时间戳顺序
+class BenchClient : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BenchClient(QObject *parent = nullptr);
+
+    void connectTo(quint16 port);
+    //暂停读取：Qt只读1个字节就停，内核缓冲区满后服务端的积压开始增长
+    void setPaused(bool bPaused);
+    void sendLine(const QByteArray& line);
+    bool isConnected() const;
+
+    qint64 lines() const { return m_nLines; }
+    qint64 droppedFrames() const { return m_nDroppedFrames; }
+    int dropNotices() const { return m_nDropNotices; }
+    int orderErrors() const { return m_nOrderErrors; }
+    int busyReplies() const { return m_nBusy; }
+    int errorReplies() const { return m_nErrors; }
+    //统计配对到command的遥测行数，例如"#GETLPOS"
+    void setCommandTag(const QByteArray& command) { m_commandTag = command; }
+    qint64 taggedLines() const { return m_nTaggedLines; }
+
+private slots:
+    void onReadyRead();
+
+private:
+    void handleLine(const QByteArray& line);
+
+private:
+    QTcpSocket* m_socket;
+    QByteArray m_buffer;
+    bool m_bPaused = false;
+    qint64 m_nLines = 0;
+    qint64 m_nDroppedFrames = 0;
+    int m_nDropNotices = 0;
+    int m_nOrderErrors = 0;
+    int m_nBusy = 0;
+    int m_nErrors = 0;
+    qint64 m_nLastTimestampUs = 0;
+    QByteArray m_commandTag;
+    qint64 m_nTaggedLines = 0;
+};
+
+// 网络桥回环测试：SerialSender连接进程内的模拟控制器（LOOPBACK端口），按应答轮询#GETJPOS产生遥测，
+// 先测没有客户端时的帧率，再接入若干快客户端和一个不读数据的慢客户端，
+// 检查快客户端收到全部遥测且顺序正确、慢客户端只丢自己的遥测、串口链路帧率不受影响
+class BridgeBench : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BridgeBench(QObject *parent = nullptr);
+
+    //有客户端漏帧、乱序或远程指令没有应答时结果中带"error"
+    QJsonObject run(int durationMs, int fastClients, int commandIntervalMs);
+
+private slots:
+    void onOpened();
+    void onSendCommand();
+
+private:
+    //轮询durationMs，停止轮询和网络桥指令后等待在途应答，返回这段时间放入遥测环的帧数
+    qint64 poll(int durationMs);
+    //运行事件循环直到condition成立或超时，超时返回false
+    bool waitUntil(const std::function<bool()>& condition, int timeoutMs);
+
+private:
+    SerialSender* m_sender;
+    NetworkBridge* m_bridge;
+    QTimer* m_commandTimer;
+    BenchClient* m_commandClient = nullptr;
+    bool m_bOpened = false;
+};
+
+#endif // BRIDGEBENCH_H
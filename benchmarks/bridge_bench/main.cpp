@@ -0,0 +1,43 @@
+// 网络桥回环测试：快客户端收到全部遥测，不读数据的慢客户端只丢自己的遥测，串口链路帧率不受影响
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QTextStream>
+#include "bridgebench.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Network bridge fan-out and backpressure test over loopback");
+    parser.addHelpOption();
+    QCommandLineOption durationOption("duration", "Polling time per phase in ms (default 2000).", "ms", "2000");
+    QCommandLineOption clientsOption("clients", "Fast telemetry clients (default 4).", "n", "4");
+    QCommandLineOption commandOption("command-interval", "Send #GETLPOS through the bridge every n ms, 0 to disable (default 10).", "ms", "10");
+    QCommandLineOption jsonOption("json", "Print results as JSON.");
+    parser.addOption(durationOption);
+    parser.addOption(clientsOption);
+    parser.addOption(commandOption);
+    parser.addOption(jsonOption);
+    parser.process(a);
+
+    BridgeBench bench;
+    QJsonObject result = bench.run(parser.value(durationOption).toInt(),
+                                   parser.value(clientsOption).toInt(),
+                                   parser.value(commandOption).toInt());
+
+    QTextStream out(stdout);
+    if(parser.isSet(jsonOption))
+    {
+        result["benchmark"] = QStringLiteral("bridge");
+        out << QJsonDocument(result).toJson();
+    }else{
+        const QStringList keys = result.keys();
+        for(int i = 0; i < keys.size(); ++i)
+        {
+            out << keys.at(i).leftJustified(24) << result[keys.at(i)].toVariant().toString() << endl;
+        }
+    }
+    return result.contains("error") ? 1 : 0;
+}
@@ -0,0 +1,14 @@
+QT       -= gui
+QT       += core
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = cmdencoder_bench
+
+# 被测的链路代码直接链接dummycore，core在顶层工程的构建目录下
+DUMMYCORE_BUILD = $$OUT_PWD/../../core
+include(../../dummycore.pri)
+
+SOURCES += \
+    main.cpp
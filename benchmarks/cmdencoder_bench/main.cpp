@@ -0,0 +1,164 @@
+// 指令编码微基准：原QMap/QString实现与CommandEncoder对比，输出每条指令耗时(ns)
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include "commandencoder.h"
+#include "binaryprotocol.h"
+
+// 原MainWidget::constructCmd的实现，仅保留用于对比
+class LegacyEncoder
+{
+public:
+    LegacyEncoder()
+    {
+        m_CmdMap.insert(STOP,QStringLiteral("!STOP"));
+        m_CmdMap.insert(START,QStringLiteral("!START"));
+        m_CmdMap.insert(HOME,QStringLiteral("!HOME"));
+        m_CmdMap.insert(CALIBRATION,QStringLiteral("!CALIBRATION"));
+        m_CmdMap.insert(RESET,QStringLiteral("!RESET"));
+        m_CmdMap.insert(DISABLE,QStringLiteral("!DISABLE"));
+        m_CmdMap.insert(GETJPOS,QStringLiteral("#GETJPOS"));
+        m_CmdMap.insert(GETLPOS,QStringLiteral("#GETLPOS"));
+        m_CmdMap.insert(CMDMODE,QStringLiteral("#CMDMODE"));
+        m_CmdMap.insert(MOVEJ,QStringLiteral("&"));
+        m_CmdMap.insert(MOVEL,QStringLiteral("@"));
+        m_CmdMap.insert(SETKP,QStringLiteral("#SET_DCE_KP"));
+        m_CmdMap.insert(SETKI,QStringLiteral("#SET_DCE_KI"));
+        m_CmdMap.insert(SETKD,QStringLiteral("#SET_DCE_KD"));
+    }
+
+    QByteArray constructCmd(CMD_TYPE cmd, const QStringList &paraList = QStringList())
+    {
+        QString strCmd = m_CmdMap.value(cmd);
+        if(cmd == MOVEJ || cmd == MOVEL)
+        {
+            for(int i = 0; i < paraList.size(); ++i)
+            {
+                strCmd += paraList.at(i);
+                if(i == paraList.size() - 1) break;
+                strCmd += ",";
+            }
+        }
+        strCmd += "\r\n";
+        return QByteArray(strCmd.toUtf8());
+    }
+
+private:
+    QMap<CMD_TYPE,QString> m_CmdMap;
+};
+
+static const int ITERATIONS = 200000;
+
+//增益指令经过两种协议编码再解码，都必须原样还原小数，返回不一致的个数
+static int checkGainRoundTrip(QTextStream& out)
+{
+    const CMD_TYPE cmds[3] = {SETKP, SETKI, SETKD};
+    const float gains[5] = {0.5f, 1.8f, 0.0125f, 12.75f, -0.3f};
+    char buf[CommandEncoder::MAX_CMD_SIZE];
+    int nFailed = 0;
+    for(int c = 0; c < 3; ++c)
+    {
+        for(int g = 0; g < 5; ++g)
+        {
+            float values[2] = {3, gains[g]};
+            RobotCommand ascii;
+            RobotCommand binary;
+            int nAscii = CommandEncoder::encodeAscii(cmds[c], values, 2, buf, sizeof(buf));
+            //去掉\r\n再解码
+            bool bAscii = nAscii > 2 && CommandEncoder::decodeAscii(buf, nAscii - 2, ascii);
+            int nBinary = BinaryProtocol::encode(cmds[c], values, 2, buf, sizeof(buf));
+            bool bBinary = nBinary > 0 && BinaryProtocol::decode(buf, nBinary, binary);
+            if(!bAscii || !bBinary || ascii.values[1] != gains[g] || binary.values[1] != gains[g]
+                    || binary.values[0] != values[0])
+            {
+                out << "roundtrip mismatch " << CommandEncoder::spec(cmds[c]).name << " " << gains[g]
+                    << ": ascii " << (bAscii ? ascii.values[1] : -1)
+                    << " binary " << (bBinary ? binary.values[1] : -1) << endl;
+                ++nFailed;
+            }
+        }
+    }
+    return nFailed;
+}
+
+//模拟示教时的一次关节步进：数值每次都在变化
+static void jogValues(int i, float* values)
+{
+    values[0] = 12.35f + (i % 100) * 0.01f;
+    values[1] = -74.21f;
+    values[2] = 179.88f - (i % 50) * 0.1f;
+    values[3] = 0.52f;
+    values[4] = -3.41f;
+    values[5] = 10.0f;
+    values[6] = 100.0f;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QTextStream out(stdout);
+    LegacyEncoder legacy;
+    QElapsedTimer timer;
+    float values[MAX_CMD_VALUES];
+    qint64 checksum = 0;
+
+    //原实现：浮点数先经过QString::number转成字符串参数，再拼接
+    timer.start();
+    for(int i = 0; i < ITERATIONS; ++i)
+    {
+        jogValues(i, values);
+        QStringList paraList;
+        for(int j = 0; j < 7; ++j)
+        {
+            paraList << QString::number(values[j]);
+        }
+        checksum += legacy.constructCmd(MOVEJ, paraList).size();
+    }
+    double legacyMoveNs = double(timer.nsecsElapsed()) / ITERATIONS;
+
+    timer.restart();
+    for(int i = 0; i < ITERATIONS; ++i)
+    {
+        checksum += legacy.constructCmd(GETLPOS).size();
+    }
+    double legacyQueryNs = double(timer.nsecsElapsed()) / ITERATIONS;
+
+    //新实现：直接写入栈上缓冲区
+    char buf[CommandEncoder::MAX_CMD_SIZE];
+    timer.restart();
+    for(int i = 0; i < ITERATIONS; ++i)
+    {
+        jogValues(i, values);
+        checksum += CommandEncoder::encodeAscii(MOVEJ, values, 7, buf, sizeof(buf));
+    }
+    double encoderMoveNs = double(timer.nsecsElapsed()) / ITERATIONS;
+
+    timer.restart();
+    for(int i = 0; i < ITERATIONS; ++i)
+    {
+        checksum += CommandEncoder::encodeAscii(GETLPOS, nullptr, 0, buf, sizeof(buf));
+    }
+    double encoderQueryNs = double(timer.nsecsElapsed()) / ITERATIONS;
+
+    timer.restart();
+    for(int i = 0; i < ITERATIONS; ++i)
+    {
+        jogValues(i, values);
+        checksum += CommandEncoder::encode(PROTOCOL_BINARY, MOVEJ, values, 7, buf, sizeof(buf));
+    }
+    double binaryMoveNs = double(timer.nsecsElapsed()) / ITERATIONS;
+
+    out << "iterations " << ITERATIONS << " (checksum " << checksum << ")" << endl;
+    out << "MOVEJ   legacy  " << legacyMoveNs << " ns/cmd" << endl;
+    out << "MOVEJ   encoder " << encoderMoveNs << " ns/cmd" << endl;
+    out << "MOVEJ   binary  " << binaryMoveNs << " ns/cmd" << endl;
+    out << "GETLPOS legacy  " << legacyQueryNs << " ns/cmd" << endl;
+    out << "GETLPOS encoder " << encoderQueryNs << " ns/cmd" << endl;
+
+    int nFailed = checkGainRoundTrip(out);
+    out << (nFailed == 0 ? "roundtrip passed" : "roundtrip FAILED") << endl;
+    return nFailed == 0 ? 0 : 1;
+}
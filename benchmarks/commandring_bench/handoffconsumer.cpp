@@ -0,0 +1,60 @@
+#include "handoffconsumer.h"
+#include "monotonicclock.h"
+#include <cstring>
+
+HandoffConsumer::HandoffConsumer(CommandRing *ring, QObject *parent)
+    : QObject(parent)
+    , m_ring(ring)
+{
+}
+
+void HandoffConsumer::expect(int count)
+{
+    m_nExpected = count;
+    m_nReceived = 0;
+    m_nBatches = 0;
+    m_nBatchedCommands = 0;
+    m_latency.reset();
+}
+
+double HandoffConsumer::meanBatch() const
+{
+    return m_nBatches ? double(m_nBatchedCommands) / m_nBatches : 0;
+}
+
+void HandoffConsumer::onWrite(const QByteArray &data)
+{
+    ++m_nBatches;
+    ++m_nBatchedCommands;
+    consume(data.constData(), data.size());
+}
+
+void HandoffConsumer::onDrain()
+{
+    m_ring->clearPending();
+    int nSize = 0;
+    const char* data = m_ring->front(nSize);
+    if(!data)
+    {
+        return;
+    }
+    ++m_nBatches;
+    do
+    {
+        ++m_nBatchedCommands;
+        consume(data, nSize);
+        m_ring->pop();
+    }while((data = m_ring->front(nSize)) != nullptr);
+}
+
+void HandoffConsumer::consume(const char *data, int size)
+{
+    qint64 sentNs;
+    memcpy(&sentNs, data, sizeof(sentNs));
+    m_latency.record(monotonicNs() - sentNs);
+    m_nChecksum += quint64(size) + quint8(data[size - 1]);
+    if(++m_nReceived == m_nExpected)
+    {
+        m_done.release();
+    }
+}
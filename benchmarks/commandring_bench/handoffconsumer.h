@@ -0,0 +1,57 @@
+#ifndef HANDOFFCONSUMER_H
+#define HANDOFFCONSUMER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QSemaphore>
+#include "commandring.h"
+#include "linkstats.h"
+
+// 模拟串口线程的接收端：两种方式收到的指令都按同样的方式处理
+// 指令前8个字节是发送时的单调时钟，收到时记录交接延迟(ns)
+class HandoffConsumer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit HandoffConsumer(CommandRing* ring, QObject *parent = nullptr);
+
+    //在发送之前调用，收到count条后释放done
+    void expect(int count);
+    QSemaphore& done() { return m_done; }
+    const LatencyHistogram& latency() const { return m_latency; }
+    quint64 checksum() const { return m_nChecksum; }
+    //取出一批的平均条数，衡量唤醒合并的效果
+    double meanBatch() const;
+
+public slots:
+    //原实现：每条指令一次跨线程信号
+    void onWrite(const QByteArray& data);
+    //环形队列：一次唤醒取出全部
+    void onDrain();
+
+private:
+    void consume(const char* data, int size);
+
+private:
+    CommandRing* m_ring;
+    QSemaphore m_done;
+    LatencyHistogram m_latency;
+    int m_nExpected = 0;
+    int m_nReceived = 0;
+    quint64 m_nChecksum = 0;
+    quint64 m_nBatches = 0;
+    quint64 m_nBatchedCommands = 0;
+};
+
+// 原SerialSender的发送方式：每条指令构造QByteArray，经排队连接交给串口线程
+class QueuedProducer : public QObject
+{
+    Q_OBJECT
+public:
+    void send(const char* data, int size) { emit signalWrite(QByteArray(data, size)); }
+
+signals:
+    void signalWrite(const QByteArray& data);
+};
+
+#endif // HANDOFFCONSUMER_H
@@ -0,0 +1,200 @@
+// 发送通道微基准：原来每条指令一次排队信号，与CommandRing加合并唤醒对比
+// 生产者在主线程，消费者在带事件循环的工作线程，和界面线程到串口线程的结构一致
+// 吞吐：连续发送，测每条指令的平均耗时；延迟：按固定间隔发送，测从发送到串口线程取出的时间
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaObject>
+#include <QTextStream>
+#include <QThread>
+#include <cstring>
+#include "handoffconsumer.h"
+#include "commandencoder.h"
+#include "monotonicclock.h"
+
+enum HANDOFF_MODE
+{
+    MODE_QUEUED,
+    MODE_RING
+};
+
+//典型的点动指令，前8个字节换成发送时刻
+static int buildCommand(char* buf, int size)
+{
+    const float values[7] = {-123.4567f, 45.6789f, 178.1234f, -12.3456f, 67.8912f, -170.0123f, 100};
+    return CommandEncoder::encodeAscii(MOVEJ, values, 7, buf, size);
+}
+
+static void stamp(char* buf)
+{
+    qint64 nowNs = monotonicNs();
+    memcpy(buf, &nowNs, sizeof(nowNs));
+}
+
+static void send(HANDOFF_MODE mode, QueuedProducer& producer, CommandRing& ring,
+                 HandoffConsumer& consumer, const char* buf, int size)
+{
+    if(mode == MODE_QUEUED)
+    {
+        producer.send(buf, size);
+        return;
+    }
+    //队列满时等串口线程取走，吞吐测试中会出现
+    while(!ring.push(buf, size))
+    {
+        QThread::yieldCurrentThread();
+    }
+    if(ring.markPending())
+    {
+        QMetaObject::invokeMethod(&consumer, "onDrain", Qt::QueuedConnection);
+    }
+}
+
+static QJsonObject latencyStats(const LatencyHistogram& histogram)
+{
+    QJsonObject stats;
+    stats["p50"] = double(histogram.percentile(0.5));
+    stats["p99"] = double(histogram.percentile(0.99));
+    stats["p999"] = double(histogram.percentile(0.999));
+    stats["max"] = double(histogram.max());
+    stats["mean"] = histogram.mean();
+    return stats;
+}
+
+static QJsonObject runThroughput(HANDOFF_MODE mode, QueuedProducer& producer, CommandRing& ring,
+                                 HandoffConsumer& consumer, int samples)
+{
+    char buf[CommandEncoder::MAX_CMD_SIZE];
+    int nSize = buildCommand(buf, sizeof(buf));
+
+    consumer.expect(samples);
+    qint64 startNs = monotonicNs();
+    for(int i = 0; i < samples; ++i)
+    {
+        stamp(buf);
+        send(mode, producer, ring, consumer, buf, nSize);
+    }
+    qint64 producerNs = monotonicNs() - startNs;
+    consumer.done().acquire();
+    qint64 totalNs = monotonicNs() - startNs;
+
+    QJsonObject result;
+    result["test"] = "throughput";
+    result["samples"] = samples;
+    result["producer_ns_per_cmd"] = double(producerNs) / samples;
+    result["total_ns_per_cmd"] = double(totalNs) / samples;
+    result["commands_per_wakeup"] = consumer.meanBatch();
+    result["handoff_ns"] = latencyStats(consumer.latency());
+    return result;
+}
+
+static QJsonObject runLatency(HANDOFF_MODE mode, QueuedProducer& producer, CommandRing& ring,
+                              HandoffConsumer& consumer, int samples, int gapUs)
+{
+    char buf[CommandEncoder::MAX_CMD_SIZE];
+    int nSize = buildCommand(buf, sizeof(buf));
+
+    consumer.expect(samples);
+    qint64 nextNs = monotonicNs();
+    for(int i = 0; i < samples; ++i)
+    {
+        //忙等到下一个发送时刻，sleep的粒度比交接延迟还大
+        while(monotonicNs() < nextNs)
+        {
+        }
+        stamp(buf);
+        send(mode, producer, ring, consumer, buf, nSize);
+        nextNs += qint64(gapUs) * 1000;
+    }
+    consumer.done().acquire();
+
+    QJsonObject result;
+    result["test"] = "latency";
+    result["samples"] = samples;
+    result["gap_us"] = gapUs;
+    result["commands_per_wakeup"] = consumer.meanBatch();
+    result["handoff_ns"] = latencyStats(consumer.latency());
+    return result;
+}
+
+static void printResult(QTextStream& out, const QString& mode, const QJsonObject& result)
+{
+    out << mode.leftJustified(7) << result["test"].toString().leftJustified(11)
+        << "samples " << result["samples"].toInt();
+    if(result.contains("producer_ns_per_cmd"))
+    {
+        out << "  producer " << result["producer_ns_per_cmd"].toDouble() << " ns/cmd"
+            << "  total " << result["total_ns_per_cmd"].toDouble() << " ns/cmd";
+    }else{
+        out << "  gap " << result["gap_us"].toInt() << " us";
+    }
+    out << "  batch " << result["commands_per_wakeup"].toDouble() << endl;
+    QJsonObject handoff = result["handoff_ns"].toObject();
+    out << "    handoff p50 " << handoff["p50"].toDouble()
+        << "  p99 " << handoff["p99"].toDouble()
+        << "  p99.9 " << handoff["p999"].toDouble()
+        << "  max " << handoff["max"].toDouble() << " ns" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Queued signal vs lock-free ring handoff to the serial thread");
+    parser.addHelpOption();
+    QCommandLineOption samplesOption("samples", "Commands in the throughput test (default 200000).", "n", "200000");
+    QCommandLineOption latencySamplesOption("latency-samples", "Commands in the latency test (default 20000).", "n", "20000");
+    QCommandLineOption gapOption("gap", "Interval between commands in the latency test in us (default 200).", "us", "200");
+    QCommandLineOption jsonOption("json", "Print results as JSON.");
+    parser.addOption(samplesOption);
+    parser.addOption(latencySamplesOption);
+    parser.addOption(gapOption);
+    parser.addOption(jsonOption);
+    parser.process(a);
+
+    int nSamples = parser.value(samplesOption).toInt();
+    int nLatencySamples = parser.value(latencySamplesOption).toInt();
+    int nGapUs = parser.value(gapOption).toInt();
+
+    CommandRing ring;
+    QueuedProducer producer;
+    HandoffConsumer consumer(&ring);
+    QThread thread;
+    consumer.moveToThread(&thread);
+    QObject::connect(&producer, SIGNAL(signalWrite(const QByteArray&)), &consumer, SLOT(onWrite(const QByteArray&)),
+                     Qt::QueuedConnection);
+    thread.start();
+
+    QJsonArray results;
+    QTextStream out(stdout);
+    const HANDOFF_MODE modes[2] = {MODE_QUEUED, MODE_RING};
+    const char* names[2] = {"queued", "ring"};
+    for(int i = 0; i < 2; ++i)
+    {
+        QJsonObject throughput = runThroughput(modes[i], producer, ring, consumer, nSamples);
+        QJsonObject latency = runLatency(modes[i], producer, ring, consumer, nLatencySamples, nGapUs);
+        throughput["mode"] = names[i];
+        latency["mode"] = names[i];
+        results.append(throughput);
+        results.append(latency);
+        if(!parser.isSet(jsonOption))
+        {
+            printResult(out, names[i], throughput);
+            printResult(out, names[i], latency);
+        }
+    }
+
+    thread.quit();
+    thread.wait();
+
+    if(parser.isSet(jsonOption))
+    {
+        out << QJsonDocument(results).toJson();
+    }else{
+        out << "checksum " << consumer.checksum() << endl;
+    }
+    return 0;
+}
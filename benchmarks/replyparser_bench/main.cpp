@@ -0,0 +1,179 @@
+// 位姿应答解析微基准：原QString拆分、strtof与ReplyParser对比，输出每条应答耗时(ns)
+// 同时检查ReplyParser与strtof结果的差异，并用corpus目录中的种子做模糊测试
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "commandencoder.h"
+#include "replyparser.h"
+#include "replyfuzz.h"
+
+//不同的应答行数，循环使用，避免分支预测记住同一行
+static const int REPLY_COUNT = 1024;
+
+// 原MainWidget::onDataReceived中的解析方式，仅保留用于对比
+static int legacyParse(const QByteArray& data, float* values)
+{
+    QString strData = QString::fromLocal8Bit(data);
+    strData.remove("ok");
+    strData.replace("\r\n","");
+    QStringList posList = strData.split(" ");
+    posList.removeAt(0);
+    int nCount = 0;
+    for(int i = 0; i < posList.size() && nCount < 6; ++i)
+    {
+        values[nCount++] = posList.at(i).toFloat();
+    }
+    return nCount;
+}
+
+//模拟控制器的GETLPOS应答，数值每行都不同
+static QVector<QByteArray> makeReplies()
+{
+    QVector<QByteArray> replies;
+    char line[256];
+    for(int i = 0; i < REPLY_COUNT; ++i)
+    {
+        snprintf(line, sizeof(line), "ok %.2f %.2f %.2f %.2f %.2f %.2f\r\n",
+                 150.0 + (i % 100) * 0.37, -74.21 + (i % 7), 179.88 - (i % 50) * 0.1,
+                 0.52 * (i % 3), -3.41, 10.0 + (i % 360));
+        replies.append(QByteArray(line));
+    }
+    return replies;
+}
+
+//随机数值格式化后分别用strtof和ReplyParser解析，返回结果不同的个数，maxUlp为最大差异
+static int compareWithStrtof(int samples, quint32 seed, int& maxUlp)
+{
+    quint32 state = seed ? seed : 1;
+    char text[64];
+    int nDiffer = 0;
+    maxUlp = 0;
+    for(int i = 0; i < samples; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        //位模式随机的有限float，再加上示教常见的两位小数
+        float value;
+        quint32 bits = state;
+        memcpy(&value, &bits, sizeof(value));
+        if(!std::isfinite(value))
+        {
+            continue;
+        }
+        int nLength = (i & 1) ? snprintf(text, sizeof(text), "%.9g", double(value))
+                              : snprintf(text, sizeof(text), "%.2f", double(value) * 1e-30);
+
+        float expected = strtof(text, nullptr);
+        float parsed = 0;
+        if(ReplyParser::parseFloat(text, nLength, parsed) != nLength)
+        {
+            ++nDiffer;
+            maxUlp = INT_MAX;
+            continue;
+        }
+        qint32 a, b;
+        memcpy(&a, &expected, sizeof(a));
+        memcpy(&b, &parsed, sizeof(b));
+        int nUlp = std::abs(a - b);
+        if(nUlp != 0)
+        {
+            ++nDiffer;
+            maxUlp = qMax(maxUlp, nUlp);
+        }
+    }
+    return nDiffer;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Pose reply parsing: QString split vs strtof vs ReplyParser, plus fuzzing");
+    parser.addHelpOption();
+    QCommandLineOption samplesOption("samples", "Replies parsed per method (default 200000).", "n", "200000");
+    QCommandLineOption corpusOption("corpus", "Seed directory for fuzzing.", "dir", CORPUS_DIR);
+    QCommandLineOption fuzzOption("fuzz", "Mutated inputs to check (default 200000, 0 to skip).", "n", "200000");
+    QCommandLineOption seedOption("seed", "Random seed (default 1).", "n", "1");
+    parser.addOption(samplesOption);
+    parser.addOption(corpusOption);
+    parser.addOption(fuzzOption);
+    parser.addOption(seedOption);
+    parser.process(a);
+
+    int nSamples = parser.value(samplesOption).toInt();
+    int nFuzz = parser.value(fuzzOption).toInt();
+    quint32 nSeed = parser.value(seedOption).toUInt();
+    QString corpusPath = parser.value(corpusOption);
+
+    QTextStream out(stdout);
+    QVector<QByteArray> replies = makeReplies();
+    QElapsedTimer timer;
+    float values[7];
+    double checksum = 0;
+
+    timer.start();
+    for(int i = 0; i < nSamples; ++i)
+    {
+        const QByteArray& reply = replies.at(i % REPLY_COUNT);
+        if(legacyParse(reply, values) == 6)
+        {
+            checksum += values[5];
+        }
+    }
+    double legacyNs = double(timer.nsecsElapsed()) / nSamples;
+
+    //CommandEncoder::parseValues需要'\0'结尾并且不认识"ok"，和RobotState原来的用法一样从"ok"之后开始
+    timer.restart();
+    for(int i = 0; i < nSamples; ++i)
+    {
+        const QByteArray& reply = replies.at(i % REPLY_COUNT);
+        if(CommandEncoder::parseValues(reply.constData() + 2, values, 6) == 6)
+        {
+            checksum += values[5];
+        }
+    }
+    double strtofNs = double(timer.nsecsElapsed()) / nSamples;
+
+    timer.restart();
+    for(int i = 0; i < nSamples; ++i)
+    {
+        const QByteArray& reply = replies.at(i % REPLY_COUNT);
+        if(ReplyParser::parsePose(reply.constData(), reply.size(), values))
+        {
+            checksum += values[5];
+        }
+    }
+    double parserNs = double(timer.nsecsElapsed()) / nSamples;
+
+    out << "samples " << nSamples << " (checksum " << checksum << ")" << endl;
+    out << "GETLPOS legacy      " << legacyNs << " ns/reply" << endl;
+    out << "GETLPOS strtof      " << strtofNs << " ns/reply" << endl;
+    out << "GETLPOS replyparser " << parserNs << " ns/reply" << endl;
+
+    int nMaxUlp = 0;
+    int nDiffer = compareWithStrtof(nSamples, nSeed, nMaxUlp);
+    out << "strtof mismatches " << nDiffer << " / " << nSamples << " (max " << nMaxUlp << " ulp)" << endl;
+
+    int nFailed = 0;
+    int nFiles = 0;
+    nFailed += ReplyFuzz::checkCorpus(corpusPath, nFiles);
+    out << "corpus " << nFiles << " files" << endl;
+    if(nFuzz > 0)
+    {
+        nFailed += ReplyFuzz::mutate(corpusPath, nFuzz, nSeed);
+        out << "fuzz " << nFuzz << " inputs" << endl;
+    }
+    out << (nFailed == 0 ? "fuzz passed" : "fuzz FAILED") << endl;
+    return nFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#include "replyfuzz.h"
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include "commandencoder.h"
+#include "replyparser.h"
+
+//多取一个，检查不会越过maxCount
+static const int MAX_VALUES = 7;
+
+bool ReplyFuzz::check(const char *data, int size, QString *error)
+{
+    float values[MAX_VALUES + 1];
+    //哨兵，parseValues不能写到maxCount之外
+    values[MAX_VALUES] = 12345.0f;
+    int nCount = ReplyParser::parseValues(data, size, values, MAX_VALUES);
+    if(nCount < -1 || nCount > MAX_VALUES || values[MAX_VALUES] != 12345.0f)
+    {
+        if(error) *error = QString("count %1 out of range").arg(nCount);
+        return false;
+    }
+
+    float pose[6];
+    bool bPose = ReplyParser::parsePose(data, size, pose);
+    if(bPose != (nCount == 6))
+    {
+        if(error) *error = QString("parsePose %1 but count %2").arg(bPose).arg(nCount);
+        return false;
+    }
+
+    //格式化后加上"ok"和多余空白再解析，结果必须逐位相同
+    char text[MAX_VALUES * (CommandEncoder::MAX_FLOAT_SIZE + 2) + 8];
+    char* p = text;
+    memcpy(p, "ok ", 3);
+    p += 3;
+    for(int i = 0; i < nCount; ++i)
+    {
+        if(std::isnan(values[i]))
+        {
+            if(error) *error = QString("value %1 is NaN").arg(i);
+            return false;
+        }
+        if(std::isinf(values[i]) || values[i] == 0)
+        {
+            //formatFloat把无穷和-0都写成0
+            values[i] = 0;
+        }
+        p += CommandEncoder::formatFloat(values[i], p);
+        *p++ = ' ';
+        *p++ = ' ';
+    }
+    memcpy(p, "ok\r\n", 4);
+    p += 4;
+
+    float again[MAX_VALUES];
+    int nAgain = ReplyParser::parseValues(text, int(p - text), again, MAX_VALUES);
+    if(nCount >= 0 && nAgain != nCount)
+    {
+        if(error) *error = QString("round trip count %1 != %2").arg(nAgain).arg(nCount);
+        return false;
+    }
+    for(int i = 0; i < nCount; ++i)
+    {
+        if(memcmp(&again[i], &values[i], sizeof(float)) != 0)
+        {
+            if(error) *error = QString("round trip value %1: %2 != %3")
+                    .arg(i).arg(double(again[i]), 0, 'g', 9).arg(double(values[i]), 0, 'g', 9);
+            return false;
+        }
+    }
+    return true;
+}
+
+//每个种子放进恰好大小的堆内存，越界读取能被内存检查工具发现
+static bool checkExact(const QByteArray& input, QString* error)
+{
+    char* data = new char[input.size() > 0 ? input.size() : 1];
+    memcpy(data, input.constData(), input.size());
+    bool bOk = ReplyFuzz::check(data, input.size(), error);
+    delete[] data;
+    return bOk;
+}
+
+static QVector<QByteArray> loadCorpus(const QString& dirPath)
+{
+    QVector<QByteArray> seeds;
+    QDir dir(dirPath);
+    QStringList fileNames = dir.entryList(QDir::Files, QDir::Name);
+    for(int i = 0; i < fileNames.size(); ++i)
+    {
+        QFile file(dir.filePath(fileNames.at(i)));
+        if(file.open(QIODevice::ReadOnly))
+        {
+            seeds.append(file.readAll());
+        }
+    }
+    return seeds;
+}
+
+int ReplyFuzz::checkCorpus(const QString &dirPath, int &nFiles)
+{
+    QTextStream err(stderr);
+    QDir dir(dirPath);
+    QStringList fileNames = dir.entryList(QDir::Files, QDir::Name);
+    nFiles = fileNames.size();
+    int nFailed = 0;
+    for(int i = 0; i < fileNames.size(); ++i)
+    {
+        QFile file(dir.filePath(fileNames.at(i)));
+        if(!file.open(QIODevice::ReadOnly))
+        {
+            continue;
+        }
+        QString error;
+        if(!checkExact(file.readAll(), &error))
+        {
+            err << fileNames.at(i) << ": " << error << endl;
+            ++nFailed;
+        }
+    }
+    return nFailed;
+}
+
+int ReplyFuzz::mutate(const QString &dirPath, int iterations, quint32 seed)
+{
+    //变异时插入的片段，覆盖数值语法的各个分支
+    static const char* const s_tokens[] = {
+        "ok", "OK", " ", "\t", ",", "\r\n", "-", "+", ".", "e", "E-", "e+",
+        "0", "9", "1e38", "1e39", "1e-46", "123456789012345678901", ".5", "5.", "okk", "x"
+    };
+    static const int TOKEN_COUNT = sizeof(s_tokens) / sizeof(s_tokens[0]);
+
+    QTextStream err(stderr);
+    QVector<QByteArray> seeds = loadCorpus(dirPath);
+    if(seeds.isEmpty())
+    {
+        seeds.append(QByteArray("ok 0 0 0 0 0 0"));
+    }
+
+    quint32 state = seed ? seed : 1;
+    auto next = [&state]() {
+        //xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    };
+
+    int nFailed = 0;
+    for(int n = 0; n < iterations; ++n)
+    {
+        QByteArray input = seeds.at(int(next() % quint32(seeds.size())));
+        int nMutations = 1 + int(next() % 4);
+        for(int m = 0; m < nMutations; ++m)
+        {
+            int nPos = input.isEmpty() ? 0 : int(next() % quint32(input.size() + 1));
+            switch(next() % 4)
+            {
+            case 0:
+                if(nPos < input.size())
+                {
+                    input[nPos] = char(next() & 0xFF);
+                }
+                break;
+            case 1:
+                input.insert(nPos, s_tokens[next() % TOKEN_COUNT]);
+                break;
+            case 2:
+                input.remove(nPos, 1 + int(next() % 4));
+                break;
+            default:
+                input.truncate(nPos);
+                break;
+            }
+        }
+
+        QString error;
+        if(!checkExact(input, &error))
+        {
+            err << "mutation " << n << " \"" << input.toPercentEncoding(" ,.-+") << "\": " << error << endl;
+            if(++nFailed >= 10)
+            {
+                break;
+            }
+        }
+    }
+    return nFailed;
+}
+
+#ifdef REPLYPARSER_LIBFUZZER
+//clang -fsanitize=fuzzer构建时的入口，失败直接中止让libFuzzer保存用例
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    if(size > 4096)
+    {
+        return 0;
+    }
+    if(!ReplyFuzz::check(reinterpret_cast<const char*>(data), int(size)))
+    {
+        abort();
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,23 @@
+#ifndef REPLYFUZZ_H
+#define REPLYFUZZ_H
+
+#include <QString>
+
+// ReplyParser的模糊测试检查，同一套检查既用于libFuzzer入口，也用于基准程序自带的变异测试
+class ReplyFuzz
+{
+public:
+    //对一段输入检查解析器的不变量，失败时返回false并把原因写入error
+    // 1. 返回个数在[-1, maxCount]之间，parsePose与parseValues结果一致
+    // 2. 解出的数值不是NaN
+    // 3. 有限数值经formatFloat格式化后再解析得到完全相同的float
+    static bool check(const char* data, int size, QString* error = nullptr);
+
+    //读取corpus目录下的所有种子逐个检查，返回失败个数
+    static int checkCorpus(const QString& dirPath, int& nFiles);
+
+    //以corpus中的种子为基础随机变异iterations次，返回失败个数
+    static int mutate(const QString& dirPath, int iterations, quint32 seed);
+};
+
+#endif // REPLYFUZZ_H
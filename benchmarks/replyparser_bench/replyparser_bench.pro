@@ -0,0 +1,35 @@
+QT       -= gui
+QT       += core
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = replyparser_bench
+
+DEFINES += CORPUS_DIR=\\\"$$PWD/corpus\\\"
+
+SOURCES += \
+    main.cpp \
+    replyfuzz.cpp
+
+HEADERS += \
+    replyfuzz.h
+
+# qmake CONFIG+=libfuzzer 用clang构建libFuzzer版本，直接以corpus目录为种子运行
+# 被测代码要插桩，直接编译源文件，不链接dummycore
+libfuzzer {
+    TARGET = replyparser_fuzz
+    SOURCES -= main.cpp
+    DEFINES += REPLYPARSER_LIBFUZZER
+    QMAKE_CXXFLAGS += -fsanitize=fuzzer,address
+    QMAKE_LFLAGS += -fsanitize=fuzzer,address
+
+    INCLUDEPATH += ../..
+    SOURCES += \
+        ../../binaryprotocol.cpp \
+        ../../commandencoder.cpp \
+        ../../replyparser.cpp
+} else {
+    DUMMYCORE_BUILD = $$OUT_PWD/../../core
+    include(../../dummycore.pri)
+}
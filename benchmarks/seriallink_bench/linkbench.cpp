@@ -0,0 +1,296 @@
+#include "linkbench.h"
+#include "commandencoder.h"
+#include "monotonicclock.h"
+#include <QTimer>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+//打开串口和等待应答的超时
+#define OPEN_TIMEOUT_MS 3000
+#define REPLY_TIMEOUT_MS 1000
+
+SimulatorThread::SimulatorThread(const SimulatorOptions &options, QObject *parent)
+    : QThread(parent), m_options(options)
+{
+
+}
+
+SimulatorThread::~SimulatorThread()
+{
+    quit();
+    wait();
+}
+
+QString SimulatorThread::startSimulator()
+{
+    start();
+    m_ready.acquire();
+    return m_strSlaveName;
+}
+
+void SimulatorThread::run()
+{
+    PtySimulator simulator(m_options);
+    bool bOpened = simulator.open();
+    if(bOpened)
+    {
+        m_strSlaveName = simulator.slaveName();
+    }
+    m_ready.release();
+    if(bOpened)
+    {
+        exec();
+    }
+}
+
+LinkBench::LinkBench(QObject *parent) : QObject(parent)
+{
+    m_sender = new SerialSender(this);
+    connect(m_sender, SIGNAL(signalFrameReceived(ResponseFrame)), this, SLOT(onFrameReceived(ResponseFrame)));
+    connect(m_sender, SIGNAL(signalOpened()), this, SLOT(onOpened()));
+    connect(m_sender, SIGNAL(signalClosed()), this, SLOT(onClosed()));
+}
+
+QJsonObject LinkBench::measureRoundTrip(int baudRate, int samples)
+{
+    QJsonObject result;
+    result["test"] = QStringLiteral("roundtrip_getlpos");
+    result["baud"] = baudRate;
+    if(!connectLink(baudRate))
+    {
+        result["error"] = QStringLiteral("failed to open link");
+        return result;
+    }
+
+    char buf[CommandEncoder::MAX_CMD_SIZE];
+    int nSize = CommandEncoder::encodeAscii(GETLPOS, nullptr, 0, buf, sizeof(buf));
+    m_command = QByteArray(buf, nSize);
+    m_mode = MODE_ROUND_TRIP;
+    m_nTarget = samples;
+    m_nWindow = 1;
+    m_nSent = 0;
+    m_nReceived = 0;
+    m_bFinished = false;
+    m_sendNs.clear();
+    m_roundTripNs.clear();
+    m_arrivalNs.clear();
+
+    sendCommand();
+    bool bDone = waitFor(m_bFinished, samples * REPLY_TIMEOUT_MS);
+    m_mode = MODE_IDLE;
+    disconnectLink();
+
+    result["samples"] = m_nReceived;
+    if(!bDone)
+    {
+        result["error"] = QStringLiteral("timeout");
+    }
+    //发出到串口线程读到应答，和再经过信号回到界面线程的部分分开统计
+    QVector<qint64> returnHopNs(m_roundTripNs.size());
+    for(int i = 0; i < m_roundTripNs.size(); ++i)
+    {
+        returnHopNs[i] = m_roundTripNs.at(i) - m_arrivalNs.at(i);
+    }
+    result["rtt_us"] = percentiles(m_roundTripNs);
+    result["serial_thread_us"] = percentiles(m_arrivalNs);
+    result["return_hop_us"] = percentiles(returnHopNs);
+    return result;
+}
+
+QJsonObject LinkBench::measureThroughput(int baudRate, const float *values, int samples, int window)
+{
+    char buf[CommandEncoder::MAX_CMD_SIZE];
+    int nSize = CommandEncoder::encodeAscii(MOVEJ, values, 7, buf, sizeof(buf));
+
+    QJsonObject result;
+    result["test"] = QStringLiteral("throughput_movej");
+    result["baud"] = baudRate;
+    result["window"] = window;
+    result["payload_bytes"] = nSize;
+    if(!connectLink(baudRate))
+    {
+        result["error"] = QStringLiteral("failed to open link");
+        return result;
+    }
+
+    m_command = QByteArray(buf, nSize);
+    m_mode = MODE_THROUGHPUT;
+    m_nTarget = samples;
+    m_nWindow = qMax(1, window);
+    m_nSent = 0;
+    m_nReceived = 0;
+    m_bFinished = false;
+    m_sendNs.clear();
+    m_roundTripNs.clear();
+    m_arrivalNs.clear();
+
+    qint64 startNs = monotonicNs();
+    while(m_nSent < m_nTarget && m_nSent < m_nWindow)
+    {
+        sendCommand();
+    }
+    bool bDone = waitFor(m_bFinished, samples * REPLY_TIMEOUT_MS);
+    qint64 elapsedNs = monotonicNs() - startNs;
+    m_mode = MODE_IDLE;
+    disconnectLink();
+
+    result["samples"] = m_nReceived;
+    if(!bDone)
+    {
+        result["error"] = QStringLiteral("timeout");
+    }
+    double seconds = elapsedNs / 1e9;
+    result["commands_per_s"] = (seconds > 0) ? m_nReceived / seconds : 0.0;
+    result["rtt_us"] = percentiles(m_roundTripNs);
+    return result;
+}
+
+void LinkBench::onFrameReceived(const ResponseFrame &frame)
+{
+    qint64 nowNs = monotonicNs();
+    if(m_mode == MODE_IDLE || m_nReceived >= m_sendNs.size())
+    {
+        return;
+    }
+    //位姿查询等位姿应答，运动指令等ok或错误
+    bool bExpected = (m_mode == MODE_ROUND_TRIP) ? (frame.type == FRAME_POSITION)
+                                                 : (frame.type == FRAME_OK || frame.type == FRAME_ERROR);
+    if(!bExpected)
+    {
+        return;
+    }
+
+    qint64 sendNs = m_sendNs.at(m_nReceived);
+    m_roundTripNs.append(nowNs - sendNs);
+    m_arrivalNs.append(frame.timestampNs - sendNs);
+    ++m_nReceived;
+    if(m_nReceived >= m_nTarget)
+    {
+        finish();
+        return;
+    }
+    while(m_nSent < m_nTarget && m_nSent - m_nReceived < m_nWindow)
+    {
+        sendCommand();
+    }
+}
+
+void LinkBench::onOpened()
+{
+    m_bOpened = true;
+    if(m_loop)
+    {
+        m_loop->quit();
+    }
+}
+
+void LinkBench::onClosed()
+{
+    m_bOpened = false;
+    m_bClosed = true;
+    if(m_loop)
+    {
+        m_loop->quit();
+    }
+}
+
+bool LinkBench::connectLink(int baudRate)
+{
+    SimulatorOptions options;
+    options.baudRate = baudRate;
+    for(int i = 0; i <= SETKD; ++i)
+    {
+        options.latencyUs[i] = m_nLatencyUs;
+    }
+    m_simulator = new SimulatorThread(options);
+    QString slaveName = m_simulator->startSimulator();
+    if(slaveName.isEmpty())
+    {
+        delete m_simulator;
+        m_simulator = nullptr;
+        return false;
+    }
+
+    //伪终端不关心波特率，限速由模拟器完成
+    m_sender->open(slaveName, (baudRate > 0) ? baudRate : 115200);
+    if(!waitFor(m_bOpened, OPEN_TIMEOUT_MS))
+    {
+        qDebug() << "failed to open" << slaveName;
+        disconnectLink();
+        return false;
+    }
+    return true;
+}
+
+void LinkBench::disconnectLink()
+{
+    //先关串口再关模拟器，避免串口线程读到挂断
+    if(m_bOpened)
+    {
+        m_bClosed = false;
+        m_sender->close();
+        waitFor(m_bClosed, OPEN_TIMEOUT_MS);
+    }
+    delete m_simulator;
+    m_simulator = nullptr;
+}
+
+bool LinkBench::waitFor(const bool &condition, int timeoutMs)
+{
+    QEventLoop loop;
+    QTimer timer;
+    timer.setSingleShot(true);
+    connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+    timer.start(timeoutMs);
+    m_loop = &loop;
+    while(!condition && timer.isActive())
+    {
+        loop.exec();
+    }
+    m_loop = nullptr;
+    return condition;
+}
+
+void LinkBench::sendCommand()
+{
+    m_sendNs.append(monotonicNs());
+    m_sender->sendDatas(m_command);
+    ++m_nSent;
+}
+
+void LinkBench::finish()
+{
+    m_bFinished = true;
+    if(m_loop)
+    {
+        m_loop->quit();
+    }
+}
+
+QJsonObject LinkBench::percentiles(QVector<qint64> &samplesNs)
+{
+    QJsonObject result;
+    if(samplesNs.isEmpty())
+    {
+        return result;
+    }
+    std::sort(samplesNs.begin(), samplesNs.end());
+    int nCount = samplesNs.size();
+    //第p百分位取排序后第ceil(p * n)个
+    auto at = [&](double p) {
+        int nIndex = qBound(0, static_cast<int>(std::ceil(p * nCount)) - 1, nCount - 1);
+        return samplesNs.at(nIndex) / 1000.0;
+    };
+    double sum = 0;
+    for(int i = 0; i < nCount; ++i)
+    {
+        sum += samplesNs.at(i);
+    }
+    result["p50"] = at(0.50);
+    result["p99"] = at(0.99);
+    result["p999"] = at(0.999);
+    result["max"] = samplesNs.last() / 1000.0;
+    result["mean"] = sum / nCount / 1000.0;
+    return result;
+}
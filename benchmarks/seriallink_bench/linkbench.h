@@ -0,0 +1,93 @@
+#ifndef LINKBENCH_H
+#define LINKBENCH_H
+
+#include <QObject>
+#include <QThread>
+#include <QSemaphore>
+#include <QEventLoop>
+#include <QJsonObject>
+#include <QVector>
+#include "serialsender.h"
+#include "ptysimulator.h"
+
+// 在独立线程里运行的伪终端模拟器，每个测试场景新建一个
+class SimulatorThread : public QThread
+{
+public:
+    explicit SimulatorThread(const SimulatorOptions& options, QObject *parent = nullptr);
+    ~SimulatorThread();
+
+    //启动线程并等待伪终端创建完成，返回从端设备名，失败返回空
+    QString startSimulator();
+
+protected:
+    void run() override;
+
+private:
+    SimulatorOptions m_options;
+    QString m_strSlaveName;
+    QSemaphore m_ready;
+};
+
+// 通过真实的SerialSender连接模拟器，测量往返延迟和指令吞吐
+// 时间都从界面线程（本对象所在线程）调用sendDatas的时刻算起，包含交给串口线程的开销
+class LinkBench : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LinkBench(QObject *parent = nullptr);
+
+    //控制器处理每条指令的时间，微秒
+    void setControllerLatency(int latencyUs) { m_nLatencyUs = latencyUs; }
+
+    //一问一答：收到位姿应答后再发下一条#GETLPOS
+    QJsonObject measureRoundTrip(int baudRate, int samples);
+
+    //连续发MOVEJ，最多window条未确认
+    QJsonObject measureThroughput(int baudRate, const float* values, int samples, int window);
+
+private slots:
+    void onFrameReceived(const ResponseFrame& frame);
+    void onOpened();
+    void onClosed();
+
+private:
+    typedef enum BenchMode
+    {
+        MODE_IDLE,
+        MODE_ROUND_TRIP,
+        MODE_THROUGHPUT
+    }BENCH_MODE;
+
+    bool connectLink(int baudRate);
+    void disconnectLink();
+    //运行事件循环直到condition成立或超时，超时返回false
+    bool waitFor(const bool& condition, int timeoutMs);
+    void sendCommand();
+    void finish();
+
+    //按百分位统计，单位微秒
+    static QJsonObject percentiles(QVector<qint64>& samplesNs);
+
+private:
+    SerialSender* m_sender;
+    SimulatorThread* m_simulator = nullptr;
+    QEventLoop* m_loop = nullptr;
+    int m_nLatencyUs = 0;
+    bool m_bOpened = false;
+    bool m_bClosed = false;
+
+    BENCH_MODE m_mode = MODE_IDLE;
+    QByteArray m_command;
+    int m_nTarget = 0;
+    int m_nSent = 0;
+    int m_nReceived = 0;
+    int m_nWindow = 1;
+    bool m_bFinished = false;
+    //每条指令的发送时刻，按应答顺序一一对应
+    QVector<qint64> m_sendNs;
+    QVector<qint64> m_roundTripNs;  //界面线程发出到界面线程收到
+    QVector<qint64> m_arrivalNs;    //界面线程发出到串口线程读到
+};
+
+#endif // LINKBENCH_H
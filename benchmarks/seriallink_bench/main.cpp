@@ -0,0 +1,106 @@
+// 串口链路端到端基准：真实的SerialSender连接进程内的伪终端模拟器
+// 输出#GETLPOS往返延迟的p50/p99/p99.9和MOVEJ吞吐，--json输出机器可读的结果便于跟踪回归
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTextStream>
+#include "linkbench.h"
+
+//短参数和长参数两种MOVEJ，最后一个为速度
+static const float SHORT_VALUES[7] = {0, 0, 90, 0, 0, 0, 100};
+static const float LONG_VALUES[7] = {-123.4567f, 45.6789f, 178.1234f, -12.3456f, 67.8912f, -170.0123f, 100};
+
+static void printStats(QTextStream& out, const QString& name, const QJsonObject& stats)
+{
+    out << "    " << name.leftJustified(18)
+        << " p50 " << stats["p50"].toDouble()
+        << "  p99 " << stats["p99"].toDouble()
+        << "  p99.9 " << stats["p999"].toDouble()
+        << "  max " << stats["max"].toDouble() << " us" << endl;
+}
+
+static void printResult(QTextStream& out, const QJsonObject& result)
+{
+    out << result["test"].toString() << " baud " << result["baud"].toInt();
+    if(result.contains("window"))
+    {
+        out << " window " << result["window"].toInt()
+            << " payload " << result["payload_bytes"].toInt() << " B";
+    }
+    out << " samples " << result["samples"].toInt();
+    if(result.contains("error"))
+    {
+        out << " ERROR " << result["error"].toString();
+    }
+    out << endl;
+    if(result.contains("commands_per_s"))
+    {
+        out << "    " << result["commands_per_s"].toDouble() << " commands/s" << endl;
+    }
+    const QStringList keys = {"rtt_us", "serial_thread_us", "return_hop_us"};
+    for(int i = 0; i < keys.size(); ++i)
+    {
+        if(result.contains(keys.at(i)))
+        {
+            printStats(out, keys.at(i), result[keys.at(i)].toObject());
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("End-to-end serial link benchmark against a pty simulator");
+    parser.addHelpOption();
+    QCommandLineOption samplesOption("samples", "Commands per test (default 2000).", "n", "2000");
+    QCommandLineOption baudOption("bauds", "Comma separated baud rates, 0 for unlimited.", "list", "115200,460800,921600,0");
+    QCommandLineOption windowOption("windows", "Comma separated MOVEJ pipeline depths.", "list", "1,4,16");
+    QCommandLineOption latencyOption("latency", "Simulated controller latency per command in us (default 0).", "us", "0");
+    QCommandLineOption jsonOption("json", "Print results as JSON.");
+    parser.addOption(samplesOption);
+    parser.addOption(baudOption);
+    parser.addOption(windowOption);
+    parser.addOption(latencyOption);
+    parser.addOption(jsonOption);
+    parser.process(a);
+
+    int nSamples = parser.value(samplesOption).toInt();
+    const QStringList bauds = parser.value(baudOption).split(',', QString::SkipEmptyParts);
+    const QStringList windows = parser.value(windowOption).split(',', QString::SkipEmptyParts);
+
+    LinkBench bench;
+    bench.setControllerLatency(parser.value(latencyOption).toInt());
+
+    QJsonArray results;
+    for(int i = 0; i < bauds.size(); ++i)
+    {
+        int nBaud = bauds.at(i).toInt();
+        results.append(bench.measureRoundTrip(nBaud, nSamples));
+        for(int j = 0; j < windows.size(); ++j)
+        {
+            int nWindow = windows.at(j).toInt();
+            results.append(bench.measureThroughput(nBaud, SHORT_VALUES, nSamples, nWindow));
+            results.append(bench.measureThroughput(nBaud, LONG_VALUES, nSamples, nWindow));
+        }
+    }
+
+    QTextStream out(stdout);
+    if(parser.isSet(jsonOption))
+    {
+        QJsonObject root;
+        root["benchmark"] = QStringLiteral("seriallink");
+        root["samples"] = nSamples;
+        root["latency_us"] = parser.value(latencyOption).toInt();
+        root["results"] = results;
+        out << QJsonDocument(root).toJson();
+    }else{
+        for(int i = 0; i < results.size(); ++i)
+        {
+            printResult(out, results.at(i).toObject());
+        }
+    }
+    return 0;
+}
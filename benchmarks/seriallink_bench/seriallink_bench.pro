@@ -0,0 +1,23 @@
+QT       -= gui
+QT       += core serialport
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = seriallink_bench
+
+# 模拟控制器用POSIX伪终端，只能在unix上构建，benchmarks.pro中已按平台排除
+INCLUDEPATH += ../../simulator
+
+# 被测的链路代码直接链接dummycore，core在顶层工程的构建目录下
+DUMMYCORE_BUILD = $$OUT_PWD/../../core
+include(../../dummycore.pri)
+
+SOURCES += \
+    linkbench.cpp \
+    main.cpp \
+    ../../simulator/ptysimulator.cpp
+
+HEADERS += \
+    linkbench.h \
+    ../../simulator/ptysimulator.h
@@ -0,0 +1,282 @@
+#include "binaryprotocol.h"
+#include <cmath>
+#include <cstring>
+
+//定点数缩放，按参数下标区分
+static float valueScale(CMD_TYPE cmd, int index)
+{
+    switch (cmd) {
+    case CMD_TYPE::MOVEJ:
+        return 100.0f;
+    case CMD_TYPE::MOVEL:
+        return (index < 3) ? 10.0f : 100.0f;
+    default:
+        return 1.0f;
+    }
+}
+
+static qint32 toFixed(float value, float scale, qint32 minValue, qint32 maxValue)
+{
+    float scaled = std::round(value * scale);
+    if(scaled < minValue) return minValue;
+    if(scaled > maxValue) return maxValue;
+    return static_cast<qint32>(scaled);
+}
+
+static void putInt16(char* p, qint16 value)
+{
+    quint16 u = static_cast<quint16>(value);
+    p[0] = static_cast<char>(u & 0xFF);
+    p[1] = static_cast<char>(u >> 8);
+}
+
+static void putInt32(char* p, qint32 value)
+{
+    quint32 u = static_cast<quint32>(value);
+    p[0] = static_cast<char>(u & 0xFF);
+    p[1] = static_cast<char>((u >> 8) & 0xFF);
+    p[2] = static_cast<char>((u >> 16) & 0xFF);
+    p[3] = static_cast<char>(u >> 24);
+}
+
+//增益是小数，按float32的位模式传输，不做定点缩放
+static void putFloat32(char* p, float value)
+{
+    quint32 u;
+    std::memcpy(&u, &value, sizeof(u));
+    putInt32(p, static_cast<qint32>(u));
+}
+
+static qint16 getInt16(const char* p)
+{
+    const quint8* u = reinterpret_cast<const quint8*>(p);
+    return static_cast<qint16>(u[0] | (u[1] << 8));
+}
+
+static qint32 getInt32(const char* p)
+{
+    const quint8* u = reinterpret_cast<const quint8*>(p);
+    return static_cast<qint32>(quint32(u[0]) | (quint32(u[1]) << 8) | (quint32(u[2]) << 16) | (quint32(u[3]) << 24));
+}
+
+static float getFloat32(const char* p)
+{
+    quint32 u = static_cast<quint32>(getInt32(p));
+    float value;
+    std::memcpy(&value, &u, sizeof(value));
+    return value;
+}
+
+int BinaryProtocol::payloadSize(CMD_TYPE cmd)
+{
+    switch (cmd) {
+    case CMD_TYPE::STOP:
+    case CMD_TYPE::START:
+    case CMD_TYPE::HOME:
+    case CMD_TYPE::CALIBRATION:
+    case CMD_TYPE::RESET:
+    case CMD_TYPE::DISABLE:
+    case CMD_TYPE::GETJPOS:
+    case CMD_TYPE::GETLPOS:
+        return 0;
+    case CMD_TYPE::CMDMODE:
+        return 1;
+    case CMD_TYPE::MOVEJ:
+    case CMD_TYPE::MOVEL:
+        return 6 * 2 + 1;
+    case CMD_TYPE::SETKP:
+    case CMD_TYPE::SETKI:
+    case CMD_TYPE::SETKD:
+        return 1 + 4;
+    default:
+        return -1;
+    }
+}
+
+int BinaryProtocol::valueCount(CMD_TYPE cmd)
+{
+    switch (cmd) {
+    case CMD_TYPE::CMDMODE:
+        return 1;
+    case CMD_TYPE::MOVEJ:
+    case CMD_TYPE::MOVEL:
+        return 7;
+    case CMD_TYPE::SETKP:
+    case CMD_TYPE::SETKI:
+    case CMD_TYPE::SETKD:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+int BinaryProtocol::encode(CMD_TYPE cmd, const float *values, int count, char *buf, int bufSize)
+{
+    int nPayload = payloadSize(cmd);
+    if(nPayload < 0 || bufSize < nPayload + OVERHEAD)
+    {
+        return 0;
+    }
+
+    //缺少的参数按0处理
+    float v[MAX_CMD_VALUES] = {0};
+    for(int i = 0; i < count && i < MAX_CMD_VALUES; ++i)
+    {
+        v[i] = values[i];
+    }
+
+    buf[0] = static_cast<char>(SYNC);
+    buf[1] = static_cast<char>(cmd);
+    char* p = buf + 2;
+    switch (cmd) {
+    case CMD_TYPE::CMDMODE:
+        p[0] = static_cast<char>(toFixed(v[0], 1.0f, 0, 255));
+        break;
+    case CMD_TYPE::MOVEJ:
+    case CMD_TYPE::MOVEL:
+        for(int i = 0; i < 6; ++i)
+        {
+            putInt16(p + i * 2, static_cast<qint16>(toFixed(v[i], valueScale(cmd, i), -32768, 32767)));
+        }
+        p[12] = static_cast<char>(toFixed(v[6], 1.0f, 0, 255));
+        break;
+    case CMD_TYPE::SETKP:
+    case CMD_TYPE::SETKI:
+    case CMD_TYPE::SETKD:
+        p[0] = static_cast<char>(toFixed(v[0], 1.0f, 0, 255));
+        putFloat32(p + 1, v[1]);
+        break;
+    default:
+        break;
+    }
+
+    buf[2 + nPayload] = static_cast<char>(crc8(buf + 1, nPayload + 1));
+    return nPayload + OVERHEAD;
+}
+
+QByteArray BinaryProtocol::encode(CMD_TYPE cmd, const float *values, int count)
+{
+    char buf[MAX_FRAME_SIZE];
+    int nSize = encode(cmd, values, count, buf, sizeof(buf));
+    return QByteArray(buf, nSize);
+}
+
+bool BinaryProtocol::decode(const char *frame, int size, RobotCommand &command)
+{
+    if(size < OVERHEAD || static_cast<quint8>(frame[0]) != SYNC)
+    {
+        return false;
+    }
+
+    CMD_TYPE cmd = static_cast<CMD_TYPE>(static_cast<quint8>(frame[1]));
+    int nPayload = payloadSize(cmd);
+    if(nPayload < 0 || size < nPayload + OVERHEAD)
+    {
+        return false;
+    }
+    if(static_cast<quint8>(frame[2 + nPayload]) != crc8(frame + 1, nPayload + 1))
+    {
+        return false;
+    }
+
+    command.cmd = cmd;
+    command.count = valueCount(cmd);
+    const char* p = frame + 2;
+    switch (cmd) {
+    case CMD_TYPE::CMDMODE:
+        command.values[0] = static_cast<quint8>(p[0]);
+        break;
+    case CMD_TYPE::MOVEJ:
+    case CMD_TYPE::MOVEL:
+        for(int i = 0; i < 6; ++i)
+        {
+            command.values[i] = getInt16(p + i * 2) / valueScale(cmd, i);
+        }
+        command.values[6] = static_cast<quint8>(p[12]);
+        break;
+    case CMD_TYPE::SETKP:
+    case CMD_TYPE::SETKI:
+    case CMD_TYPE::SETKD:
+        command.values[0] = static_cast<quint8>(p[0]);
+        command.values[1] = getFloat32(p + 1);
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+quint8 BinaryProtocol::crc8(const char *data, int size)
+{
+    quint8 crc = 0;
+    for(int i = 0; i < size; ++i)
+    {
+        crc ^= static_cast<quint8>(data[i]);
+        for(int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc & 0x80) ? static_cast<quint8>((crc << 1) ^ 0x07) : static_cast<quint8>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+BinaryFrameDecoder::BinaryFrameDecoder()
+{
+
+}
+
+void BinaryFrameDecoder::append(const QByteArray &data)
+{
+    if(m_nReadPos > 0)
+    {
+        m_buffer.remove(0, m_nReadPos);
+        m_nReadPos = 0;
+    }
+    m_buffer.append(data);
+}
+
+bool BinaryFrameDecoder::takeCommand(RobotCommand &command)
+{
+    while(m_buffer.size() - m_nReadPos >= BinaryProtocol::OVERHEAD)
+    {
+        const char* p = m_buffer.constData() + m_nReadPos;
+        int nAvailable = m_buffer.size() - m_nReadPos;
+
+        //寻找同步字
+        if(static_cast<quint8>(p[0]) != BinaryProtocol::SYNC)
+        {
+            ++m_nReadPos;
+            ++m_nDropped;
+            continue;
+        }
+
+        int nPayload = BinaryProtocol::payloadSize(static_cast<CMD_TYPE>(static_cast<quint8>(p[1])));
+        if(nPayload < 0)
+        {
+            ++m_nReadPos;
+            ++m_nDropped;
+            continue;
+        }
+        if(nAvailable < nPayload + BinaryProtocol::OVERHEAD)
+        {
+            return false;
+        }
+
+        if(BinaryProtocol::decode(p, nAvailable, command))
+        {
+            m_nReadPos += nPayload + BinaryProtocol::OVERHEAD;
+            return true;
+        }
+
+        //校验失败，从下一个字节重新同步
+        ++m_nReadPos;
+        ++m_nDropped;
+    }
+    return false;
+}
+
+void BinaryFrameDecoder::clear()
+{
+    m_buffer.clear();
+    m_nReadPos = 0;
+}
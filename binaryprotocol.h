@@ -0,0 +1,65 @@
+#ifndef BINARYPROTOCOL_H
+#define BINARYPROTOCOL_H
+
+#include <QByteArray>
+#include "commanddefs.h"
+
+/*
+ * 二进制指令帧格式（小端）：
+ *   0xA5 | 指令号(CMD_TYPE) | 参数 | CRC8
+ * 参数长度由指令号决定，不单独传输：
+ *   MOVEJ   6 x int16 关节角(0.01度) + uint8 速度
+ *   MOVEL   3 x int16 位置(0.1mm) + 3 x int16 姿态(0.01度) + uint8 速度
+ *   CMDMODE uint8 模式
+ *   SETKP/SETKI/SETKD uint8 关节号 + float32 参数值（IEEE 754，和ASCII一样原样传递小数增益）
+ *   其他    无参数
+ * CRC8 多项式 0x07，校验范围为指令号和参数
+ */
+
+class BinaryProtocol
+{
+public:
+    static const quint8 SYNC = 0xA5;
+    //帧头(同步字+指令号)和CRC的长度
+    static const int OVERHEAD = 3;
+    //最长的帧: MOVEJ/MOVEL
+    static const int MAX_FRAME_SIZE = OVERHEAD + 13;
+
+    //指令参数字节数，未知指令返回-1
+    static int payloadSize(CMD_TYPE cmd);
+    //指令参数个数
+    static int valueCount(CMD_TYPE cmd);
+
+    //编码到调用者提供的缓冲区，返回帧长度，缓冲区不足返回0
+    static int encode(CMD_TYPE cmd, const float* values, int count, char* buf, int bufSize);
+    static QByteArray encode(CMD_TYPE cmd, const float* values = nullptr, int count = 0);
+
+    //解码一个完整帧，frame指向同步字
+    static bool decode(const char* frame, int size, RobotCommand& command);
+
+    static quint8 crc8(const char* data, int size);
+};
+
+// 流式解码器，用于控制器端（或本地模拟控制器）
+class BinaryFrameDecoder
+{
+public:
+    BinaryFrameDecoder();
+
+    void append(const QByteArray& data);
+
+    //取出一条指令，没有完整帧时返回false
+    bool takeCommand(RobotCommand& command);
+
+    void clear();
+
+    //校验失败或丢弃的字节数
+    int droppedBytes() const { return m_nDropped; }
+
+private:
+    QByteArray m_buffer;
+    int m_nReadPos = 0;
+    int m_nDropped = 0;
+};
+
+#endif // BINARYPROTOCOL_H
@@ -0,0 +1,44 @@
+#ifndef COMMANDDEFS_H
+#define COMMANDDEFS_H
+
+typedef enum CmdType
+{
+    STOP,
+    START,
+    HOME,
+    CALIBRATION,
+    RESET,
+    DISABLE,
+    GETJPOS,
+    GETLPOS,
+    CMDMODE,
+    MOVEJ,
+    MOVEL,
+    SETKP,
+    SETKI,
+    SETKD
+}CMD_TYPE;
+
+//指令编码方式，每次连接时选择
+typedef enum ProtocolType
+{
+    PROTOCOL_ASCII,
+    PROTOCOL_BINARY
+}PROTOCOL_TYPE;
+
+//单条指令最多携带的参数个数
+#define MAX_CMD_VALUES 7
+
+//下位机固件的关节限位，度；关节点动和逆解共用
+static const float JOINT_LIMIT_MIN[6] = {-170, -75, 35, -180, -120, -720};
+static const float JOINT_LIMIT_MAX[6] = {170, 90, 180, 180, 120, 720};
+
+// 解码出的一条指令（ASCII和二进制通用）
+struct RobotCommand
+{
+    CMD_TYPE cmd = STOP;
+    float values[MAX_CMD_VALUES];
+    int count = 0;
+};
+
+#endif // COMMANDDEFS_H
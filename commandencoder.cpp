@@ -0,0 +1,219 @@
+#include "commandencoder.h"
+#include "binaryprotocol.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define CMD_SPEC(cmd, text, firstSep, sep, maxParams) \
+    {cmd, #cmd, text, sizeof(text) - 1, firstSep, sep, maxParams}
+
+//指令表，顺序必须和CMD_TYPE一致
+static constexpr CommandSpec s_cmdTable[] = {
+    CMD_SPEC(STOP,        "!STOP",        '\0', '\0', 0),
+    CMD_SPEC(START,       "!START",       '\0', '\0', 0),
+    CMD_SPEC(HOME,        "!HOME",        '\0', '\0', 0),
+    CMD_SPEC(CALIBRATION, "!CALIBRATION", '\0', '\0', 0),
+    CMD_SPEC(RESET,       "!RESET",       '\0', '\0', 0),
+    CMD_SPEC(DISABLE,     "!DISABLE",     '\0', '\0', 0),
+    CMD_SPEC(GETJPOS,     "#GETJPOS",     '\0', '\0', 0),
+    CMD_SPEC(GETLPOS,     "#GETLPOS",     '\0', '\0', 0),
+    CMD_SPEC(CMDMODE,     "#CMDMODE",     '\0', '\0', 1),
+    CMD_SPEC(MOVEJ,       "&",            '\0', ',',  MAX_CMD_VALUES),
+    CMD_SPEC(MOVEL,       "@",            '\0', ',',  MAX_CMD_VALUES),
+    CMD_SPEC(SETKP,       "#SET_DCE_KP",  ' ',  ' ',  2),
+    CMD_SPEC(SETKI,       "#SET_DCE_KI",  ' ',  ' ',  2),
+    CMD_SPEC(SETKD,       "#SET_DCE_KD",  ' ',  ' ',  2),
+};
+
+static const int CMD_COUNT = sizeof(s_cmdTable) / sizeof(s_cmdTable[0]);
+
+static constexpr bool tableInOrder(int i)
+{
+    return i >= CMD_COUNT || (s_cmdTable[i].cmd == i && tableInOrder(i + 1));
+}
+static_assert(tableInOrder(0), "s_cmdTable must follow CMD_TYPE order");
+
+static const double s_pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+static const long long s_pow10i[] = {1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL,
+                                     1000000LL, 10000000LL, 100000000LL, 1000000000LL};
+//定点格式最多的小数位数
+static const int MAX_DECIMALS = 9;
+
+const CommandSpec &CommandEncoder::spec(CMD_TYPE cmd)
+{
+    return s_cmdTable[cmd];
+}
+
+int CommandEncoder::encode(PROTOCOL_TYPE protocol, CMD_TYPE cmd, const float *values, int count, char *buf, int bufSize)
+{
+    if(protocol == PROTOCOL_BINARY)
+    {
+        return BinaryProtocol::encode(cmd, values, count, buf, bufSize);
+    }
+    return encodeAscii(cmd, values, count, buf, bufSize);
+}
+
+int CommandEncoder::encodeAscii(CMD_TYPE cmd, const float *values, int count, char *buf, int bufSize)
+{
+    if(cmd < 0 || cmd >= CMD_COUNT)
+    {
+        return 0;
+    }
+
+    const CommandSpec& s = s_cmdTable[cmd];
+    int nParams = (count < s.maxParams) ? count : s.maxParams;
+    //按最坏情况检查长度：每个参数一个分隔符加最长的数值
+    if(bufSize < s.textSize + nParams * (MAX_FLOAT_SIZE + 1) + 2)
+    {
+        return 0;
+    }
+
+    char* p = buf;
+    std::memcpy(p, s.text, s.textSize);
+    p += s.textSize;
+    for(int i = 0; i < nParams; ++i)
+    {
+        char sep = (i == 0) ? s.firstSep : s.sep;
+        if(sep)
+        {
+            *p++ = sep;
+        }
+        p += formatFloat(values[i], p);
+    }
+    *p++ = '\r';
+    *p++ = '\n';
+    return static_cast<int>(p - buf);
+}
+
+bool CommandEncoder::decodeAscii(const char *line, int size, RobotCommand &command)
+{
+    if(size <= 0 || size >= MAX_CMD_SIZE)
+    {
+        return false;
+    }
+
+    //复制到栈上并补'\0'，strtof需要
+    char text[MAX_CMD_SIZE];
+    std::memcpy(text, line, size);
+    text[size] = '\0';
+
+    const CommandSpec* pSpec = nullptr;
+    for(int i = 0; i < CMD_COUNT; ++i)
+    {
+        const CommandSpec& s = s_cmdTable[i];
+        if(s.maxParams == 0)
+        {
+            //无参数指令必须完全一致
+            if(size == s.textSize && std::memcmp(text, s.text, s.textSize) == 0)
+            {
+                pSpec = &s;
+                break;
+            }
+        }else if(size >= s.textSize && std::memcmp(text, s.text, s.textSize) == 0)
+        {
+            pSpec = &s;
+            break;
+        }
+    }
+    if(!pSpec)
+    {
+        return false;
+    }
+
+    command.cmd = pSpec->cmd;
+    command.count = parseValues(text + pSpec->textSize, command.values, pSpec->maxParams);
+    return command.count >= 0;
+}
+
+int CommandEncoder::parseValues(const char *text, float *values, int maxCount)
+{
+    int nCount = 0;
+    char* pEnd = nullptr;
+    while(*text && nCount < maxCount)
+    {
+        while(*text == ',' || *text == ' ')
+        {
+            ++text;
+        }
+        if(!*text)
+        {
+            break;
+        }
+        float value = std::strtof(text, &pEnd);
+        if(pEnd == text)
+        {
+            return -1;
+        }
+        values[nCount++] = value;
+        text = pEnd;
+    }
+    return nCount;
+}
+
+int CommandEncoder::formatFloat(float value, char *buf)
+{
+    if(!std::isfinite(value) || value == 0.0f)
+    {
+        buf[0] = '0';
+        return 1;
+    }
+
+    double absValue = std::fabs(static_cast<double>(value));
+    float target = std::fabs(value);
+
+    //找到能还原为同一float的最少小数位数
+    long long scaled = 0;
+    int nDecimals = -1;
+    if(absValue < 1e9)
+    {
+        for(int p = 0; p <= MAX_DECIMALS; ++p)
+        {
+            scaled = std::llround(absValue * s_pow10[p]);
+            if(static_cast<float>(scaled / s_pow10[p]) == target)
+            {
+                nDecimals = p;
+                break;
+            }
+        }
+    }
+
+    //太大或太小的数定点表示不下，走通用格式
+    if(nDecimals < 0)
+    {
+        return std::snprintf(buf, MAX_FLOAT_SIZE, "%.9g", static_cast<double>(value));
+    }
+
+    char* p = buf;
+    if(value < 0)
+    {
+        *p++ = '-';
+    }
+
+    long long intPart = scaled / s_pow10i[nDecimals];
+    long long fracPart = scaled % s_pow10i[nDecimals];
+
+    //整数部分倒序写入临时区再拷贝
+    char digits[20];
+    int nDigits = 0;
+    do {
+        digits[nDigits++] = static_cast<char>('0' + intPart % 10);
+        intPart /= 10;
+    } while(intPart > 0);
+    while(nDigits > 0)
+    {
+        *p++ = digits[--nDigits];
+    }
+
+    if(nDecimals > 0)
+    {
+        *p++ = '.';
+        for(int i = nDecimals - 1; i >= 0; --i)
+        {
+            p[i] = static_cast<char>('0' + fracPart % 10);
+            fracPart /= 10;
+        }
+        p += nDecimals;
+    }
+    return static_cast<int>(p - buf);
+}
@@ -0,0 +1,43 @@
+#ifndef COMMANDENCODER_H
+#define COMMANDENCODER_H
+
+#include "commanddefs.h"
+
+// 指令表中的一项，ASCII格式为 text [firstSep] 参数 {sep 参数} \r\n
+struct CommandSpec
+{
+    CMD_TYPE cmd;
+    const char* name;   //显示和命令行用的名字，即枚举名，如"MOVEJ"
+    const char* text;
+    int textSize;
+    char firstSep;   //第一个参数前的分隔符，'\0'表示没有
+    char sep;        //参数之间的分隔符
+    int maxParams;   //最多参数个数，0为无参数指令
+};
+
+// 不分配内存的指令编码器，直接写入调用者提供的缓冲区
+class CommandEncoder
+{
+public:
+    //一条ASCII指令的最大长度
+    static const int MAX_CMD_SIZE = 192;
+    //formatFloat需要的最小缓冲区
+    static const int MAX_FLOAT_SIZE = 24;
+
+    static const CommandSpec& spec(CMD_TYPE cmd);
+
+    //按协议编码，返回写入的字节数，缓冲区不足返回0
+    static int encode(PROTOCOL_TYPE protocol, CMD_TYPE cmd, const float* values, int count, char* buf, int bufSize);
+    static int encodeAscii(CMD_TYPE cmd, const float* values, int count, char* buf, int bufSize);
+
+    //解析一行ASCII指令（不含\r\n）
+    static bool decodeAscii(const char* line, int size, RobotCommand& command);
+
+    //解析以逗号或空格分隔的数值，text须以'\0'结尾，返回个数，遇到非法字符返回-1
+    static int parseValues(const char* text, float* values, int maxCount);
+
+    //最短且能还原为同一float的十进制表示，返回长度
+    static int formatFloat(float value, char* buf);
+};
+
+#endif // COMMANDENCODER_H
@@ -0,0 +1,80 @@
+#include "commandring.h"
+#include <cstring>
+
+CommandRing::CommandRing()
+    : m_nTail(0)
+    , m_nHead(0)
+    , m_bPending(0)
+    , m_bThrottled(0)
+{
+}
+
+bool CommandRing::push(const char *data, int size)
+{
+    if(size <= 0 || size > SLOT_SIZE)
+    {
+        return false;
+    }
+    quint32 tail = m_nTail.load();
+    if(tail - m_nCachedHead >= quint32(CAPACITY))
+    {
+        //缓存的位置显示已满时才读取消费者的最新位置
+        m_nCachedHead = m_nHead.loadAcquire();
+        if(tail - m_nCachedHead >= quint32(CAPACITY))
+        {
+            return false;
+        }
+    }
+    Slot& slot = m_slots[tail & (CAPACITY - 1)];
+    slot.size = size;
+    memcpy(slot.data, data, size_t(size));
+    m_nTail.storeRelease(tail + 1);
+    return true;
+}
+
+bool CommandRing::markPending()
+{
+    //用交换而不是比较交换：消费者清除标记时一定能读到这次写入，之前入队的指令对它可见
+    return m_bPending.fetchAndStoreOrdered(1) == 0;
+}
+
+void CommandRing::setThrottled(bool bThrottled)
+{
+    m_bThrottled.store(bThrottled ? 1 : 0);
+}
+
+bool CommandRing::isThrottled() const
+{
+    return m_bThrottled.load() != 0;
+}
+
+void CommandRing::clearPending()
+{
+    m_bPending.fetchAndStoreOrdered(0);
+}
+
+const char *CommandRing::front(int &size)
+{
+    quint32 head = m_nHead.load();
+    if(head == m_nCachedTail)
+    {
+        m_nCachedTail = m_nTail.loadAcquire();
+        if(head == m_nCachedTail)
+        {
+            return nullptr;
+        }
+    }
+    const Slot& slot = m_slots[head & (CAPACITY - 1)];
+    size = slot.size;
+    return slot.data;
+}
+
+void CommandRing::pop()
+{
+    m_nHead.storeRelease(m_nHead.load() + 1);
+}
+
+int CommandRing::size() const
+{
+    return int(m_nTail.loadAcquire() - m_nHead.loadAcquire());
+}
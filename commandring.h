@@ -0,0 +1,57 @@
+#ifndef COMMANDRING_H
+#define COMMANDRING_H
+
+#include <QAtomicInteger>
+#include "commandencoder.h"
+
+// 单生产者单消费者的无锁指令队列：一个发送线程写入，串口线程取出
+// 槽位预先分配，入队出队只拷贝指令字节，不分配内存
+// 队列从空变为非空时生产者负责唤醒一次消费者，连续入队的指令合并为一次唤醒
+class CommandRing
+{
+public:
+    static const int CAPACITY = 256;    //必须是2的幂
+    static const int SLOT_SIZE = CommandEncoder::MAX_CMD_SIZE;
+
+    CommandRing();
+
+    //生产者调用，队列满或指令超过SLOT_SIZE返回false
+    bool push(const char* data, int size);
+    //生产者在push成功后调用，返回true表示需要唤醒消费者
+    bool markPending();
+
+    //消费者来不及发送时暂停接收，生产者据此推迟发送
+    void setThrottled(bool bThrottled);
+    bool isThrottled() const;
+
+    //消费者调用：先清除唤醒标记再取数据，之后入队的指令会再次唤醒
+    void clearPending();
+    //队首指令，队列空返回nullptr，用完后调用pop
+    const char* front(int& size);
+    void pop();
+
+    //两个线程都可以调用，只是瞬时值
+    int size() const;
+
+private:
+    struct Slot
+    {
+        int size;
+        char data[SLOT_SIZE];
+    };
+
+    Slot m_slots[CAPACITY];
+
+    //生产者和消费者的位置放在不同缓存行，各自缓存对方的位置，减少跨核同步
+    char m_padding0[64];
+    QAtomicInteger<quint32> m_nTail;    //生产者写
+    quint32 m_nCachedHead = 0;
+    char m_padding1[64];
+    QAtomicInteger<quint32> m_nHead;    //消费者写
+    quint32 m_nCachedTail = 0;
+    char m_padding2[64];
+    QAtomicInt m_bPending;
+    QAtomicInt m_bThrottled;
+};
+
+#endif // COMMANDRING_H
@@ -0,0 +1,228 @@
+#include "consolewidget.h"
+#include <QPlainTextEdit>
+#include <QCheckBox>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTimer>
+#include <QScrollBar>
+#include <QStringList>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+
+ConsoleWidget::ConsoleWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_lines(DEFAULT_CAPACITY)
+{
+    m_view = new QPlainTextEdit(this);
+    m_view->setReadOnly(true);
+    m_view->setUndoRedoEnabled(false);
+    m_view->setMaximumBlockCount(DEFAULT_CAPACITY);
+
+    m_filter_lineEdit = new QLineEdit(this);
+    m_filter_lineEdit->setPlaceholderText("过滤");
+    m_filter_lineEdit->setClearButtonEnabled(true);
+    m_pause_cBox = new QCheckBox("暂停", this);
+    m_clear_Btn = new QPushButton("清空", this);
+
+    QHBoxLayout* toolLayout = new QHBoxLayout;
+    toolLayout->addWidget(m_filter_lineEdit, 1);
+    toolLayout->addWidget(m_pause_cBox);
+    toolLayout->addWidget(m_clear_Btn);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(m_view, 1);
+    layout->addLayout(toolLayout);
+
+    //只在有新数据时启动一次，连续到达的数据合并到同一帧
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setSingleShot(true);
+    m_refreshTimer->setInterval(1000 / DEFAULT_MAX_FPS);
+    connect(m_refreshTimer, SIGNAL(timeout()), this, SLOT(onRefresh()));
+
+    connect(m_pause_cBox, SIGNAL(toggled(bool)), this, SLOT(setPaused(bool)));
+    connect(m_filter_lineEdit, SIGNAL(textChanged(QString)), this, SLOT(setFilter(QString)));
+    connect(m_clear_Btn, SIGNAL(clicked()), this, SLOT(clear()));
+}
+
+void ConsoleWidget::setCapacity(int capacity)
+{
+    if(capacity < 1)
+    {
+        capacity = 1;
+    }
+    m_lines = QVector<QString>(capacity);
+    m_view->setMaximumBlockCount(capacity);
+    clear();
+}
+
+void ConsoleWidget::setMaxFps(int fps)
+{
+    if(fps < 1)
+    {
+        fps = 1;
+    }
+    m_refreshTimer->setInterval(1000 / fps);
+}
+
+void ConsoleWidget::appendData(const QByteArray &data)
+{
+    int nStart = 0;
+    for(int i = 0; i < data.size(); ++i)
+    {
+        if(data.at(i) != '\n')
+        {
+            continue;
+        }
+        m_partial.append(data.constData() + nStart, i - nStart);
+        if(m_partial.endsWith('\r'))
+        {
+            m_partial.chop(1);
+        }
+        pushLine(QString::fromLatin1(m_partial));
+        m_partial.clear();
+        nStart = i + 1;
+    }
+    m_partial.append(data.constData() + nStart, data.size() - nStart);
+
+    //没有换行的数据不能无限累积
+    while(m_partial.size() >= MAX_LINE_LENGTH)
+    {
+        pushLine(QString::fromLatin1(m_partial.constData(), MAX_LINE_LENGTH));
+        m_partial.remove(0, MAX_LINE_LENGTH);
+    }
+}
+
+void ConsoleWidget::appendLine(const QString &line)
+{
+    pushLine(line.left(MAX_LINE_LENGTH));
+}
+
+void ConsoleWidget::clear()
+{
+    m_nHead = 0;
+    m_nCount = 0;
+    m_nShown = m_nTotal;
+    m_partial.clear();
+    for(int i = 0; i < m_lines.size(); ++i)
+    {
+        m_lines[i].clear();
+    }
+    m_view->clear();
+    m_bRebuild = false;
+}
+
+void ConsoleWidget::setPaused(bool bPaused)
+{
+    m_bPaused = bPaused;
+    if(m_pause_cBox->isChecked() != bPaused)
+    {
+        m_pause_cBox->setChecked(bPaused);
+    }
+    if(!bPaused)
+    {
+        scheduleRefresh();
+    }
+}
+
+void ConsoleWidget::setFilter(const QString &filter)
+{
+    if(filter == m_strFilter)
+    {
+        return;
+    }
+    m_strFilter = filter;
+    if(m_filter_lineEdit->text() != filter)
+    {
+        m_filter_lineEdit->setText(filter);
+    }
+    m_bRebuild = true;
+    scheduleRefresh();
+}
+
+void ConsoleWidget::onRefresh()
+{
+    if(m_bPaused)
+    {
+        return;
+    }
+
+    //未显示的行已经被覆盖时只能整体重建
+    quint64 nPending = m_nTotal - m_nShown;
+    if(m_bRebuild || nPending > quint64(m_nCount))
+    {
+        rebuildView();
+        return;
+    }
+    if(nPending == 0)
+    {
+        return;
+    }
+
+    QStringList newLines;
+    int capacity = m_lines.size();
+    for(int i = m_nCount - int(nPending); i < m_nCount; ++i)
+    {
+        const QString& line = m_lines.at((m_nHead + i) % capacity);
+        if(matches(line))
+        {
+            newLines << line;
+        }
+    }
+    m_nShown = m_nTotal;
+
+    //一次追加只触发一次布局，滚动条在底部时会跟随到底部
+    if(!newLines.isEmpty())
+    {
+        m_view->appendPlainText(newLines.join(QChar('\n')));
+    }
+}
+
+void ConsoleWidget::pushLine(const QString &line)
+{
+    int capacity = m_lines.size();
+    if(m_nCount < capacity)
+    {
+        m_lines[(m_nHead + m_nCount) % capacity] = line;
+        ++m_nCount;
+    }else{
+        m_lines[m_nHead] = line;
+        m_nHead = (m_nHead + 1) % capacity;
+        ++m_nDropped;
+    }
+    ++m_nTotal;
+    scheduleRefresh();
+}
+
+void ConsoleWidget::scheduleRefresh()
+{
+    if(!m_bPaused && !m_refreshTimer->isActive())
+    {
+        m_refreshTimer->start();
+    }
+}
+
+bool ConsoleWidget::matches(const QString &line) const
+{
+    return m_strFilter.isEmpty() || line.contains(m_strFilter, Qt::CaseInsensitive);
+}
+
+void ConsoleWidget::rebuildView()
+{
+    QStringList lines;
+    int capacity = m_lines.size();
+    for(int i = 0; i < m_nCount; ++i)
+    {
+        const QString& line = m_lines.at((m_nHead + i) % capacity);
+        if(matches(line))
+        {
+            lines << line;
+        }
+    }
+    m_nShown = m_nTotal;
+    m_bRebuild = false;
+
+    m_view->setPlainText(lines.join(QChar('\n')));
+    QScrollBar* scrollBar = m_view->verticalScrollBar();
+    scrollBar->setValue(scrollBar->maximum());
+}
@@ -0,0 +1,77 @@
+#ifndef CONSOLEWIDGET_H
+#define CONSOLEWIDGET_H
+
+#include <QWidget>
+#include <QVector>
+#include <QString>
+#include <QByteArray>
+
+class QPlainTextEdit;
+class QCheckBox;
+class QLineEdit;
+class QPushButton;
+class QTimer;
+
+// 串口控制台：最近的若干行存在固定容量的环形缓冲里，超出后覆盖最早的行
+// 新数据只标记刷新，由定时器按最高帧率批量追加到视图，长时间运行内存和刷新开销不增长
+class ConsoleWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    static const int DEFAULT_CAPACITY = 2000;
+    //单行最大长度，二进制协议没有换行时也按该长度切分
+    static const int MAX_LINE_LENGTH = 256;
+    static const int DEFAULT_MAX_FPS = 10;
+
+    explicit ConsoleWidget(QWidget *parent = nullptr);
+
+    //修改容量会清空已有内容
+    void setCapacity(int capacity);
+    int capacity() const { return m_lines.size(); }
+    void setMaxFps(int fps);
+
+    //串口原始数据，按换行拆分，不完整的行留到下次拼接
+    void appendData(const QByteArray& data);
+    void appendLine(const QString& line);
+
+    bool isPaused() const { return m_bPaused; }
+    //缓冲区满被覆盖的行数
+    quint64 droppedCount() const { return m_nDropped; }
+
+public slots:
+    void clear();
+    //暂停时继续接收，只停止刷新视图
+    void setPaused(bool bPaused);
+    //只显示包含filter的行，不区分大小写，空字符串显示全部
+    void setFilter(const QString& filter);
+
+private slots:
+    void onRefresh();
+
+private:
+    void pushLine(const QString& line);
+    void scheduleRefresh();
+    bool matches(const QString& line) const;
+    //按当前过滤条件重新生成整个视图
+    void rebuildView();
+
+private:
+    QPlainTextEdit* m_view;
+    QCheckBox* m_pause_cBox;
+    QLineEdit* m_filter_lineEdit;
+    QPushButton* m_clear_Btn;
+    QTimer* m_refreshTimer;
+
+    QVector<QString> m_lines;
+    int m_nHead = 0;          //最早一行的位置
+    int m_nCount = 0;
+    quint64 m_nTotal = 0;     //累计收到的行数，也是下一行的序号
+    quint64 m_nShown = 0;     //已经追加到视图的行数
+    quint64 m_nDropped = 0;
+    QByteArray m_partial;
+    QString m_strFilter;
+    bool m_bPaused = false;
+    bool m_bRebuild = false;
+};
+
+#endif // CONSOLEWIDGET_H
@@ -0,0 +1,155 @@
+#include "controllermodel.h"
+#include "commandencoder.h"
+#include <cstdio>
+
+ControllerModel::ControllerModel(PROTOCOL_TYPE protocol)
+    : m_protocol(protocol)
+{
+
+}
+
+void ControllerModel::setProtocol(PROTOCOL_TYPE protocol)
+{
+    m_protocol = protocol;
+    m_decoder.clear();
+    m_lineBuffer.clear();
+}
+
+QByteArray ControllerModel::feed(const QByteArray &data)
+{
+    QVector<ControllerReply> replies;
+    feed(data, replies);
+    QByteArray reply;
+    for(int i = 0; i < replies.size(); ++i)
+    {
+        reply += replies.at(i).data;
+    }
+    return reply;
+}
+
+int ControllerModel::feed(const QByteArray &data, QVector<ControllerReply> &replies)
+{
+    int nOldSize = replies.size();
+    ControllerReply reply;
+    RobotCommand command;
+
+    if(m_protocol == PROTOCOL_BINARY)
+    {
+        m_decoder.append(data);
+        while(m_decoder.takeCommand(command))
+        {
+            reply.cmd = command.cmd;
+            reply.bValid = true;
+            reply.data = execute(command);
+            replies.append(reply);
+        }
+        return replies.size() - nOldSize;
+    }
+
+    m_lineBuffer.append(data);
+    int nStart = 0;
+    int nEnd = 0;
+    while((nEnd = m_lineBuffer.indexOf('\n', nStart)) >= 0)
+    {
+        int nLineEnd = nEnd;
+        if(nLineEnd > nStart && m_lineBuffer.at(nLineEnd - 1) == '\r')
+        {
+            --nLineEnd;
+        }
+        QByteArray line = m_lineBuffer.mid(nStart, nLineEnd - nStart);
+        nStart = nEnd + 1;
+
+        if(line.isEmpty())
+        {
+            continue;
+        }
+        if(parseAsciiLine(line, command))
+        {
+            reply.cmd = command.cmd;
+            reply.bValid = true;
+            reply.data = execute(command);
+        }else{
+            reply.bValid = false;
+            reply.data = "error: unknown command\r\n";
+        }
+        replies.append(reply);
+    }
+    m_lineBuffer.remove(0, nStart);
+    return replies.size() - nOldSize;
+}
+
+QByteArray ControllerModel::execute(const RobotCommand &command)
+{
+    ++m_nCommands;
+    switch (command.cmd) {
+    case CMD_TYPE::START:
+        m_bEnabled = true;
+        break;
+    case CMD_TYPE::STOP:
+    case CMD_TYPE::DISABLE:
+        m_bEnabled = false;
+        break;
+    case CMD_TYPE::HOME:
+    case CMD_TYPE::RESET:
+    {
+        const float rest[6] = {0.00f, -75.00f, 180.00f, 0.00f, 0.00f, 0.00f};
+        for(int i = 0; i < 6; ++i)
+        {
+            m_joints[i] = rest[i];
+        }
+        break;
+    }
+    case CMD_TYPE::GETJPOS:
+        return positionReply(m_joints);
+    case CMD_TYPE::GETLPOS:
+        return positionReply(m_pose);
+    case CMD_TYPE::CMDMODE:
+        m_nMode = static_cast<int>(command.values[0]);
+        break;
+    case CMD_TYPE::MOVEJ:
+        if(command.count < 6)
+        {
+            return QByteArray("error: bad parameters\r\n");
+        }
+        for(int i = 0; i < 6; ++i)
+        {
+            m_joints[i] = command.values[i];
+        }
+        break;
+    case CMD_TYPE::MOVEL:
+        if(command.count < 6)
+        {
+            return QByteArray("error: bad parameters\r\n");
+        }
+        for(int i = 0; i < 6; ++i)
+        {
+            m_pose[i] = command.values[i];
+        }
+        break;
+    default:
+        break;
+    }
+    return QByteArray("ok\r\n");
+}
+
+bool ControllerModel::parseAsciiLine(const QByteArray &line, RobotCommand &command)
+{
+    if(!CommandEncoder::decodeAscii(line.constData(), line.size(), command))
+    {
+        return false;
+    }
+    //运动指令速度可省略，其余指令参数必须完整
+    if(command.cmd == MOVEJ || command.cmd == MOVEL)
+    {
+        return command.count >= 6;
+    }
+    return command.count == CommandEncoder::spec(command.cmd).maxParams;
+}
+
+QByteArray ControllerModel::positionReply(const float *values)
+{
+    char buf[128];
+    int nSize = std::snprintf(buf, sizeof(buf), "ok %.2f %.2f %.2f %.2f %.2f %.2f\r\n",
+                              values[0], values[1], values[2], values[3], values[4], values[5]);
+    return QByteArray(buf, nSize);
+}
@@ -0,0 +1,58 @@
+#ifndef CONTROLLERMODEL_H
+#define CONTROLLERMODEL_H
+
+#include <QByteArray>
+#include <QVector>
+#include "commanddefs.h"
+#include "binaryprotocol.h"
+
+// 一条指令的应答，指令无法解析时bValid为false
+struct ControllerReply
+{
+    CMD_TYPE cmd = STOP;
+    bool bValid = false;
+    QByteArray data;
+};
+
+// 本地模拟的Dummy控制器：解析主机指令（ASCII或二进制），维护简单的关节状态并生成应答
+// 用于没有机械臂时测试编码和链路
+class ControllerModel
+{
+public:
+    explicit ControllerModel(PROTOCOL_TYPE protocol = PROTOCOL_ASCII);
+
+    void setProtocol(PROTOCOL_TYPE protocol);
+    PROTOCOL_TYPE protocol() const { return m_protocol; }
+
+    //输入主机发来的数据，返回控制器应答（可能为空）
+    QByteArray feed(const QByteArray& data);
+    //同上，每条指令的应答分开返回，便于模拟各指令不同的处理时间，返回追加的条数
+    int feed(const QByteArray& data, QVector<ControllerReply>& replies);
+
+    //执行一条已解码的指令并返回应答
+    QByteArray execute(const RobotCommand& command);
+
+    //解析一行ASCII指令（不含\r\n）
+    static bool parseAsciiLine(const QByteArray& line, RobotCommand& command);
+
+    const float* jointAngles() const { return m_joints; }
+    const float* pose() const { return m_pose; }
+    bool isEnabled() const { return m_bEnabled; }
+    int commandCount() const { return m_nCommands; }
+
+private:
+    static QByteArray positionReply(const float* values);
+
+private:
+    PROTOCOL_TYPE m_protocol;
+    BinaryFrameDecoder m_decoder;
+    QByteArray m_lineBuffer;
+
+    float m_joints[6] = {0.00f, -75.00f, 180.00f, 0.00f, 0.00f, 0.00f};
+    float m_pose[6] = {93.37f, 0.00f, 165.00f, -180.00f, 75.00f, -180.00f};
+    bool m_bEnabled = false;
+    int m_nMode = 2;
+    int m_nCommands = 0;
+};
+
+#endif // CONTROLLERMODEL_H
@@ -0,0 +1,59 @@
+QT       -= gui
+QT       += core serialport network
+
+TEMPLATE = lib
+CONFIG += staticlib c++11
+
+TARGET = dummycore
+
+INCLUDEPATH += ..
+
+# 界面和守护进程共用的部分，只能依赖QtCore、QtSerialPort和QtNetwork
+# kinematics、posemath等用到QtGui的QQuaternion，留在界面工程中
+SOURCES += \
+    ../asynclogger.cpp \
+    ../binaryprotocol.cpp \
+    ../commandencoder.cpp \
+    ../commandring.cpp \
+    ../controllermodel.cpp \
+    ../creditwindow.cpp \
+    ../joggenerator.cpp \
+    ../lineargenerator.cpp \
+    ../linkstats.cpp \
+    ../motionprofile.cpp \
+    ../motionscheduler.cpp \
+    ../networkbridge.cpp \
+    ../playbacksource.cpp \
+    ../replyparser.cpp \
+    ../responseframer.cpp \
+    ../robotstate.cpp \
+    ../serialsender.cpp \
+    ../trajectoryfile.cpp \
+    ../trajectoryplayer.cpp \
+    ../trajectoryrecorder.cpp \
+    ../trajectorysimplifier.cpp
+
+HEADERS += \
+    ../asynclogger.h \
+    ../binaryprotocol.h \
+    ../commanddefs.h \
+    ../commandencoder.h \
+    ../commandring.h \
+    ../controllermodel.h \
+    ../creditwindow.h \
+    ../joggenerator.h \
+    ../lineargenerator.h \
+    ../linkstats.h \
+    ../monotonicclock.h \
+    ../motionprofile.h \
+    ../motionscheduler.h \
+    ../networkbridge.h \
+    ../playbacksource.h \
+    ../replyparser.h \
+    ../responseframer.h \
+    ../robotstate.h \
+    ../serialsender.h \
+    ../trajectoryfile.h \
+    ../trajectoryplayer.h \
+    ../trajectoryrecorder.h \
+    ../trajectorysimplifier.h
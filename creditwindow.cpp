@@ -0,0 +1,63 @@
+#include "creditwindow.h"
+
+CreditWindow::CreditWindow()
+{
+    m_clock.start();
+}
+
+void CreditWindow::setWindow(int window)
+{
+    if(window < 0)
+    {
+        window = 0;
+    }else if(window > MAX_WINDOW)
+    {
+        window = MAX_WINDOW;
+    }
+    m_nWindow = window;
+    reset();
+}
+
+void CreditWindow::reset()
+{
+    m_nHead = 0;
+    m_nOutstanding = 0;
+}
+
+void CreditWindow::onSent()
+{
+    if(m_nOutstanding >= MAX_WINDOW)
+    {
+        return;
+    }
+    m_sendTimes[(m_nHead + m_nOutstanding) % MAX_WINDOW] = m_clock.elapsed();
+    ++m_nOutstanding;
+}
+
+bool CreditWindow::onAck()
+{
+    if(m_nOutstanding == 0)
+    {
+        //不是回放发出的指令的应答
+        return false;
+    }
+    m_nLastRttMs = m_clock.elapsed() - m_sendTimes[m_nHead];
+    m_nHead = (m_nHead + 1) % MAX_WINDOW;
+    --m_nOutstanding;
+    ++m_nAckCount;
+    return true;
+}
+
+int CreditWindow::expire(qint64 timeoutMs)
+{
+    if(m_nOutstanding == 0 || m_clock.elapsed() - m_sendTimes[m_nHead] < timeoutMs)
+    {
+        return 0;
+    }
+
+    //应答按顺序返回，最早的一条超时说明之后的也无法对应，全部归还
+    int nLost = m_nOutstanding;
+    m_nTimeoutCount += static_cast<quint64>(nLost);
+    reset();
+    return nLost;
+}
@@ -0,0 +1,49 @@
+#ifndef CREDITWINDOW_H
+#define CREDITWINDOW_H
+
+#include <QElapsedTimer>
+
+// 基于应答的发送窗口：最多允许N条指令未应答，收到一个ok归还一个额度
+// 应答按发送顺序到达，用先进先出的时间戳计算往返时间和超时
+class CreditWindow
+{
+public:
+    static const int MAX_WINDOW = 32;
+
+    CreditWindow();
+
+    //设置窗口大小，0表示关闭流控
+    void setWindow(int window);
+    int window() const { return m_nWindow; }
+    bool isEnabled() const { return m_nWindow > 0; }
+
+    //清空未应答的指令
+    void reset();
+
+    bool canSend() const { return m_nOutstanding < m_nWindow; }
+    int outstanding() const { return m_nOutstanding; }
+
+    void onSent();
+    //收到应答，没有未应答指令时返回false
+    bool onAck();
+
+    //最早一条未应答的指令超过timeoutMs仍无应答时视为丢失，返回丢失的条数
+    int expire(qint64 timeoutMs);
+
+    //最近一次应答的往返时间
+    qint64 lastRttMs() const { return m_nLastRttMs; }
+    quint64 ackCount() const { return m_nAckCount; }
+    quint64 timeoutCount() const { return m_nTimeoutCount; }
+
+private:
+    QElapsedTimer m_clock;
+    qint64 m_sendTimes[MAX_WINDOW];
+    int m_nHead = 0;
+    int m_nOutstanding = 0;
+    int m_nWindow = 0;
+    qint64 m_nLastRttMs = 0;
+    quint64 m_nAckCount = 0;
+    quint64 m_nTimeoutCount = 0;
+};
+
+#endif // CREDITWINDOW_H
@@ -0,0 +1,21 @@
+QT       -= gui
+QT       += core serialport network
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = dummyrobotd
+
+include(../dummycore.pri)
+
+SOURCES += \
+    main.cpp \
+    robotdaemon.cpp
+
+HEADERS += \
+    robotdaemon.h
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
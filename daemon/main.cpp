@@ -0,0 +1,127 @@
+// Dummy无界面守护进程：只依赖QtCore和QtSerialPort，用于没有显示屏的板子
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include "robotdaemon.h"
+#include "asynclogger.h"
+
+//日志级别名称，和界面的日志级别下拉框顺序一致
+static bool levelFromName(const QString& strName, LOG_LEVEL& level)
+{
+    static const char* names[] = {"trace", "debug", "info", "warn", "error", "off"};
+    for(int i = 0; i <= LOG_OFF; ++i)
+    {
+        if(strName.compare(names[i], Qt::CaseInsensitive) == 0)
+        {
+            level = static_cast<LOG_LEVEL>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("dummyrobotd");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless Dummy robot controller: play back or record a trajectory file, or bridge the robot to TCP clients");
+    parser.addHelpOption();
+    QCommandLineOption portOption("port", "Serial port, e.g. /dev/ttyACM0.", "name");
+    QCommandLineOption baudOption("baud", "Baud rate (default 115200).", "rate", "115200");
+    QCommandLineOption protocolOption("protocol", "Command encoding: ascii or binary (default ascii).", "name", "ascii");
+    QCommandLineOption playOption("play", "Play back a trajectory file and exit when done.", "file");
+    QCommandLineOption fromOption("from", "First record to play (default 0).", "index", "0");
+    QCommandLineOption windowOption("window", "Unacknowledged commands allowed, 0 for timed playback (default 0).", "n", "0");
+    QCommandLineOption speedOption("speed", "Speed for records without one, also scales timed playback (default 100).", "percent", "100");
+    QCommandLineOption recordOption("record", "Record the pose into a trajectory file until SIGINT/SIGTERM.", "file");
+    QCommandLineOption pollOption("poll-interval", "Delay after each pose reply while recording in ms (default 0).", "ms", "0");
+    QCommandLineOption listenOption("listen", "Serve commands and telemetry over TCP on this port.", "port");
+    QCommandLineOption listenAddressOption("listen-address", "Address to listen on (default 127.0.0.1).", "address", "127.0.0.1");
+    QCommandLineOption logFileOption("log-file", "Write the log to a file instead of stderr.", "file");
+    QCommandLineOption logLevelOption("log-level", "trace, debug, info, warn, error or off (default info).", "level", "info");
+    parser.addOption(portOption);
+    parser.addOption(baudOption);
+    parser.addOption(protocolOption);
+    parser.addOption(playOption);
+    parser.addOption(fromOption);
+    parser.addOption(windowOption);
+    parser.addOption(speedOption);
+    parser.addOption(recordOption);
+    parser.addOption(pollOption);
+    parser.addOption(listenOption);
+    parser.addOption(listenAddressOption);
+    parser.addOption(logFileOption);
+    parser.addOption(logLevelOption);
+    parser.process(a);
+
+    QTextStream err(stderr);
+
+    DaemonOptions options;
+    options.portName = parser.value(portOption);
+    options.baudRate = parser.value(baudOption).toInt();
+    options.playFile = parser.value(playOption);
+    options.fromIndex = parser.value(fromOption).toInt();
+    options.window = parser.value(windowOption).toInt();
+    options.speed = parser.value(speedOption).toFloat();
+    options.recordFile = parser.value(recordOption);
+    options.pollIntervalMs = parser.value(pollOption).toInt();
+    options.listenAddress = parser.value(listenAddressOption);
+    options.listenPort = static_cast<quint16>(parser.value(listenOption).toUInt());
+
+    QString strProtocol = parser.value(protocolOption);
+    if(strProtocol == "binary")
+    {
+        options.protocol = PROTOCOL_BINARY;
+    }else if(strProtocol != "ascii")
+    {
+        err << "bad --protocol: " << strProtocol << endl;
+        return 1;
+    }
+    if(options.portName.isEmpty())
+    {
+        err << "--port is required" << endl;
+        return 1;
+    }
+    //回放和记录一次只做一件，网络桥可以和它们同时开启
+    if(!options.playFile.isEmpty() && !options.recordFile.isEmpty())
+    {
+        err << "--play and --record cannot be used together" << endl;
+        return 1;
+    }
+    if(options.playFile.isEmpty() && options.recordFile.isEmpty() && options.listenPort == 0)
+    {
+        err << "one of --play, --record or --listen is required" << endl;
+        return 1;
+    }
+    if(parser.isSet(listenOption) && options.listenPort == 0)
+    {
+        err << "bad --listen: " << parser.value(listenOption) << endl;
+        return 1;
+    }
+    if(options.speed <= 0 || options.window < 0 || options.fromIndex < 0)
+    {
+        err << "bad --speed, --window or --from" << endl;
+        return 1;
+    }
+    LOG_LEVEL level;
+    if(!levelFromName(parser.value(logLevelOption), level))
+    {
+        err << "bad --log-level: " << parser.value(logLevelOption) << endl;
+        return 1;
+    }
+
+    AsyncLogger* logger = AsyncLogger::instance();
+    logger->setLevel(level);
+    logger->setOutputFile(parser.value(logFileOption));
+    logger->start(QThread::LowPriority);
+
+    RobotDaemon::installSignalHandlers();
+    RobotDaemon daemon(options);
+    daemon.start();
+    int nRet = a.exec();
+
+    AsyncLogger::instance()->stop();
+    return nRet;
+}
@@ -0,0 +1,149 @@
+#include "robotdaemon.h"
+#include "serialsender.h"
+#include "motionscheduler.h"
+#include "trajectoryplayer.h"
+#include "trajectoryrecorder.h"
+#include "trajectorysimplifier.h"
+#include "networkbridge.h"
+#include "asynclogger.h"
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QHostAddress>
+#include <QTimer>
+#include <QDebug>
+#include <csignal>
+
+//信号处理函数中只能写这个标志
+static volatile std::sig_atomic_t g_nQuitSignal = 0;
+
+static void onQuitSignal(int signal)
+{
+    g_nQuitSignal = signal;
+}
+
+RobotDaemon::RobotDaemon(const DaemonOptions &options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_serialSender(new SerialSender(this))
+{
+    connect(m_serialSender, &SerialSender::signalOpened, this, &RobotDaemon::onSerialOpened);
+    connect(m_serialSender, &SerialSender::signalError, this, &RobotDaemon::onSerialError);
+
+    m_scheduler = new MotionScheduler(m_serialSender, this);
+    m_player = new TrajectoryPlayer(m_serialSender, m_scheduler, this);
+    m_recorder = new TrajectoryRecorder(m_serialSender, this);
+    connect(m_player, &TrajectoryPlayer::signalFinished, this, &RobotDaemon::onPlaybackFinished);
+    if(m_options.listenPort > 0)
+    {
+        m_bridge = new NetworkBridge(m_serialSender, this);
+    }
+
+    m_signalTimer = new QTimer(this);
+    m_signalTimer->setInterval(SIGNAL_CHECK_MS);
+    connect(m_signalTimer, &QTimer::timeout, this, &RobotDaemon::onCheckSignal);
+}
+
+void RobotDaemon::installSignalHandlers()
+{
+    std::signal(SIGINT, onQuitSignal);
+    std::signal(SIGTERM, onQuitSignal);
+}
+
+void RobotDaemon::start()
+{
+    m_signalTimer->start();
+    qInfo() << "open" << m_options.portName << m_options.baudRate;
+    m_serialSender->open(m_options.portName, m_options.baudRate, m_options.protocol);
+}
+
+void RobotDaemon::onSerialOpened()
+{
+    //串口打开后再接受远程指令
+    if(m_bridge && !m_bridge->isListening())
+    {
+        if(!m_bridge->listen(QHostAddress(m_options.listenAddress), m_options.listenPort))
+        {
+            shutdown(1);
+            return;
+        }
+        qInfo() << "bridge listening on" << m_options.listenAddress << m_bridge->serverPort();
+    }
+    if(!m_options.playFile.isEmpty())
+    {
+        qInfo() << "play" << m_options.playFile << "from" << m_options.fromIndex;
+        if(!m_player->start(m_options.playFile, m_options.fromIndex, m_options.window, m_options.speed))
+        {
+            shutdown(1);
+        }
+    }else if(!m_options.recordFile.isEmpty())
+    {
+        qInfo() << "record" << m_options.recordFile;
+        if(!m_recorder->start(m_options.recordFile, m_options.pollIntervalMs))
+        {
+            shutdown(1);
+        }
+    }
+}
+
+void RobotDaemon::onSerialError(const QString &strError)
+{
+    qWarning() << "serial error" << strError;
+    shutdown(1);
+}
+
+void RobotDaemon::onPlaybackFinished()
+{
+    qInfo() << "playback finished," << m_player->playIndex() << "records";
+    shutdown(0);
+}
+
+void RobotDaemon::onCheckSignal()
+{
+    if(g_nQuitSignal != 0)
+    {
+        qInfo() << "signal" << static_cast<int>(g_nQuitSignal) << "received";
+        shutdown(0);
+    }
+}
+
+void RobotDaemon::shutdown(int exitCode)
+{
+    if(m_bShuttingDown)
+    {
+        return;
+    }
+    m_bShuttingDown = true;
+    m_signalTimer->stop();
+
+    if(m_player->isPlaying())
+    {
+        m_player->stop();
+        qInfo() << "playback stopped at record" << m_player->playIndex();
+    }
+    if(m_recorder->isRecording())
+    {
+        QString filePath = m_recorder->fileName();
+        int nCount = m_recorder->stop();
+        //去掉静止点和共线点，减少回放时的指令数
+        SimplifyResult result;
+        if(nCount > 0 && TrajectorySimplifier::simplifyFile(filePath, SimplifyOptions(), result))
+        {
+            qInfo() << QString("simplify %1: %2 -> %3 points (%4 stationary removed)")
+                       .arg(QFileInfo(filePath).fileName())
+                       .arg(result.inputCount)
+                       .arg(result.outputCount)
+                       .arg(result.stationaryRemoved);
+        }else if(nCount > 0)
+        {
+            qWarning() << "simplify" << filePath << "failed, original recording kept";
+        }
+    }
+    if(m_bridge)
+    {
+        qInfo() << "bridge closed," << m_bridge->telemetryCount() << "frames,"
+                << m_bridge->droppedCount() << "dropped for slow clients";
+        m_bridge->close();
+    }
+    m_serialSender->close();
+    QCoreApplication::exit(exitCode);
+}
@@ -0,0 +1,71 @@
+#ifndef ROBOTDAEMON_H
+#define ROBOTDAEMON_H
+
+#include <QObject>
+#include <QString>
+#include "commanddefs.h"
+
+class QTimer;
+class SerialSender;
+class MotionScheduler;
+class TrajectoryPlayer;
+class TrajectoryRecorder;
+class NetworkBridge;
+
+struct DaemonOptions
+{
+    QString portName;
+    int baudRate = 115200;
+    PROTOCOL_TYPE protocol = PROTOCOL_ASCII;
+    //回放：window为0时定时回放
+    QString playFile;
+    int fromIndex = 0;
+    int window = 0;
+    float speed = 100;
+    //拖动示教记录，0为收到应答立即采下一个点
+    QString recordFile;
+    int pollIntervalMs = 0;
+    //网络桥：端口为0时不开启
+    QString listenAddress;
+    quint16 listenPort = 0;
+};
+
+// 无界面守护进程：串口打开后回放或记录一个轨迹文件，可同时开启网络桥
+// 回放结束后退出；记录和只开网络桥时一直运行到SIGINT/SIGTERM，停止时和界面一样精简记录文件
+class RobotDaemon : public QObject
+{
+    Q_OBJECT
+public:
+    //检查信号标志的周期
+    static const int SIGNAL_CHECK_MS = 100;
+
+    explicit RobotDaemon(const DaemonOptions& options, QObject *parent = nullptr);
+
+    //安装SIGINT/SIGTERM处理，信号处理函数只置标志，由事件循环退出
+    static void installSignalHandlers();
+
+    //打开串口，打开成功后再开始回放或记录
+    void start();
+
+private slots:
+    void onSerialOpened();
+    void onSerialError(const QString& strError);
+    void onPlaybackFinished();
+    void onCheckSignal();
+
+private:
+    //停止回放和记录、关闭串口后退出事件循环
+    void shutdown(int exitCode);
+
+private:
+    DaemonOptions m_options;
+    SerialSender* m_serialSender;
+    MotionScheduler* m_scheduler;
+    TrajectoryPlayer* m_player;
+    TrajectoryRecorder* m_recorder;
+    NetworkBridge* m_bridge = nullptr;
+    QTimer* m_signalTimer;
+    bool m_bShuttingDown = false;
+};
+
+#endif // ROBOTDAEMON_H
@@ -0,0 +1,18 @@
+# 链接dummycore静态库，由gui、daemon和基准测试工程include
+# DUMMYCORE_BUILD为core的构建目录，默认与包含它的工程同级，目录更深的工程在include前自行设置
+QT += core serialport network
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+isEmpty(DUMMYCORE_BUILD): DUMMYCORE_BUILD = $$OUT_PWD/../core
+
+win32:CONFIG(release, debug|release): DUMMYCORE_DIR = $$DUMMYCORE_BUILD/release
+else:win32:CONFIG(debug, debug|release): DUMMYCORE_DIR = $$DUMMYCORE_BUILD/debug
+else: DUMMYCORE_DIR = $$DUMMYCORE_BUILD
+
+LIBS += -L$$DUMMYCORE_DIR -ldummycore
+
+win32-g++: PRE_TARGETDEPS += $$DUMMYCORE_DIR/libdummycore.a
+else:win32:!win32-g++: PRE_TARGETDEPS += $$DUMMYCORE_DIR/dummycore.lib
+else: PRE_TARGETDEPS += $$DUMMYCORE_DIR/libdummycore.a
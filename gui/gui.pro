@@ -0,0 +1,38 @@
+QT       += core gui serialport
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += c++11
+
+TARGET = DummyRobotControl
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+include(../dummycore.pri)
+
+SOURCES += \
+    ../arcgenerator.cpp \
+    ../consolewidget.cpp \
+    ../kinematics.cpp \
+    ../main.cpp \
+    ../mainwidget.cpp \
+    ../posemath.cpp \
+    ../trajectoryvalidator.cpp
+
+HEADERS += \
+    ../arcgenerator.h \
+    ../consolewidget.h \
+    ../kinematics.h \
+    ../mainwidget.h \
+    ../posemath.h \
+    ../trajectoryvalidator.h
+
+FORMS += \
+    ../mainwidget.ui
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,157 @@
+#include "joggenerator.h"
+#include <cmath>
+
+//离限位小于该距离时认为已经到达
+#define JOG_BOUND_EPSILON 1e-3
+
+JogGenerator::JogGenerator()
+{
+    for(int i = 0; i < 6; ++i)
+    {
+        m_values[i] = 0;
+    }
+}
+
+void JogGenerator::start(const float *start, int axis, int direction, const ProfileLimits &limits)
+{
+    for(int i = 0; i < 6; ++i)
+    {
+        m_values[i] = start[i];
+    }
+    m_nAxis = axis;
+    m_nDirection = (direction < 0) ? -1 : 1;
+    m_limits = limits;
+    m_minValue = 0;
+    m_maxValue = 0;
+    m_position = start[axis];
+    m_velocity = 0;
+    m_acceleration = 0;
+    m_bMoving = true;
+}
+
+void JogGenerator::setMaxVelocity(double maxVelocity)
+{
+    m_limits.maxVelocity = maxVelocity;
+}
+
+void JogGenerator::setBounds(double minValue, double maxValue)
+{
+    m_minValue = minValue;
+    m_maxValue = maxValue;
+}
+
+bool JogGenerator::step(double dt)
+{
+    if(!m_bMoving || dt <= 0)
+    {
+        return m_bMoving;
+    }
+
+    //以下按运动方向为正计算
+    double amax = m_limits.maxAcceleration;
+    double jmax = m_limits.maxJerk;
+    double speed = m_velocity * m_nDirection;
+    double accel = m_acceleration * m_nDirection;
+    double target = m_limits.maxVelocity;
+    double maxChange = jmax * dt;
+
+    bool bBounded = m_minValue < m_maxValue;
+    if(bBounded)
+    {
+        double remain = (m_nDirection > 0) ? m_maxValue - m_position : m_position - m_minValue;
+        if(remain < JOG_BOUND_EPSILON)
+        {
+            m_bMoving = false;
+            m_velocity = 0;
+            m_acceleration = 0;
+            return false;
+        }
+        //假设这一拍继续加速，之后就来不及停下的话从这一拍开始减速
+        double nextAccel = std::fmin(amax, accel + maxChange);
+        double nextSpeed = speed + nextAccel * dt;
+        if((speed + nextSpeed) * 0.5 * dt + stoppingDistance(nextSpeed, nextAccel) >= remain)
+        {
+            target = 0;
+        }
+    }
+
+    //加速度朝着能平滑到达目标速度的值变化，每拍的变化量受加加速度限制
+    //离散形式：按这个加速度每拍减少jmax*dt，速度恰好在到达目标时加速度减为0
+    double dv = target - speed;
+    double wanted = std::fmin(amax, std::sqrt(maxChange * maxChange / 4 + 2 * jmax * std::fabs(dv)) - maxChange / 2);
+    if(dv < 0)
+    {
+        wanted = -wanted;
+    }
+    accel += std::fmax(-maxChange, std::fmin(maxChange, wanted - accel));
+    m_acceleration = accel * m_nDirection;
+    target *= m_nDirection;
+    dv *= m_nDirection;
+
+    double velocity = m_velocity + m_acceleration * dt;
+    //不越过目标速度，到达后加速度归零
+    if((dv >= 0 && velocity > target) || (dv <= 0 && velocity < target))
+    {
+        velocity = target;
+        m_acceleration = 0;
+    }
+    //不会反向运动
+    if(velocity * m_nDirection < 0)
+    {
+        velocity = 0;
+        m_acceleration = 0;
+    }
+    m_position += (m_velocity + velocity) * 0.5 * dt;
+    m_velocity = velocity;
+
+    if(bBounded && (m_position > m_maxValue || m_position < m_minValue))
+    {
+        //数值误差造成的越界直接截到限位上
+        m_position = std::fmax(m_minValue, std::fmin(m_maxValue, m_position));
+        m_velocity = 0;
+    }
+    if(bBounded && speed > 0 && m_velocity == 0)
+    {
+        //为限位减速到0，停在限位前
+        m_acceleration = 0;
+        m_bMoving = false;
+    }
+    m_values[m_nAxis] = static_cast<float>(m_position);
+    return m_bMoving;
+}
+
+void JogGenerator::setpoint(float *values) const
+{
+    for(int i = 0; i < 6; ++i)
+    {
+        values[i] = m_values[i];
+    }
+}
+
+double JogGenerator::stoppingDistance(double velocity, double acceleration) const
+{
+    double amax = m_limits.maxAcceleration;
+    double jmax = m_limits.maxJerk;
+    double distance = 0;
+    if(acceleration > 0)
+    {
+        //还在加速，先把加速度降到0，这段时间速度继续增加
+        double t = acceleration / jmax;
+        distance += velocity * t + acceleration * t * t / 2 - jmax * t * t * t / 6;
+        velocity += acceleration * acceleration / (2 * jmax);
+    }
+    if(velocity <= 0)
+    {
+        return distance;
+    }
+
+    //加速度从0开始、受加加速度限制时，速度v停下所需的距离：
+    //v >= a^2/j 时 d = v^2/(2a) + v*a/(2j)，否则 d = v*sqrt(v/j)
+    if(velocity >= amax * amax / jmax)
+    {
+        distance += velocity * velocity / (2 * amax) + velocity * amax / (2 * jmax);
+    }else{
+        distance += velocity * std::sqrt(velocity / jmax);
+    }
+    return distance;
+}
@@ -0,0 +1,47 @@
+#ifndef JOGGENERATOR_H
+#define JOGGENERATOR_H
+
+#include "motionprofile.h"
+
+// 连续点动的设定值生成器：每拍推进一个轴，速度、加速度、加加速度都受limits限制
+// 按住期间平滑加速到最大速度，修改速度或接近限位时平滑减速
+// 松开按键由调用者直接停止发送，设定值停在最后一拍，不再滑行
+class JogGenerator
+{
+public:
+    JogGenerator();
+
+    //从start的6个值开始，第axis个值按direction(+1/-1)方向运动，初速度为0
+    void start(const float* start, int axis, int direction, const ProfileLimits& limits);
+    //运动中修改最大速度，速度平滑过渡
+    void setMaxVelocity(double maxVelocity);
+    //限位，接近时平滑减速并停在限位前；minValue >= maxValue表示不限位
+    void setBounds(double minValue, double maxValue);
+
+    //推进dt秒，在限位前停下之后返回false
+    bool step(double dt);
+
+    //当前6个设定值
+    void setpoint(float* values) const;
+    int axis() const { return m_nAxis; }
+    double velocity() const { return m_velocity; }
+    bool isMoving() const { return m_bMoving; }
+
+private:
+    //以速度velocity、加速度acceleration（沿运动方向）开始平稳停下需要的距离
+    double stoppingDistance(double velocity, double acceleration) const;
+
+private:
+    float m_values[6];
+    int m_nAxis = 0;
+    int m_nDirection = 1;
+    ProfileLimits m_limits;
+    double m_minValue = 0;
+    double m_maxValue = 0;
+    double m_position = 0;
+    double m_velocity = 0;
+    double m_acceleration = 0;
+    bool m_bMoving = false;
+};
+
+#endif // JOGGENERATOR_H
@@ -0,0 +1,278 @@
+#include "kinematics.h"
+#include "posemath.h"
+#include <cmath>
+#include <algorithm>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+#define RAD_TO_DEG (180.0 / M_PI)
+#define DEG_TO_RAD (M_PI / 180.0)
+
+//腕部中心到关节5轴线的距离小于该值视为奇异，关节4取参考值
+#define WRIST_SINGULAR_EPSILON 1e-6
+
+//DH参数中的固定部分：关节角零位偏置和连杆扭角，与固件一致
+static const double THETA_OFFSET[6] = {0, -M_PI / 2, M_PI / 2, 0, 0, 0};
+static const double ALPHA[6] = {-M_PI / 2, 0, M_PI / 2, -M_PI / 2, M_PI / 2, 0};
+
+//R = Rz(theta) * Rx(alpha)，按行存放
+static void linkRotation(double theta, double alpha, double* r)
+{
+    double ct = std::cos(theta);
+    double st = std::sin(theta);
+    double ca = std::cos(alpha);
+    double sa = std::sin(alpha);
+    r[0] = ct; r[1] = -st * ca; r[2] = st * sa;
+    r[3] = st; r[4] = ct * ca;  r[5] = -ct * sa;
+    r[6] = 0;  r[7] = sa;       r[8] = ca;
+}
+
+static void multiply(const double* a, const double* b, double* out)
+{
+    for(int row = 0; row < 3; ++row)
+    {
+        for(int col = 0; col < 3; ++col)
+        {
+            out[3 * row + col] = a[3 * row] * b[col] + a[3 * row + 1] * b[3 + col]
+                    + a[3 * row + 2] * b[6 + col];
+        }
+    }
+}
+
+//out = a^T * b
+static void multiplyTransposed(const double* a, const double* b, double* out)
+{
+    for(int row = 0; row < 3; ++row)
+    {
+        for(int col = 0; col < 3; ++col)
+        {
+            out[3 * row + col] = a[row] * b[col] + a[3 + row] * b[3 + col] + a[6 + row] * b[6 + col];
+        }
+    }
+}
+
+//p += r * v
+static void addRotated(const double* r, double vx, double vy, double vz, double* p)
+{
+    p[0] += r[0] * vx + r[1] * vy + r[2] * vz;
+    p[1] += r[3] * vx + r[4] * vy + r[5] * vz;
+    p[2] += r[6] * vx + r[7] * vy + r[8] * vz;
+}
+
+Kinematics::Kinematics(const ArmGeometry &geometry)
+    : m_geometry(geometry)
+{
+    m_elbowLength = std::hypot(geometry.forearmLength, geometry.elbowOffset);
+    m_elbowAngle = std::atan2(geometry.elbowOffset, geometry.forearmLength);
+}
+
+const ArmGeometry &Kinematics::geometry() const
+{
+    return m_geometry;
+}
+
+void Kinematics::forward(const float *joints, float *pose) const
+{
+    double rotation[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+    double link[9];
+    double next[9];
+    double position[3] = {0, 0, 0};
+    for(int i = 0; i < 6; ++i)
+    {
+        linkRotation(joints[i] * DEG_TO_RAD + THETA_OFFSET[i], ALPHA[i], link);
+        multiply(rotation, link, next);
+        std::copy(next, next + 9, rotation);
+
+        //各段连杆在所属坐标系下的向量
+        if(i == 0)
+        {
+            addRotated(rotation, m_geometry.baseOffset, -m_geometry.baseHeight, 0, position);
+        }else if(i == 1)
+        {
+            addRotated(rotation, m_geometry.armLength, 0, 0, position);
+        }else if(i == 2)
+        {
+            addRotated(rotation, -m_geometry.elbowOffset, 0, m_geometry.forearmLength, position);
+        }else if(i == 5)
+        {
+            addRotated(rotation, 0, 0, m_geometry.wristLength, position);
+        }
+    }
+
+    for(int i = 0; i < 3; ++i)
+    {
+        pose[i] = static_cast<float>(position[i]);
+    }
+    PoseMath::fromMatrix(rotation, pose + 3);
+}
+
+void Kinematics::forward(const float *joints, int count, float *poses) const
+{
+    for(int n = 0; n < count; ++n)
+    {
+        forward(joints + 6 * n, poses + 6 * n);
+    }
+}
+
+int Kinematics::solutions(const float *pose, const float *reference, float *joints) const
+{
+    double target[9];
+    PoseMath::toMatrix(pose + 3, target);
+
+    //腕部中心：法兰沿自身z轴退回腕长
+    double wx = pose[0] - m_geometry.wristLength * target[2];
+    double wy = pose[1] - m_geometry.wristLength * target[5];
+    double wz = pose[2] - m_geometry.wristLength * target[8];
+
+    int nCount = 0;
+    for(int shoulder = 0; shoulder < 2; ++shoulder)
+    {
+        //肩部朝前或转到背后
+        double q1 = std::atan2(wy, wx) + ((shoulder == 0) ? 0 : M_PI);
+        double radial = ((shoulder == 0) ? 1 : -1) * std::hypot(wx, wy) - m_geometry.baseOffset;
+        //关节1坐标系的y轴朝下
+        double px = radial;
+        double py = -(wz - m_geometry.baseHeight);
+
+        double la = m_geometry.armLength;
+        double le = m_elbowLength;
+        double cosElbow = (px * px + py * py - la * la - le * le) / (2 * la * le);
+        if(cosElbow > 1 || cosElbow < -1)
+        {
+            continue;
+        }
+
+        for(int elbow = 0; elbow < 2; ++elbow)
+        {
+            double psi = ((elbow == 0) ? 1 : -1) * std::acos(cosElbow);
+            double theta2 = std::atan2(py, px) - std::atan2(le * std::sin(psi), la + le * std::cos(psi));
+            double q2 = theta2 - THETA_OFFSET[1];
+            double q3 = psi + m_elbowAngle;
+
+            //前三个关节确定的姿态，剩下的由腕部的Z-Y-Z转动补齐
+            double r01[9];
+            double r12[9];
+            double r23[9];
+            double r02[9];
+            double r03[9];
+            double r36[9];
+            linkRotation(q1 + THETA_OFFSET[0], ALPHA[0], r01);
+            linkRotation(q2 + THETA_OFFSET[1], ALPHA[1], r12);
+            linkRotation(q3 + THETA_OFFSET[2], ALPHA[2], r23);
+            multiply(r01, r12, r02);
+            multiply(r02, r23, r03);
+            multiplyTransposed(r03, target, r36);
+
+            for(int wrist = 0; wrist < 2; ++wrist)
+            {
+                double sign = (wrist == 0) ? 1 : -1;
+                double sin5 = std::hypot(r36[2], r36[5]);
+                double q4;
+                double q5;
+                double q6;
+                if(sin5 < WRIST_SINGULAR_EPSILON)
+                {
+                    //关节4和6同轴，只能确定两者之和，关节4保持参考值
+                    //关节5为180度时超出限位，不用处理
+                    if(wrist == 1 || r36[8] < 0)
+                    {
+                        break;
+                    }
+                    q4 = reference[3] * DEG_TO_RAD;
+                    q5 = 0;
+                    q6 = std::atan2(r36[3], r36[0]) - q4;
+                }else{
+                    q4 = std::atan2(sign * r36[5], sign * r36[2]);
+                    q5 = std::atan2(sign * sin5, r36[8]);
+                    q6 = std::atan2(sign * r36[7], -sign * r36[6]);
+                }
+
+                double angles[6] = {q1, q2, q3, q4, q5, q6};
+                float* solution = joints + 6 * nCount;
+                bool bValid = true;
+                for(int i = 0; i < 6 && bValid; ++i)
+                {
+                    bValid = fitJoint(i, angles[i] * RAD_TO_DEG, reference[i], solution[i]);
+                }
+                if(bValid)
+                {
+                    ++nCount;
+                }
+            }
+        }
+    }
+    return nCount;
+}
+
+bool Kinematics::inverse(const float *pose, const float *reference, float *joints) const
+{
+    float candidates[6 * MAX_SOLUTIONS];
+    int nCount = solutions(pose, reference, candidates);
+    if(nCount == 0)
+    {
+        return false;
+    }
+
+    int nBest = 0;
+    double bestDistance = -1;
+    for(int n = 0; n < nCount; ++n)
+    {
+        double distance = 0;
+        for(int i = 0; i < 6; ++i)
+        {
+            double delta = candidates[6 * n + i] - reference[i];
+            distance += delta * delta;
+        }
+        if(bestDistance < 0 || distance < bestDistance)
+        {
+            bestDistance = distance;
+            nBest = n;
+        }
+    }
+    std::copy(candidates + 6 * nBest, candidates + 6 * nBest + 6, joints);
+    return true;
+}
+
+int Kinematics::inverse(const float *poses, int count, const float *seed, float *joints) const
+{
+    const float* reference = seed;
+    for(int n = 0; n < count; ++n)
+    {
+        if(!inverse(poses + 6 * n, reference, joints + 6 * n))
+        {
+            return n;
+        }
+        reference = joints + 6 * n;
+    }
+    return count;
+}
+
+bool Kinematics::withinLimits(const float *joints) const
+{
+    for(int i = 0; i < 6; ++i)
+    {
+        if(joints[i] < m_geometry.jointMin[i] || joints[i] > m_geometry.jointMax[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Kinematics::fitJoint(int index, double angle, double reference, float &joint) const
+{
+    double value = reference + std::remainder(angle - reference, 360.0);
+    //离参考最近的一圈超限时，再试相邻的一圈
+    const double candidates[3] = {value, value - 360, value + 360};
+    for(int i = 0; i < 3; ++i)
+    {
+        if(candidates[i] >= m_geometry.jointMin[index] - 1e-3
+                && candidates[i] <= m_geometry.jointMax[index] + 1e-3)
+        {
+            joint = static_cast<float>(candidates[i]);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,68 @@
+#ifndef KINEMATICS_H
+#define KINEMATICS_H
+
+#include "commanddefs.h"
+
+// Dummy机械臂的连杆参数，长度单位mm，关节角单位度
+// 长度是固件中的标称值，未经实测校准，正解和控制器报告的位姿不一致：
+//   关节(0,-75,180,0,0,0)的正解为88.1/0/148.6，控制器GETLPOS报告93.4/0/165（姿态一致）
+// 校准之前界面不显示正解位姿，逆解只用于勾选后才做的回放预检，守护进程不使用
+struct ArmGeometry
+{
+    ArmGeometry()
+    {
+        for(int i = 0; i < 6; ++i)
+        {
+            jointMin[i] = JOINT_LIMIT_MIN[i];
+            jointMax[i] = JOINT_LIMIT_MAX[i];
+        }
+    }
+
+    double baseHeight = 109;    //关节2轴线离底面的高度
+    double baseOffset = 35;     //关节2轴线离关节1轴线的水平距离
+    double armLength = 146;     //大臂
+    double elbowOffset = 52;    //肘部垂直于小臂方向的偏移
+    double forearmLength = 115; //小臂，肘部到腕部中心
+    double wristLength = 72;    //腕部中心到法兰
+    float jointMin[6];
+    float jointMax[6];
+};
+
+// 正逆运动学，位姿为x y z a b c，与控制器GETLPOS的格式相同
+// 批量接口按每6个float一组连续存放，不分配内存，可在工作线程里转换整条轨迹
+class Kinematics
+{
+public:
+    //肩部前后、肘部上下、腕部翻转的组合
+    static const int MAX_SOLUTIONS = 8;
+
+    explicit Kinematics(const ArmGeometry& geometry = ArmGeometry());
+
+    const ArmGeometry& geometry() const;
+
+    void forward(const float* joints, float* pose) const;
+    void forward(const float* joints, int count, float* poses) const;
+
+    //求出所有在关节限位内的解，写入joints（最多MAX_SOLUTIONS组），返回解的个数
+    //reference用于处理多圈关节和腕部奇异位置，一般传当前关节角
+    int solutions(const float* pose, const float* reference, float* joints) const;
+
+    //取离reference最近的解，不可达或超出限位返回false
+    bool inverse(const float* pose, const float* reference, float* joints) const;
+
+    //逐点求解，每个点以前一个点的解为参考，保证关节连续
+    //返回连续求解成功的点数，小于count时该下标的位姿不可达
+    int inverse(const float* poses, int count, const float* seed, float* joints) const;
+
+    bool withinLimits(const float* joints) const;
+
+private:
+    //关节角归到离reference最近的一圈，超出限位返回false
+    bool fitJoint(int index, double angle, double reference, float& joint) const;
+
+    ArmGeometry m_geometry;
+    double m_elbowLength;   //肘部到腕部中心的直线距离
+    double m_elbowAngle;    //该直线与小臂的夹角，弧度
+};
+
+#endif // KINEMATICS_H
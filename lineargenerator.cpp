@@ -0,0 +1,85 @@
+#include "lineargenerator.h"
+#include <cmath>
+
+//平移小于该值时按姿态变化规划
+#define MIN_TRANSLATION 1e-3
+
+int LinearGenerator::generate(const float *start, const float *end, const PathOptions &options,
+                              quint32 startTimeMs, QVector<TrajectoryRecord> &out)
+{
+    if(options.segmentLength <= 0)
+    {
+        return -1;
+    }
+
+    double delta[6];
+    double translation = 0;
+    double rotation = 0;
+    for(int i = 0; i < 6; ++i)
+    {
+        delta[i] = (i < 3) ? double(end[i]) - start[i] : angleDelta(start[i], end[i]);
+        if(i < 3)
+        {
+            translation += delta[i] * delta[i];
+        }else if(std::fabs(delta[i]) > rotation)
+        {
+            rotation = std::fabs(delta[i]);
+        }
+    }
+    translation = std::sqrt(translation);
+
+    //以平移距离为路径参数，纯转动时以最大的角度变化为路径参数
+    double distance = (translation > MIN_TRANSLATION) ? translation : rotation;
+    MotionProfile profile;
+    if(!profile.plan(options.profile, distance, options.limits))
+    {
+        return -1;
+    }
+    if(distance == 0)
+    {
+        return 0;
+    }
+
+    //等时间间隔采样，匀速段相邻两点相距segmentLength，加减速段更密
+    double sampleTime = options.segmentLength / options.limits.maxVelocity;
+    if(sampleTime < MIN_SAMPLE_MS / 1000.0)
+    {
+        sampleTime = MIN_SAMPLE_MS / 1000.0;
+    }
+    int nSamples = static_cast<int>(std::ceil(profile.duration() / sampleTime));
+    if(nSamples < 1)
+    {
+        nSamples = 1;
+    }
+
+    out.reserve(out.size() + nSamples);
+    for(int n = 1; n <= nSamples; ++n)
+    {
+        double t = profile.duration() * n / nSamples;
+        double ratio = profile.position(t) / distance;
+
+        TrajectoryRecord record;
+        for(int i = 0; i < 6; ++i)
+        {
+            record.pose[i] = static_cast<float>(start[i] + delta[i] * ratio);
+        }
+        if(n == nSamples)
+        {
+            //终点取原值，避免姿态按最短角度插补后变成等价的另一种写法
+            for(int i = 0; i < 6; ++i)
+            {
+                record.pose[i] = end[i];
+            }
+        }
+        record.timestampMs = startTimeMs + static_cast<quint32>(std::lround(t * 1000));
+        record.speed = 0;
+        record.flags = 0;
+        out.append(record);
+    }
+    return nSamples;
+}
+
+float LinearGenerator::angleDelta(float start, float end)
+{
+    return static_cast<float>(std::remainder(double(end) - start, 360.0));
+}
@@ -0,0 +1,33 @@
+#ifndef LINEARGENERATOR_H
+#define LINEARGENERATOR_H
+
+#include <QVector>
+#include "motionprofile.h"
+#include "trajectoryfile.h"
+
+// 插补参数，速度单位mm/s，姿态单独运动时按度/s
+struct PathOptions
+{
+    PROFILE_TYPE profile = PROFILE_TRAPEZOID;
+    ProfileLimits limits;
+    double segmentLength = 1.0;   //最大速度下相邻两点的距离，mm
+    double chordTolerance = 0.05; //圆弧插补的最大弦高，mm
+};
+
+// 直线插补：按速度规划生成带时间戳的中间位姿，回放时按时间戳发送即可保持末端速度
+class LinearGenerator
+{
+public:
+    //相邻两点的最小时间间隔，不能小于调度线程的发送能力
+    static const int MIN_SAMPLE_MS = 2;
+
+    //从start到end插补，追加到out（不含起点），第一个点之前的时刻为startTimeMs
+    //返回追加的点数，参数无效返回-1
+    static int generate(const float* start, const float* end, const PathOptions& options,
+                        quint32 startTimeMs, QVector<TrajectoryRecord>& out);
+
+    //start到end的最短角度差
+    static float angleDelta(float start, float end);
+};
+
+#endif // LINEARGENERATOR_H
@@ -0,0 +1,327 @@
+#include "linkstats.h"
+#include "commandencoder.h"
+#include "binaryprotocol.h"
+#include <QFile>
+#include <QTextStream>
+#include <QMutexLocker>
+#include <QDateTime>
+#include <QtAlgorithms>
+#include <cmath>
+#include <cstring>
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::record(qint64 value)
+{
+    if(value < 0)
+    {
+        value = 0;
+    }
+    ++m_counts[bucketIndex(value)];
+    ++m_nCount;
+    m_nSum += value;
+    if(value > m_nMax)
+    {
+        m_nMax = value;
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    std::memset(m_counts, 0, sizeof(m_counts));
+    m_nCount = 0;
+    m_nSum = 0;
+    m_nMax = 0;
+}
+
+qint64 LatencyHistogram::percentile(double p) const
+{
+    if(m_nCount == 0)
+    {
+        return 0;
+    }
+    qint64 nTarget = static_cast<qint64>(std::ceil(p * m_nCount));
+    if(nTarget < 1)
+    {
+        nTarget = 1;
+    }
+    qint64 nSeen = 0;
+    for(int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        nSeen += m_counts[i];
+        if(nSeen >= nTarget)
+        {
+            return qMin(bucketUpperBound(i), m_nMax);
+        }
+    }
+    return m_nMax;
+}
+
+int LatencyHistogram::bucketIndex(qint64 value)
+{
+    if(value < SUB_BUCKETS)
+    {
+        return static_cast<int>(value);
+    }
+    int nMagnitude = 63 - static_cast<int>(qCountLeadingZeroBits(quint64(value)));
+    if(nMagnitude >= MAX_MAGNITUDE)
+    {
+        return BUCKET_COUNT - 1;
+    }
+    //最高位之后的4位决定在区间里的第几格
+    int nShift = nMagnitude - 4;
+    int nSub = static_cast<int>(value >> nShift) - SUB_BUCKETS;
+    return SUB_BUCKETS + nShift * SUB_BUCKETS + nSub;
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int index)
+{
+    if(index < SUB_BUCKETS)
+    {
+        return index;
+    }
+    int nShift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+    int nSub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+    qint64 nLower = qint64(SUB_BUCKETS + nSub) << nShift;
+    return nLower + (qint64(1) << nShift) - 1;
+}
+
+LinkStats::LinkStats()
+{
+    reset();
+}
+
+void LinkStats::onQueued()
+{
+    m_nQueued.ref();
+}
+
+void LinkStats::onDequeued()
+{
+    m_nQueued.deref();
+}
+
+void LinkStats::onRejected()
+{
+    m_nRejected.ref();
+}
+
+void LinkStats::onWritten(const char *data, int size, PROTOCOL_TYPE protocol, qint64 timestampNs, qint64 txBacklog)
+{
+    QMutexLocker locker(&m_mutex);
+    m_nBytesOut += size;
+    ++m_nWrites;
+    m_nTxBacklog = txBacklog;
+    if(txBacklog > m_nMaxTxBacklog)
+    {
+        m_nMaxTxBacklog = txBacklog;
+    }
+
+    //一次写入可能包含多条指令
+    CMD_TYPE cmd;
+    if(protocol == PROTOCOL_BINARY)
+    {
+        int nPos = 0;
+        while(nPos < size)
+        {
+            quint8 sync = static_cast<quint8>(data[nPos]);
+            int nPayload = (nPos + 1 < size) ? BinaryProtocol::payloadSize(static_cast<CMD_TYPE>(quint8(data[nPos + 1]))) : -1;
+            if(sync != BinaryProtocol::SYNC || nPayload < 0)
+            {
+                ++nPos;
+                continue;
+            }
+            pushCommand(static_cast<CMD_TYPE>(quint8(data[nPos + 1])), timestampNs);
+            nPos += BinaryProtocol::OVERHEAD + nPayload;
+        }
+        return;
+    }
+
+    int nStart = 0;
+    for(int i = 0; i < size; ++i)
+    {
+        if(data[i] != '\n')
+        {
+            continue;
+        }
+        if(classifyAscii(data + nStart, i - nStart, cmd))
+        {
+            pushCommand(cmd, timestampNs);
+        }
+        nStart = i + 1;
+    }
+}
+
+void LinkStats::onBytesReceived(int size)
+{
+    QMutexLocker locker(&m_mutex);
+    m_nBytesIn += size;
+}
+
+int LinkStats::onFrame(const ResponseFrame &frame)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_nFrames;
+    if(frame.type == FRAME_TEXT)
+    {
+        return -1;
+    }
+    if(frame.type == FRAME_ERROR)
+    {
+        ++m_nErrors;
+    }
+    if(m_nPendingCount == 0)
+    {
+        ++m_nUnmatched;
+        return -1;
+    }
+
+    const PendingCommand& pending = m_pending[m_nPendingHead];
+    qint64 latencyUs = (frame.timestampNs - pending.sentNs) / 1000;
+    m_latency[pending.cmd].record(latencyUs);
+    m_totalLatency.record(latencyUs);
+    m_nPendingHead = (m_nPendingHead + 1) % MAX_OUTSTANDING;
+    --m_nPendingCount;
+    return pending.cmd;
+}
+
+void LinkStats::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_nRejected.store(0);
+    m_nBytesOut = 0;
+    m_nBytesIn = 0;
+    m_nWrites = 0;
+    m_nFrames = 0;
+    m_nErrors = 0;
+    m_nUnmatched = 0;
+    m_nLost = 0;
+    m_nTxBacklog = 0;
+    m_nMaxTxBacklog = 0;
+    for(int i = 0; i <= SETKD; ++i)
+    {
+        m_commands[i] = 0;
+        m_latency[i].reset();
+    }
+    m_totalLatency.reset();
+    m_nPendingHead = 0;
+    m_nPendingCount = 0;
+}
+
+int LinkStats::outstanding() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_nPendingCount;
+}
+
+QString LinkStats::report() const
+{
+    QString text;
+    QTextStream out(&text);
+    QMutexLocker locker(&m_mutex);
+
+    out << "bytes out " << m_nBytesOut << "  in " << m_nBytesIn
+        << "  writes " << m_nWrites << "  frames " << m_nFrames << endl;
+    out << "queue depth " << m_nQueued.load() << "  rejected " << m_nRejected.load()
+        << "  outstanding " << m_nPendingCount
+        << "  tx backlog " << m_nTxBacklog << " (max " << m_nMaxTxBacklog << ")" << endl;
+    out << "errors " << m_nErrors << "  unmatched replies " << m_nUnmatched
+        << "  lost commands " << m_nLost << endl;
+    out << endl;
+    out << "command        sent   replies      p50      p99    p99.9      max   (us)" << endl;
+    qint64 nCommands = 0;
+    for(int i = 0; i <= SETKD; ++i)
+    {
+        if(m_commands[i] == 0)
+        {
+            continue;
+        }
+        nCommands += m_commands[i];
+        const LatencyHistogram& histogram = m_latency[i];
+        out << QString("%1 %2 %3 %4 %5 %6 %7")
+               .arg(CommandEncoder::spec(static_cast<CMD_TYPE>(i)).name, -11)
+               .arg(m_commands[i], 8)
+               .arg(histogram.count(), 9)
+               .arg(histogram.percentile(0.50), 8)
+               .arg(histogram.percentile(0.99), 8)
+               .arg(histogram.percentile(0.999), 8)
+               .arg(histogram.max(), 8) << endl;
+    }
+    out << QString("%1 %2 %3 %4 %5 %6 %7")
+           .arg("ALL", -11)
+           .arg(nCommands, 8)
+           .arg(m_totalLatency.count(), 9)
+           .arg(m_totalLatency.percentile(0.50), 8)
+           .arg(m_totalLatency.percentile(0.99), 8)
+           .arg(m_totalLatency.percentile(0.999), 8)
+           .arg(m_totalLatency.max(), 8) << endl;
+    out.flush();
+    return text;
+}
+
+bool LinkStats::dump(const QString &filePath) const
+{
+    QFile file(filePath);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        return false;
+    }
+    QTextStream out(&file);
+    out << "# link stats " << QDateTime::currentDateTime().toString(Qt::ISODate) << endl;
+    out << report();
+
+    //原始分桶，便于离线合并或重新计算百分位
+    QMutexLocker locker(&m_mutex);
+    out << endl << "# histogram buckets: command upper_bound_us count" << endl;
+    for(int i = 0; i <= SETKD; ++i)
+    {
+        const LatencyHistogram& histogram = m_latency[i];
+        if(histogram.count() == 0)
+        {
+            continue;
+        }
+        for(int n = 0; n < LatencyHistogram::BUCKET_COUNT; ++n)
+        {
+            quint32 nCount = histogram.bucketCount(n);
+            if(nCount > 0)
+            {
+                out << CommandEncoder::spec(static_cast<CMD_TYPE>(i)).name << " " << LatencyHistogram::bucketUpperBound(n) << " " << nCount << endl;
+            }
+        }
+    }
+    return true;
+}
+
+bool LinkStats::classifyAscii(const char *line, int size, CMD_TYPE &cmd)
+{
+    //指令文本互不为前缀，取第一个匹配的
+    for(int i = 0; i <= SETKD; ++i)
+    {
+        const CommandSpec& spec = CommandEncoder::spec(static_cast<CMD_TYPE>(i));
+        if(size >= spec.textSize && std::memcmp(line, spec.text, spec.textSize) == 0)
+        {
+            cmd = static_cast<CMD_TYPE>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void LinkStats::pushCommand(CMD_TYPE cmd, qint64 timestampNs)
+{
+    ++m_commands[cmd];
+    if(m_nPendingCount == MAX_OUTSTANDING)
+    {
+        //最早的一条一直没有应答
+        m_nPendingHead = (m_nPendingHead + 1) % MAX_OUTSTANDING;
+        --m_nPendingCount;
+        ++m_nLost;
+    }
+    int nTail = (m_nPendingHead + m_nPendingCount) % MAX_OUTSTANDING;
+    m_pending[nTail].cmd = cmd;
+    m_pending[nTail].sentNs = timestampNs;
+    ++m_nPendingCount;
+}
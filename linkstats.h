@@ -0,0 +1,111 @@
+#ifndef LINKSTATS_H
+#define LINKSTATS_H
+
+#include <QMutex>
+#include <QAtomicInt>
+#include <QString>
+#include "commanddefs.h"
+#include "responseframer.h"
+
+// HDR风格的延迟直方图：小于16的值每个一格，之后每个2的幂区间再分16格
+// 任意值的相对误差不超过1/16，记录只是一次数组加法
+class LatencyHistogram
+{
+public:
+    static const int SUB_BUCKETS = 16;
+    //最大可记录2^36微秒，约19小时，更大的值记到最后一格
+    static const int MAX_MAGNITUDE = 36;
+    static const int BUCKET_COUNT = SUB_BUCKETS + (MAX_MAGNITUDE - 4) * SUB_BUCKETS;
+
+    LatencyHistogram();
+
+    void record(qint64 value);
+    void reset();
+
+    qint64 count() const { return m_nCount; }
+    qint64 max() const { return m_nMax; }
+    double mean() const { return m_nCount > 0 ? double(m_nSum) / m_nCount : 0; }
+
+    //第p百分位（0~1）所在格的上界
+    qint64 percentile(double p) const;
+    quint32 bucketCount(int index) const { return m_counts[index]; }
+
+    static int bucketIndex(qint64 value);
+    static qint64 bucketUpperBound(int index);
+
+private:
+    quint32 m_counts[BUCKET_COUNT];
+    qint64 m_nCount;
+    qint64 m_nSum;
+    qint64 m_nMax;
+};
+
+// 串口链路的计数器和延迟统计
+// 写出和收到应答都在串口线程记录，界面线程随时取报告，数据由互斥锁保护
+// 控制器按顺序逐条应答，发出的指令排成队列，收到ok、位姿或错误应答时和队首配对
+class LinkStats
+{
+public:
+    //未应答指令最多记这么多条，超出时丢弃最早的并计入丢失
+    static const int MAX_OUTSTANDING = 256;
+
+    LinkStats();
+
+    //主机线程把数据交给串口线程排队（任意线程）
+    void onQueued();
+    //串口线程从队列取出一次写入
+    void onDequeued();
+    //发送通道已满，指令被丢弃（任意线程）
+    void onRejected();
+    //写到串口，按协议拆出其中的指令
+    void onWritten(const char* data, int size, PROTOCOL_TYPE protocol, qint64 timestampNs, qint64 txBacklog);
+    void onBytesReceived(int size);
+    //返回与这一帧配对的指令CMD_TYPE，文本帧或没有待应答指令时返回-1
+    int onFrame(const ResponseFrame& frame);
+
+    void reset();
+
+    int queueDepth() const { return m_nQueued.load(); }
+    int outstanding() const;
+
+    //文本报告，诊断页显示和导出文件共用
+    QString report() const;
+    bool dump(const QString& filePath) const;
+
+    //一行ASCII指令对应的类型
+    static bool classifyAscii(const char* line, int size, CMD_TYPE& cmd);
+
+private:
+    void pushCommand(CMD_TYPE cmd, qint64 timestampNs);
+
+    struct PendingCommand
+    {
+        CMD_TYPE cmd;
+        qint64 sentNs;
+    };
+
+    mutable QMutex m_mutex;
+    QAtomicInt m_nQueued;
+    QAtomicInt m_nRejected;
+
+    qint64 m_nBytesOut = 0;
+    qint64 m_nBytesIn = 0;
+    qint64 m_nWrites = 0;
+    qint64 m_nFrames = 0;
+    qint64 m_nErrors = 0;
+    qint64 m_nUnmatched = 0;   //没有待应答指令时收到的应答
+    qint64 m_nLost = 0;        //一直没有应答、被挤出队列的指令
+    qint64 m_nTxBacklog = 0;   //最近一次写入时串口驱动里还没发出的字节
+    qint64 m_nMaxTxBacklog = 0;
+    qint64 m_commands[SETKD + 1];
+
+    PendingCommand m_pending[MAX_OUTSTANDING];
+    int m_nPendingHead = 0;
+    int m_nPendingCount = 0;
+
+    //发出到收到应答，微秒
+    LatencyHistogram m_latency[SETKD + 1];
+    LatencyHistogram m_totalLatency;
+};
+
+#endif // LINKSTATS_H
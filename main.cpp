@@ -1,11 +1,15 @@
 #include "mainwidget.h"
+#include "asynclogger.h"
 
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+    AsyncLogger::instance()->start(QThread::LowPriority);
     MainWidget w;
     w.show();
-    return a.exec();
+    int nRet = a.exec();
+    AsyncLogger::instance()->stop();
+    return nRet;
 }
@@ -5,12 +5,28 @@
 #include <QDebug>
 #include <QDateTime>
 #include <QDir>
+#include <QFileInfo>
 #include <QStandardPaths>
 #include <QSerialPortInfo>
 #include <QScreen>
 #include <QKeyEvent>
+#include <QAbstractButton>
 #include <QVector3D>
 #include <cmath>
+#include "commandencoder.h"
+#include "trajectorysimplifier.h"
+#include "arcgenerator.h"
+#include "asynclogger.h"
+#include <algorithm>
+
+//点动最大速度（速度滑块100%时）、加速度、加加速度
+//关节和姿态角单位为度，位置单位为mm
+#define JOINT_JOG_VELOCITY 30
+#define JOINT_JOG_ACCELERATION 120
+#define JOINT_JOG_JERK 1200
+#define LINE_JOG_VELOCITY 50
+#define LINE_JOG_ACCELERATION 200
+#define LINE_JOG_JERK 2000
 
 MainWidget::MainWidget(QWidget *parent)
     : QWidget(parent)
@@ -31,20 +47,31 @@ MainWidget::MainWidget(QWidget *parent)
     this->resize(800, 480);
 #endif
 
-    initMap();
     scanSerialPort();
     connect(m_serialSender, &SerialSender::signalReceived, this, &MainWidget::onDataReceived);
+    connect(m_serialSender, &SerialSender::signalFrameReceived, this, &MainWidget::onFrameReceived);
     connect(m_serialSender, &SerialSender::signalOpened, this, &MainWidget::onSerialOpened);
     connect(m_serialSender, &SerialSender::signalClosed, this, &MainWidget::onSerialClosed);
     connect(m_serialSender, &SerialSender::signalError, this, &MainWidget::onSerialError);
 
-    m_timer = new QTimer(this);
-    m_timer->setInterval(300);
-    connect(m_timer,&QTimer::timeout,this,&MainWidget::onSendGetLPosRequest);
+    m_scheduler = new MotionScheduler(m_serialSender, this);
+    connect(m_scheduler, &MotionScheduler::signalJogHalted, this, &MainWidget::onJogHalted);
 
-    m_runTimer = new QTimer(this);
-    m_runTimer->setInterval(20*(100/m_fSpeed));//应该和速度负相关
-    connect(m_runTimer,&QTimer::timeout,this,&MainWidget::onPlayRecord);
+    //回放和拖动示教在dummycore中实现，守护进程共用
+    m_player = new TrajectoryPlayer(m_serialSender, m_scheduler, this);
+    m_recorder = new TrajectoryRecorder(m_serialSender, this);
+    m_validation = new ValidationThread(Kinematics(), this);
+    connect(m_validation, &QThread::finished, this, &MainWidget::onValidationFinished);
+
+    m_statsTimer = new QTimer(this);
+    m_statsTimer->setInterval(200);
+    connect(m_statsTimer,&QTimer::timeout,this,&MainWidget::onUpdateStats);
+    m_statsTimer->start();
+
+    //心跳间隔远小于MotionScheduler::JOG_HEARTBEAT_TIMEOUT_MS，偶尔晚一两次不会误停
+    m_jogHeartbeatTimer = new QTimer(this);
+    m_jogHeartbeatTimer->setInterval(JOG_HEARTBEAT_MS);
+    connect(m_jogHeartbeatTimer,&QTimer::timeout,this,&MainWidget::onJogHeartbeat);
 
     updateFileList();
 
@@ -89,8 +116,6 @@ MainWidget::MainWidget(QWidget *parent)
     connect(m_posReduceBtnGroup,SIGNAL(buttonPressed(int)),this,SLOT(onPosReduceBtnPressed(int)));
     connect(m_posReduceBtnGroup,SIGNAL(buttonReleased(int)),this,SLOT(onTeachBtnReleased()));
 
-    m_teachTimer = new QTimer(this);
-    connect(m_teachTimer,&QTimer::timeout,this,&MainWidget::onTeaching);
 
     ui->addLine_groupBox->setDisabled(true);
     ui->addCircle_groupBox->setDisabled(true);
@@ -109,74 +134,45 @@ void MainWidget::onSerialError(const QString &strError)
 
 void MainWidget::onDataReceived(const QByteArray &data)
 {
-    ui->textBrowser->append(data);
-    QString strData = QString::fromLocal8Bit(data);
+    ui->console->appendData(data);
+}
 
-    if(m_bIsCreatePoint)
+void MainWidget::onFrameReceived(const ResponseFrame &frame)
+{
+    if(frame.type != FRAME_POSITION)
     {
-        if(strData.contains("ok") && (strData.size() > 30))
+        if(frame.type == FRAME_ERROR)
         {
-            strData.remove("ok");
-            qDebug() << "strData = " << strData << endl;
-            strData.replace("\r\n","");
-            ui->currentPos_label->setText(strData);
-            QStringList posList = strData.split(" ");
-            posList.removeAt(0);
-            setPointPos(posList);
-            qDebug() << posList;
+            m_bIsCreatePoint = false;
         }
-
-        m_bIsCreatePoint = false;
+        return;
     }
 
-    if(m_bIsRecording)
+    //串口线程已经把这一帧解析进RobotState，这里只读快照
+    RobotSnapshot state = m_serialSender->robotState()->snapshot();
+
+    if(m_bIsCreatePoint && frame.command == GETLPOS)
     {
-        //写示教记录
-        if(strData.contains("ok"))
-        {
-            strData.remove("ok");
-        }
-        writeRecordFile(strData.toUtf8());
+        AsyncLogger::logData(LOG_DEBUG, "point reply %1 bytes: %2", frame.payload(), frame.payloadSize());
+        ui->currentPos_label->setText(formatValues(state.pose));
+        setPointPos(state.pose);
+
+        m_bIsCreatePoint = false;
     }
 
     if(m_bIsTeaching)
     {
-        if(m_curTeachType == MOVE_JOINT)
+        if(m_curTeachType == MOVE_JOINT && frame.command == GETJPOS)
         {
-            if(strData.contains("ok") && (strData.size() > 30))
-            {
-                strData.remove("ok");
-                qDebug() << "strData = " << strData << endl;
-                strData.replace("\r\n","");
-                ui->currentAngle_label->setText(strData);
-                QStringList angleList = strData.split(" ");
-                angleList.removeAt(0);
-
-                angleList.append(QString::number(m_fSpeed));
-                qDebug() << "angleList = " << angleList << endl;
-                m_CurAngleList = angleList;
-
-                m_teachTimer->start();
-
-            }
-        }else if(m_curTeachType == MOVE_LINE)
+            AsyncLogger::logData(LOG_DEBUG, "joint reply %1 bytes: %2", frame.payload(), frame.payloadSize());
+            ui->currentAngle_label->setText(formatValues(state.joints));
+            //连杆参数还没和控制器对上，位姿仍只显示GETLPOS的应答，不用正解代替
+            startJog(state.joints);
+        }else if(m_curTeachType == MOVE_LINE && frame.command == GETLPOS)
         {
-            if(strData.contains("ok") && (strData.size() > 30))
-            {
-                strData.remove("ok");
-                qDebug() << "strData = " << strData << endl;
-                strData.replace("\r\n","");
-                ui->currentPos_label->setText(strData);
-                QStringList posList = strData.split(" ");
-                posList.removeAt(0);
-
-                posList.append(QString::number(m_fSpeed));
-
-                m_CurPosList = posList;
-
-                m_teachTimer->start();
-
-            }
+            AsyncLogger::logData(LOG_DEBUG, "pose reply %1 bytes: %2", frame.payload(), frame.payloadSize());
+            ui->currentPos_label->setText(formatValues(state.pose));
+            startJog(state.pose);
         }
     }
 }
@@ -196,49 +192,94 @@ void MainWidget::onSerialClosed()
 
 void MainWidget::onSendGetLPosRequest()
 {
-    m_serialSender->sendDatas(constructCmd(GETLPOS));
+    sendCmd(GETLPOS);
 }
 
-void MainWidget::onTeaching()
+void MainWidget::startJog(const float *start)
 {
+    //重复的位置应答不能让正在进行的点动回到旧位置
+    if(m_scheduler->isJogging())
+    {
+        return;
+    }
+    //回放中不点动，两边的MOVEL会交错发出；停止复现后可以从原位置继续
+    if(m_player->isPlaying())
+    {
+        refuseJog();
+        return;
+    }
+
+    //点动由调度线程按固定周期推进并发送，界面线程只负责开始、心跳和停止
+    CMD_TYPE cmd = (m_curTeachType == MOVE_JOINT) ? MOVEJ : MOVEL;
+    int nAxis = (m_curTeachType == MOVE_JOINT) ? m_nCurOpJoint : m_nCurOpPos;
+    int nDirection = (m_curOperateType == ADD_VALUE) ? 1 : -1;
+    JogGenerator jog;
+    jog.start(start, nAxis, nDirection, jogLimits(nAxis));
     if(m_curTeachType == MOVE_JOINT)
     {
-        //qDebug() << " m_CurAngleList = " << m_CurAngleList << endl;
-        if(m_curOperateType == ADD_VALUE)
-        {
-            m_CurAngleList.replace(m_nCurOpJoint,QString::number(m_CurAngleList[m_nCurOpJoint].toFloat() + 1));
-        }else{
-            m_CurAngleList.replace(m_nCurOpJoint,QString::number(m_CurAngleList[m_nCurOpJoint].toFloat() - 1));
-        }
-        //qDebug() << " m_CurAngleList = " << m_CurAngleList << endl;
+        //关节点动在固件限位前减速停下
+        jog.setBounds(JOINT_LIMIT_MIN[nAxis], JOINT_LIMIT_MAX[nAxis]);
+    }
+    if(!m_scheduler->startJog(cmd, m_serialSender->protocol(), jog, m_fSpeed))
+    {
+        refuseJog();
+    }
+}
+
+void MainWidget::refuseJog()
+{
+    m_bIsTeaching = false;
+    m_jogHeartbeatTimer->stop();
+    ui->console->appendLine(QStringLiteral("复现中不能点动，请先停止复现"));
+}
 
-        m_CurAngleList.replace(6,QString::number(m_fSpeed));
-        qDebug() << " m_CurAngleList = " << m_CurAngleList << endl;
-        ui->currentAngle_label->setText(m_CurAngleList.join(","));
-        m_serialSender->sendDatas(constructCmd(MOVEJ,m_CurAngleList));
-    }else
+ProfileLimits MainWidget::jogLimits(int axis) const
+{
+    ProfileLimits limits;
+    if(m_curTeachType == MOVE_LINE && axis < 3)
     {
-        if(m_curOperateType == ADD_VALUE)
-        {
-            m_CurPosList.replace(m_nCurOpPos,QString::number(m_CurPosList[m_nCurOpPos].toFloat() + 1));
-        }else{
-            m_CurPosList.replace(m_nCurOpPos,QString::number(m_CurPosList[m_nCurOpPos].toFloat() - 1));
-        }
-        m_CurPosList.replace(6,QString::number(m_fSpeed));
-        //qDebug() << " m_CurPosList = " << m_CurPosList << endl;
-        ui->currentPos_label->setText(m_CurPosList.join(","));
-        m_serialSender->sendDatas(constructCmd(MOVEL,m_CurPosList));
+        limits.maxVelocity = LINE_JOG_VELOCITY;
+        limits.maxAcceleration = LINE_JOG_ACCELERATION;
+        limits.maxJerk = LINE_JOG_JERK;
+    }else{
+        limits.maxVelocity = JOINT_JOG_VELOCITY;
+        limits.maxAcceleration = JOINT_JOG_ACCELERATION;
+        limits.maxJerk = JOINT_JOG_JERK;
+    }
+    limits.maxVelocity *= m_fSpeed / 100;
+    return limits;
+}
+
+void MainWidget::showJogSetpoint()
+{
+    float values[6];
+    m_scheduler->jogSetpoint(values);
+    if(m_curTeachType == MOVE_JOINT)
+    {
+        ui->currentAngle_label->setText(formatValues(values));
+    }else{
+        ui->currentPos_label->setText(formatValues(values));
     }
 }
 
+QString MainWidget::formatValues(const float *values)
+{
+    QStringList valueList;
+    for(int i = 0; i < 6; ++i)
+    {
+        valueList << QString::number(values[i], 'f', 2);
+    }
+    return valueList.join(' ');
+}
+
 void MainWidget::sendTeachGetRequest()
 {
     if(m_curTeachType == MOVE_JOINT)
     {
-        m_serialSender->sendDatas(constructCmd(GETJPOS));
+        sendCmd(GETJPOS);
     }else if(m_curTeachType == MOVE_LINE)
     {
-        m_serialSender->sendDatas(constructCmd(GETLPOS));
+        sendCmd(GETLPOS);
     }
 }
 
@@ -247,11 +288,8 @@ void MainWidget::keyPressEvent(QKeyEvent *event)
 #if __arm__
     //判断按下的按键，也就是板子 KEY0 按键
     if(event->key() == Qt::Key_VolumeDown) {
-        m_serialSender->sendDatas(constructCmd(STOP));
-        if(m_runTimer->isActive())
-        {
-            m_runTimer->stop();
-        }
+        sendCmd(STOP);
+        stopPlayback();
     }
 #endif
 
@@ -264,14 +302,14 @@ void MainWidget::keyReleaseEvent(QKeyEvent *event)
     QWidget::keyReleaseEvent(event);
 }
 
-void MainWidget::setPointPos(const QStringList & posList)
+void MainWidget::setPointPos(const float* pose)
 {
     if(m_CurCreatePoint == LINE_START)
     {
         m_lineStart.clear();
         for(int i = 0; i < 6; ++i)
         {
-            m_lineStart << posList.at(i).toFloat();
+            m_lineStart << pose[i];
         }
         ui->lineStart_Btn->setStyleSheet("background-color: rgb(0, 255, 0);");
     }else if(m_CurCreatePoint == LINE_END)
@@ -279,7 +317,7 @@ void MainWidget::setPointPos(const QStringList & posList)
         m_lineEnd.clear();
         for(int i = 0; i < 6; ++i)
         {
-            m_lineEnd << posList.at(i).toFloat();
+            m_lineEnd << pose[i];
         }
         ui->lineEnd_Btn->setStyleSheet("background-color: rgb(0, 255, 0);");
     }else if(m_CurCreatePoint == CIRCLE_START)
@@ -288,7 +326,7 @@ void MainWidget::setPointPos(const QStringList & posList)
         m_circleStart.clear();
         for(int i = 0; i < 6; ++i)
         {
-            m_circleStart << posList.at(i).toFloat();
+            m_circleStart << pose[i];
         }
         ui->circleStart_Btn->setStyleSheet("background-color: rgb(0, 255, 0);");
     }else if(m_CurCreatePoint == CIRCLE_CENTER)
@@ -296,7 +334,7 @@ void MainWidget::setPointPos(const QStringList & posList)
         m_circleCenter.clear();
         for(int i = 0; i < 6; ++i)
         {
-            m_circleCenter << posList.at(i).toFloat();
+            m_circleCenter << pose[i];
         }
         ui->circleCenter_Btn->setStyleSheet("background-color: rgb(0, 255, 0);");
     }else if(m_CurCreatePoint == CIRCLE_END)
@@ -304,39 +342,66 @@ void MainWidget::setPointPos(const QStringList & posList)
         m_circleEnd.clear();
         for(int i = 0; i < 6; ++i)
         {
-            m_circleEnd << posList.at(i).toFloat();
+            m_circleEnd << pose[i];
         }
         ui->circleEnd_Btn->setStyleSheet("background-color: rgb(0, 255, 0);");
     }
 }
 
-void MainWidget::onPlayRecord()
+void MainWidget::onUpdateStats()
 {
-    if(!m_cmdQueue.isEmpty())
+    SchedulerStats stats = m_scheduler->stats();
+    if(stats.ticks > 0)
     {
-        QString strData = QString::fromUtf8(m_cmdQueue.dequeue());
-       // qDebug() << "m_cmdQueue.data = " << strData << endl;
-        strData.replace(' ',',');
-        strData.remove(1,1);
-        strData += ",";
-        strData += QString::number(m_fSpeed);
-        strData += "\r\n";
-        QByteArray data = strData.toUtf8();
-        qDebug() << " data = " << data;
-        m_serialSender->sendDatas(data);
-        m_nReadLines++;
-    }else{
-        m_runTimer->stop();
+        ui->jitter_label->setText(QString("周期 %1ms 抖动 均值%2us 最大%3us 超时%4 推迟%5")
+                                  .arg(stats.periodUs / 1000.0)
+                                  .arg(stats.meanLateUs, 0, 'f', 0)
+                                  .arg(stats.maxLateUs)
+                                  .arg(stats.overruns)
+                                  .arg(stats.blocked));
+    }
+
+    //诊断页可见时才生成报告
+    if(ui->tabWidget->currentWidget() == ui->tab_6)
+    {
+        AsyncLogger* logger = AsyncLogger::instance();
+        ui->linkStats_textEdit->setPlainText(m_serialSender->linkStats()->report()
+                                             + QString("\nlog: written %1, dropped %2\n")
+                                             .arg(logger->writtenCount())
+                                             .arg(logger->droppedCount()));
+    }
+
+    if(m_scheduler->isJogging())
+    {
+        showJogSetpoint();
     }
 }
 
+QString MainWidget::recordFilePath(const QString &fileName) const
+{
+    QString documentsPath = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+    return documentsPath + "/TeachRecords/" + fileName;
+}
+
+void MainWidget::startPlayback(int fromIndex)
+{
+    QString filePath = recordFilePath(ui->listWidget->currentItem()->text());
+    qDebug() << "read filepath = " << filePath << endl;
+    m_player->start(filePath, fromIndex, ui->window_spinBox->value(), m_fSpeed);
+}
+
+void MainWidget::stopPlayback()
+{
+    m_player->stop();
+}
+
 void MainWidget::onJointAddBtnPressed(int nJoint)
 {
     m_bIsTeaching = true;
     m_curTeachType = MOVE_JOINT;
     m_curOperateType = ADD_VALUE;
-    m_teachTimer->setInterval(40*(100/m_fSpeed));
     m_nCurOpJoint = nJoint;
+    m_jogHeartbeatTimer->start();
     sendTeachGetRequest();
 }
 
@@ -345,8 +410,8 @@ void MainWidget::onJointRecudeBtnPressed(int nJoint)
     m_bIsTeaching = true;
     m_curTeachType = MOVE_JOINT;
     m_curOperateType = REDUCE_VALUE;
-    m_teachTimer->setInterval(40*(100/m_fSpeed));
     m_nCurOpJoint = nJoint;
+    m_jogHeartbeatTimer->start();
     sendTeachGetRequest();
 }
 
@@ -355,8 +420,8 @@ void MainWidget::onPosAddBtnPressed(int nPos)
     m_bIsTeaching = true;
     m_curTeachType = MOVE_LINE;
     m_curOperateType = ADD_VALUE;
-    m_teachTimer->setInterval(40*(100/m_fSpeed));
     m_nCurOpPos = nPos;
+    m_jogHeartbeatTimer->start();
     sendTeachGetRequest();
 }
 
@@ -365,20 +430,60 @@ void MainWidget::onPosReduceBtnPressed(int nPos)
     m_bIsTeaching = true;
     m_curTeachType = MOVE_LINE;
     m_curOperateType = REDUCE_VALUE;
-    m_teachTimer->setInterval(40*(100/m_fSpeed));
     m_nCurOpPos = nPos;
+    m_jogHeartbeatTimer->start();
     sendTeachGetRequest();
 }
 
 void MainWidget::onTeachBtnReleased()
 {
     m_bIsTeaching = false;
-    if(m_teachTimer->isActive())
+    m_jogHeartbeatTimer->stop();
+    if(m_scheduler->isJogging())
     {
-        m_teachTimer->stop();
+        m_scheduler->stopJog();
+        //显示点动停止时的设定值，下次点动会重新读取实际位置
+        showJogSetpoint();
     }
 }
 
+void MainWidget::onJogHeartbeat()
+{
+    QButtonGroup* group;
+    int nIndex;
+    if(m_curTeachType == MOVE_JOINT)
+    {
+        group = (m_curOperateType == ADD_VALUE) ? m_jointAddBtnGroup : m_jointReduceBtnGroup;
+        nIndex = m_nCurOpJoint;
+    }else{
+        group = (m_curOperateType == ADD_VALUE) ? m_posAddBtnGroup : m_posReduceBtnGroup;
+        nIndex = m_nCurOpPos;
+    }
+
+    //没有收到松开事件但按键已经弹起（如弹窗抢走了鼠标），按松开处理
+    QAbstractButton* button = group->button(nIndex);
+    if(!m_bIsTeaching || !button || !button->isDown())
+    {
+        onTeachBtnReleased();
+        return;
+    }
+    m_scheduler->jogHeartbeat();
+}
+
+void MainWidget::onJogHalted(bool bHeartbeatLost)
+{
+    if(bHeartbeatLost)
+    {
+        //界面线程曾经卡住，即使按键还按着也要重新按下才继续
+        qDebug() << "jog halted: heartbeat lost";
+        m_bIsTeaching = false;
+        m_jogHeartbeatTimer->stop();
+    }else{
+        qDebug() << "jog halted: joint limit";
+    }
+    showJogSetpoint();
+}
+
 void MainWidget::on_connect_Btn_clicked()
 {
     //ui->connect_Btn->setStyleSheet("background-color: rgb(0, 255, 0);");
@@ -387,25 +492,26 @@ void MainWidget::on_connect_Btn_clicked()
         m_serialSender->close();
         return;
     }
-    m_serialSender->open(ui->comboBox->currentText(),115200);
+    m_serialSender->open(ui->comboBox->currentText(),115200,
+                         static_cast<PROTOCOL_TYPE>(ui->protocol_cbBox->currentIndex()));
 }
 
 void MainWidget::on_start_Btn_clicked()
 {
     qDebug() << __FUNCTION__ << endl;
-    m_serialSender->sendDatas(constructCmd(START));
+    sendCmd(START);
 }
 
 void MainWidget::on_stop_Btn_clicked()
 {
     qDebug() << __FUNCTION__ << endl;
-    m_serialSender->sendDatas(constructCmd(STOP));
+    sendCmd(STOP);
 }
 
 void MainWidget::on_home_Btn_clicked()
 {
     qDebug() << __FUNCTION__ << endl;
-    m_serialSender->sendDatas(constructCmd(HOME));
+    sendCmd(HOME);
 }
 
 void MainWidget::scanSerialPort()
@@ -415,70 +521,61 @@ void MainWidget::scanSerialPort()
              QSerialPortInfo::availablePorts()) {
         ui->comboBox->addItem(info.portName());
     }
+    ui->comboBox->addItem(LOOPBACK_PORT_NAME);
 }
 
-void MainWidget::initMap()
+PathOptions MainWidget::pathOptions() const
 {
-    m_CmdMap.insert(STOP,QStringLiteral("!STOP"));
-    m_CmdMap.insert(START,QStringLiteral("!START"));
-    m_CmdMap.insert(HOME,QStringLiteral("!HOME"));
-    m_CmdMap.insert(CALIBRATION,QStringLiteral("!CALIBRATION"));
-    m_CmdMap.insert(RESET,QStringLiteral("!RESET"));
-    m_CmdMap.insert(DISABLE,QStringLiteral("!DISABLE"));
-    m_CmdMap.insert(GETJPOS,QStringLiteral("#GETJPOS"));
-    m_CmdMap.insert(GETLPOS,QStringLiteral("#GETLPOS"));
-    m_CmdMap.insert(CMDMODE,QStringLiteral("#CMDMODE")); //有参数 lu
-    m_CmdMap.insert(MOVEJ,QStringLiteral("&"));
-    m_CmdMap.insert(MOVEL,QStringLiteral("@"));
-    m_CmdMap.insert(SETKP,QStringLiteral("#SET_DCE_KP"));
-    m_CmdMap.insert(SETKI,QStringLiteral("#SET_DCE_KI"));
-    m_CmdMap.insert(SETKD,QStringLiteral("#SET_DCE_KD"));
+    PathOptions options;
+    options.profile = static_cast<PROFILE_TYPE>(ui->profile_cbBox->currentIndex());
+    options.limits.maxVelocity = ui->pathSpeed_spinBox->value();
+    //加速度和加加速度按速度的比例给出，速度越高加减速越快
+    options.limits.maxAcceleration = options.limits.maxVelocity * 4;
+    options.limits.maxJerk = options.limits.maxAcceleration * 10;
+    options.segmentLength = ui->segmentLength_spinBox->value();
+    return options;
 }
 
-void MainWidget::writeRecordFile(const QByteArray& data)
+void MainWidget::appendPathLine(const float *start, const float *end)
 {
-    if(m_recordFile.isOpen())
+    if(!m_pathWriter.isOpen())
     {
-        QTextStream stream(&m_recordFile);
-        stream << data ;
-        stream.flush();
-        qDebug() << "write data to file" << endl;
-    }
-}
-
-void MainWidget::readRecordFile(const QString& fileName)
-{
-    QString documentsPath = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
-    QString directoryPath = documentsPath + "/TeachRecords";
-    QString filePath = directoryPath + "/" + fileName;
-    QFile file(filePath);
-    qDebug() << "read filepath = " << filePath << endl;
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qDebug() << "Failed to open playback file:" << filePath;
         return;
     }
 
-    // 清空队列
-    m_cmdQueue.clear();
-
-    // 解析文件内容
-    QTextStream in(&file);
-    while (!in.atEnd()) {
-        //如果是继续运动，跳过之前已经运行过的
-        if(m_nReadLines > 0)
+    PathOptions options = pathOptions();
+    QVector<TrajectoryRecord> points;
+    if(m_pathWriter.count() == 0)
+    {
+        TrajectoryRecord first;
+        for(int i = 0; i < 6; ++i)
         {
-            for(int i = 0; i < m_nReadLines; ++i)
-            {
-                in.readLine();
-            }
+            first.pose[i] = start[i];
         }
+        first.timestampMs = 0;
+        first.speed = 0;
+        first.flags = RECORD_FLAG_SEGMENT_START;
+        points.append(first);
+    }else{
+        //从上一段的终点过渡到这一段的起点
+        LinearGenerator::generate(m_lastPathPose, start, options, m_nPathTimeMs, points);
+    }
+    quint32 nTimeMs = points.isEmpty() ? m_nPathTimeMs : points.last().timestampMs;
+    LinearGenerator::generate(start, end, options, nTimeMs, points);
 
-        QString line = in.readLine();
-        QByteArray cmdData = QString("@"+line).toUtf8();
-        m_cmdQueue.enqueue(cmdData);
-        //qDebug() << "enqueue data = " << cmdData;
+    for(int i = 0; i < points.size(); ++i)
+    {
+        m_pathWriter.append(points.at(i));
+    }
+    if(!points.isEmpty())
+    {
+        m_nPathTimeMs = points.last().timestampMs;
+    }
+    for(int i = 0; i < 6; ++i)
+    {
+        m_lastPathPose[i] = end[i];
     }
-    file.close();
+    qDebug() << "append path points:" << points.size() << "total time ms:" << m_nPathTimeMs;
 }
 
 void MainWidget::updateFileList()
@@ -497,119 +594,27 @@ void MainWidget::updateFileList()
 
 QByteArray MainWidget::constructCmd(CMD_TYPE cmd, const QStringList &paraList)
 {
-    QString strCmd;
-    strCmd = m_CmdMap.value(cmd);
-    switch (cmd) {
-    case CMD_TYPE::STOP:
+    float values[MAX_CMD_VALUES] = {0};
+    int nCount = qMin(paraList.size(), MAX_CMD_VALUES);
+    for(int i = 0; i < nCount; ++i)
     {
-        strCmd += "\r\n";
-        return QByteArray(strCmd.toUtf8());
-        break;
-    }
-    case CMD_TYPE::START:
-    {
-        strCmd += "\r\n";
-        return QByteArray(strCmd.toUtf8());
-        break;
-    }
-    case CMD_TYPE::HOME:
-    {
-        strCmd += "\r\n";
-        return QByteArray(strCmd.toUtf8());
-        break;
-    }
-    case CMD_TYPE::RESET:
-    {
-        strCmd += "\r\n";
-        return QByteArray(strCmd.toUtf8());
-        break;
-    }
-    case CMD_TYPE::DISABLE:
-    {
-        strCmd += "\r\n";
-        return QByteArray(strCmd.toUtf8());
-        break;
-    }
-    case CMD_TYPE::GETJPOS:
-    {
-        strCmd += "\r\n";
-        return QByteArray(strCmd.toUtf8());
-        break;
-    }
-    case CMD_TYPE::GETLPOS:
-    {
-        strCmd += "\r\n";
-        return QByteArray(strCmd.toUtf8());
-        break;
-    }
-    case CMD_TYPE::CMDMODE:
-    {
-        strCmd += paraList.at(0);
-        strCmd += "\r\n";
-        return QByteArray(strCmd.toUtf8());
-        break;
-    }
-    case CMD_TYPE::MOVEJ:
-    {
-        for(int i = 0; i < paraList.size(); ++i)
-        {
-            strCmd += paraList.at(i);
-            if(i == paraList.size() - 1) break;
-            strCmd += ",";
-        }
-        strCmd += "\r\n";
-        qDebug() << "strCmd = " << strCmd;
-        return QByteArray(strCmd.toUtf8());
-        break;
-    }case CMD_TYPE::MOVEL:
-    {
-        for(int i = 0; i < paraList.size(); ++i)
-        {
-            strCmd += paraList.at(i);
-            if(i == paraList.size() - 1) break;
-            strCmd += ",";
-        }
-        strCmd += "\r\n";
-        qDebug() << "strCmd = " << strCmd;
-        return QByteArray(strCmd.toUtf8());
-        break;
-    }case CMD_TYPE::SETKP:
-    {
-        for(int i = 0; i < paraList.size(); ++i)
-        {
-            strCmd += " ";
-            strCmd += paraList.at(i);
-        }
-        strCmd += "\r\n";
-        return QByteArray(strCmd.toUtf8());
-        break;
-    }case CMD_TYPE::SETKI:
-    {
-        for(int i = 0; i < paraList.size(); ++i)
-        {
-            strCmd += " ";
-            strCmd += paraList.at(i);
-        }
-        strCmd += "\r\n";
-        return QByteArray(strCmd.toUtf8());
-        break;
-    }case CMD_TYPE::SETKD:
-    {
-        for(int i = 0; i < paraList.size(); ++i)
-        {
-            strCmd += " ";
-            strCmd += paraList.at(i);
-        }
-        strCmd += "\r\n";
-        return QByteArray(strCmd.toUtf8());
-        break;
+        values[i] = paraList.at(i).toFloat();
     }
 
-    default:
-        return QByteArray();
-        break;
-    }
+    char buf[CommandEncoder::MAX_CMD_SIZE];
+    int nSize = CommandEncoder::encode(m_serialSender->protocol(), cmd, values, nCount, buf, sizeof(buf));
+    return QByteArray(buf, nSize);
+}
 
+void MainWidget::sendCmd(CMD_TYPE cmd, const float *values, int count)
+{
+    //直接编码到栈上的缓冲区
+    char buf[CommandEncoder::MAX_CMD_SIZE];
+    int nSize = CommandEncoder::encode(m_serialSender->protocol(), cmd, values, count, buf, sizeof(buf));
+    if(nSize > 0)
+    {
+        m_serialSender->sendDatas(buf, nSize);
+    }
 }
 
 void MainWidget::on_dragTeach_Btn_clicked()
@@ -624,26 +629,43 @@ void MainWidget::on_dragTeach_Btn_clicked()
 
     // 2. 生成安全的文件名
     QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
-    QString filename = QString("teach_record_%1.txt").arg(timestamp);
+    QString filename = QString("teach_record_%1.%2").arg(timestamp).arg(TRAJECTORY_SUFFIX);
     QString filePath = recordsDir.filePath(filename);
 
-    m_recordFile.setFileName(filePath);
-    if (!m_recordFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
-        qDebug() << "Failed to open record file:" << filename;
+    if (!m_recorder->start(filePath, ui->pollInterval_spinBox->value())) {
         return;
     }
 
-    m_bIsRecording = true;
-    m_timer->start();
     ui->dragTeach_Btn->setDisabled(true);
     ui->stopDragTeach_Btn->setDisabled(false);
 }
 
 void MainWidget::on_stopDragTeach_Btn_clicked()
 {
-    m_recordFile.close();
-    m_bIsRecording = false;
-    m_timer->stop();
+    QString filePath = m_recorder->fileName();
+    bool bHasSamples = m_recorder->stop() > 0;
+
+    //去掉静止点和共线点，减少回放时的指令数
+    SimplifyResult result;
+    if(bHasSamples)
+    {
+        QString strInfo;
+        if(TrajectorySimplifier::simplifyFile(filePath, SimplifyOptions(), result))
+        {
+            strInfo = QString("simplify %1: %2 -> %3 points (%4 stationary removed)")
+                    .arg(QFileInfo(filePath).fileName())
+                    .arg(result.inputCount)
+                    .arg(result.outputCount)
+                    .arg(result.stationaryRemoved);
+        }else{
+            //原记录没有被替换，仍可回放
+            strInfo = QString("simplify %1 failed, original recording kept")
+                    .arg(QFileInfo(filePath).fileName());
+        }
+        qDebug() << strInfo;
+        ui->console->appendLine(strInfo);
+    }
+
     ui->dragTeach_Btn->setDisabled(false);
     ui->stopDragTeach_Btn->setDisabled(true);
     updateFileList();
@@ -651,7 +673,7 @@ void MainWidget::on_stopDragTeach_Btn_clicked()
 
 void MainWidget::on_disable_Btn_clicked()
 {
-    m_serialSender->sendDatas(constructCmd(DISABLE));
+    sendCmd(DISABLE);
 }
 
 void MainWidget::on_reapper_Btn_clicked()
@@ -659,27 +681,61 @@ void MainWidget::on_reapper_Btn_clicked()
     if(ui->listWidget->currentRow() < 0)
         return;
 
-    m_nReadLines = 0;
-    readRecordFile(ui->listWidget->currentItem()->text());
-    m_runTimer->start();
+    //预检要勾选才做：连杆参数未校准（见ArmGeometry），逆解的结论不一定准
+    if(!ui->preflight_checkBox->isChecked())
+    {
+        startPlayback(0);
+        return;
+    }
+    //整条轨迹在后台线程检查，文本记录的转换也在那里做，通过后再回放
+    QString filePath = recordFilePath(ui->listWidget->currentItem()->text());
+    if(!m_validation->check(filePath, ValidationOptions()))
+    {
+        ui->console->appendLine("pre-flight still running");
+        return;
+    }
+    ui->reapper_Btn->setEnabled(false);
+}
+
+void MainWidget::onValidationFinished()
+{
+    ui->reapper_Btn->setEnabled(true);
+    ValidationResult result = m_validation->result();
+    QString strInfo = QString("pre-flight %1: %2")
+            .arg(QFileInfo(m_validation->filePath()).fileName())
+            .arg(TrajectoryValidator::describe(result));
+    ui->console->appendLine(strInfo);
+    if(result.error != VALIDATION_OK)
+    {
+        QMessageBox::warning(this, QStringLiteral("tips"), strInfo);
+        return;
+    }
+
+    //预检期间换了选中的记录就不回放
+    if(ui->listWidget->currentRow() < 0
+            || recordFilePath(ui->listWidget->currentItem()->text()) != m_validation->filePath())
+    {
+        return;
+    }
+    startPlayback(0);
 }
 
 void MainWidget::on_continueReappear_Btn_clicked()
 {
     if(ui->listWidget->currentRow() < 0)
         return;
-    readRecordFile(ui->listWidget->currentItem()->text());
-    m_runTimer->start();
+    //从上次停止的记录继续
+    startPlayback(m_player->playIndex());
 }
 
 void MainWidget::on_stopReappear_Btn_clicked()
 {
-    m_runTimer->stop();
+    stopPlayback();
 }
 
 void MainWidget::on_getJPos_Btn_clicked()
 {
-    m_serialSender->sendDatas(constructCmd(GETJPOS));
+    sendCmd(GETJPOS);
 }
 
 void MainWidget::on_rest_Btn_clicked()
@@ -690,7 +746,7 @@ void MainWidget::on_rest_Btn_clicked()
 
 void MainWidget::on_getLPos_Btn_clicked()
 {
-    m_serialSender->sendDatas(constructCmd(GETLPOS));
+    sendCmd(GETLPOS);
 }
 
 //void MainWidget::on_speedSlider_sliderMoved(int position)
@@ -706,6 +762,9 @@ void MainWidget::on_deleteRecord_Btn_clicked()
     QString directoryPath = documentsPath + "/TeachRecords";
     QString filePath = directoryPath + "/" + fileName;
 
+    //正在回放的文件先停止，同时删除文本记录的二进制缓存
+    stopPlayback();
+    TrajectoryFile::removeCaches(filePath);
     if(QFile::remove(filePath))
     {
         QMessageBox::information(this,QStringLiteral("tips"),QStringLiteral("delete file success!"));
@@ -725,14 +784,15 @@ void MainWidget::on_startCreateTrajectory_Btn_clicked()
 
     // 2. 生成安全的文件名
     QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
-    QString filename = QString("teach_record_%1.txt").arg(timestamp);
+    QString filename = QString("teach_record_%1.%2").arg(timestamp).arg(TRAJECTORY_SUFFIX);
     QString filePath = recordsDir.filePath(filename);
 
-    m_recordFile.setFileName(filePath);
-    if (!m_recordFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    //插补点带时间戳，回放时按规划的速度发送
+    if (!m_pathWriter.open(filePath)) {
         qDebug() << "Failed to open record file:" << filename;
         return;
     }
+    m_nPathTimeMs = 0;
 
     ui->addLine_groupBox->setDisabled(false);
     ui->addCircle_groupBox->setDisabled(false);
@@ -764,71 +824,8 @@ void MainWidget::on_addLine_Btn_clicked()
         return;
     }
 
-    /*
-    float segmentLength = 1;
-
-    //计算空间中两点的距离
-    QVector3D startPoint = {m_lineStart.at(0),m_lineStart.at(1),m_lineStart.at(2)};
-    QVector3D endPoint = {m_lineEnd.at(0),m_lineEnd.at(1),m_lineEnd.at(2)};
-    float fDistance = startPoint.distanceToPoint(endPoint);
-
-    //将距离等分
-    int segmentCount = static_cast<int>(std::ceil(fDistance / segmentLength));
-    // 计算方向向量
-    QVector3D direction = (endPoint - startPoint).normalized();
-
-    QVector<QVector3D> result;
-
-    // 生成分割点
-    for (int i = 0; i <= segmentCount; ++i) {
-        float currentDistance = i * segmentLength;
-        if (currentDistance > fDistance) {
-            currentDistance = fDistance; // 确保不超过总距离
-        }
-        QVector3D currentPoint = startPoint + direction * currentDistance;
-        result.append(currentPoint);
-    }
-
-//    for(auto point : result)
-//    {
-//        qDebug() << point.x() << point.y() << point.z();
-//    }
-
-    //构建轨迹
-    QString strPoint;
-    for(auto point : result)
-    {
-        //qDebug() << point.x() << point.y() << point.z();
-        strPoint.clear();
-        strPoint += QString(" %1 %2 %3 %4 %5 %6").arg(point.x())
-                .arg(point.y())
-                .arg(point.z())
-                .arg(m_lineStart.at(3))
-                .arg(m_lineStart.at(4))
-                .arg(m_lineStart.at(5));
-        strPoint += "\r\n";
-        writeRecordFile(strPoint.toUtf8());
-    }
-    */
-    QString strPoint = QString(" %1 %2 %3 %4 %5 %6")
-                               .arg(m_lineStart.at(0))
-                               .arg(m_lineStart.at(1))
-                                .arg(m_lineStart.at(2))
-                                .arg(m_lineStart.at(3))
-                                .arg(m_lineStart.at(4))
-                                .arg(m_lineStart.at(5));
-    writeRecordFile(strPoint.toUtf8());
-
-    strPoint.clear();
-
-    strPoint = QString(" %1 %2 %3 %4 %5 %6")
-                               .arg(m_lineEnd.at(0))
-                               .arg(m_lineEnd.at(1))
-                                .arg(m_lineEnd.at(2))
-                                .arg(m_lineEnd.at(3))
-                                .arg(m_lineEnd.at(4))
-                                .arg(m_lineEnd.at(5));
-    writeRecordFile(strPoint.toUtf8());
+    //按速度规划插补，长直线上保持恒定的末端速度
+    appendPathLine(m_lineStart.constData(), m_lineEnd.constData());
 
     ui->lineEnd_Btn->setStyleSheet("");
     ui->lineStart_Btn->setStyleSheet("");
@@ -837,7 +834,7 @@ void MainWidget::on_addLine_Btn_clicked()
 
 void MainWidget::on_newTrajectory_Btn_clicked()
 {
-    m_recordFile.close();
+    m_pathWriter.close();
     updateFileList();
 }
 
@@ -865,59 +862,6 @@ void MainWidget::on_circleEnd_Btn_clicked()
     onSendGetLPosRequest();
 }
 
-/**
- * @brief 生成圆轨迹上的位置点
- * @param center 圆心坐标
- * @param point1 圆上第一个点
- * @param point2 圆上第二个点
- * @param numPoints 要生成的轨迹点数
- * @return QList<QVector3D> 轨迹点位置列表
- */
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-QList<QVector3D> MainWidget::generateCirclePoints(
-    const QVector3D &center,
-    const QVector3D &point1,
-    const QVector3D &point2,
-    int numPoints)
-{
-    QList<QVector3D> points;
-
-    // 计算圆平面法向量
-    QVector3D v1 = point1 - center;
-    QVector3D v2 = point2 - center;
-    QVector3D normal = QVector3D::crossProduct(v1, v2);
-
-    // 检查三点是否共线
-    if (normal.length() < 1e-6) {
-        qWarning() << "三点共线，无法确定圆平面";
-        return points; // 返回空列表
-    }
-    normal.normalize();
-
-    // 计算半径（使用 point1 到圆心的距离）
-    float radius = v1.length();
-
-    // 构建局部坐标系
-    QVector3D u = v1.normalized(); // X轴方向
-    QVector3D v = QVector3D::crossProduct(normal, u).normalized(); // Y轴方向
-
-    // 生成轨迹点
-    for (int i = 0; i < numPoints; ++i) {
-        float theta = 2 * M_PI * i / numPoints;
-        float cosTheta = cos(theta);
-        float sinTheta = sin(theta);
-
-        // 计算位置
-        QVector3D position = center + radius * (cosTheta * u + sinTheta * v);
-        points.append(position);
-    }
-
-    return points;
-}
-
-
 void MainWidget::on_createCircleTrajectory_Btn_clicked()
 {
     if(!ui->circleCenter_Btn->styleSheet().contains("background") ||
@@ -927,26 +871,47 @@ void MainWidget::on_createCircleTrajectory_Btn_clicked()
         return;
     }
 
-    QVector3D circleCenter = {m_circleCenter.at(0),m_circleCenter.at(1),m_circleCenter.at(2)};
-    QVector3D circleStart = {m_circleStart.at(0),m_circleStart.at(1),m_circleStart.at(2)};
-    QVector3D circleEmd = {m_circleEnd.at(0),m_circleEnd.at(1),m_circleEnd.at(2)};
+    if(!m_pathWriter.isOpen())
+    {
+        return;
+    }
 
-    QList<QVector3D> pointsList = generateCirclePoints(circleCenter,circleStart,circleEmd);
+    //先过渡到圆弧起点，再从起点绕圆心插补到终点，姿态沿圆弧从起点姿态过渡到终点姿态
+    //勾选优弧时走大于180度的一侧
+    //圆弧先整段插补，成功后才写过渡段，失败时文件里不留任何点
+    QVector3D center(m_circleCenter.at(0), m_circleCenter.at(1), m_circleCenter.at(2));
+    bool bMajorArc = ui->majorArc_checkBox->isChecked();
+    ArcGeometry arc;
+    if(!ArcGenerator::plan(m_circleStart.constData(), center, m_circleEnd.constData(), arc, bMajorArc))
+    {
+        QString strError = QStringLiteral("起点、终点与圆心共线（含起点终点重合），无法确定圆弧平面，请分两段添加");
+        qDebug() << strError;
+        ui->console->appendLine(strError);
+        return;
+    }
+    QVector<TrajectoryRecord> points;
+    if(ArcGenerator::generate(m_circleStart.constData(), center, m_circleEnd.constData(),
+                              pathOptions(), 0, points, bMajorArc) < 0)
+    {
+        QString strError = QStringLiteral("圆弧速度规划失败，请检查速度和加速度参数");
+        qDebug() << strError;
+        ui->console->appendLine(strError);
+        return;
+    }
 
-    QString strPoint;
-    for(auto point : pointsList)
+    appendPathLine(m_circleStart.constData(), m_circleStart.constData());
+    for(int i = 0; i < points.size(); ++i)
+    {
+        //圆弧从过渡段结束的时刻开始
+        points[i].timestampMs += m_nPathTimeMs;
+        m_pathWriter.append(points.at(i));
+    }
+    if(!points.isEmpty())
     {
-        //qDebug() << point.x() << point.y() << point.z() << endl;
-        strPoint.clear();
-        strPoint += QString(" %1 %2 %3 %4 %5 %6").arg(point.x())
-                .arg(point.y())
-                .arg(point.z())
-                .arg(m_circleStart.at(3))
-                .arg(m_circleStart.at(4))
-                .arg(m_circleStart.at(5));
-        strPoint += "\r\n";
-        writeRecordFile(strPoint.toUtf8());
+        m_nPathTimeMs = points.last().timestampMs;
+        std::copy(points.last().pose, points.last().pose + 6, m_lastPathPose);
     }
+    qDebug() << "append arc points:" << points.size() << "total time ms:" << m_nPathTimeMs;
 
     ui->circleCenter_Btn->setStyleSheet("");
     ui->circleStart_Btn->setStyleSheet("");
@@ -957,7 +922,13 @@ void MainWidget::on_createCircleTrajectory_Btn_clicked()
 void MainWidget::on_speedSlider_valueChanged(int value)
 {
     m_fSpeed = value;
-    qDebug() << "m_fSpeed = " << m_fSpeed << endl;
+    AsyncLogger::log(LOG_DEBUG, "speed = %1", m_fSpeed);
+    m_player->setSpeed(m_fSpeed);
+    if(m_scheduler->isJogging())
+    {
+        int nAxis = (m_curTeachType == MOVE_JOINT) ? m_nCurOpJoint : m_nCurOpPos;
+        m_scheduler->setJogVelocity(jogLimits(nAxis).maxVelocity);
+    }
 }
 
 void MainWidget::on_selectMode_cbBox_currentIndexChanged(int index)
@@ -973,8 +944,9 @@ void MainWidget::on_setKp_Btn_clicked()
     QString strJoint = QString::number(ui->setPidJoint_cbBox->currentIndex() + 1);
     QString strKpValue = QString::number(ui->setKp_SpinBox->value());
     QStringList paraList = {strJoint,strKpValue};
-    m_serialSender->sendDatas(constructCmd(SETKP,paraList));
-    qDebug() << constructCmd(SETKP,paraList) ;
+    QByteArray cmd = constructCmd(SETKP,paraList);
+    m_serialSender->sendDatas(cmd);
+    AsyncLogger::logData(LOG_DEBUG, "send %1 bytes: %2", cmd.constData(), cmd.size());
 }
 
 void MainWidget::on_setKi_Btn_clicked()
@@ -992,3 +964,27 @@ void MainWidget::on_setKd_Btn_clicked()
     QStringList paraList = {strJoint,strKdValue};
     m_serialSender->sendDatas(constructCmd(SETKD,paraList));
 }
+
+void MainWidget::on_dumpStats_Btn_clicked()
+{
+    QString documentsPath = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+    QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
+    QString filePath = documentsPath + QString("/link_stats_%1.txt").arg(timestamp);
+    if(m_serialSender->linkStats()->dump(filePath))
+    {
+        ui->console->appendLine("link stats saved to " + filePath);
+    }else{
+        qDebug() << "Failed to write link stats:" << filePath;
+    }
+}
+
+void MainWidget::on_logLevel_cbBox_currentIndexChanged(int index)
+{
+    AsyncLogger::instance()->setLevel(static_cast<LOG_LEVEL>(index));
+}
+
+void MainWidget::on_resetStats_Btn_clicked()
+{
+    m_serialSender->linkStats()->reset();
+    ui->linkStats_textEdit->setPlainText(m_serialSender->linkStats()->report());
+}
@@ -4,10 +4,13 @@
 #include <QWidget>
 #include <QSerialPort>
 #include "serialsender.h"
-#include <QMap>
+#include "motionscheduler.h"
+#include "trajectoryplayer.h"
+#include "trajectoryrecorder.h"
+#include "lineargenerator.h"
+#include "trajectoryvalidator.h"
 #include <QFile>
 #include <QTimer>
-#include <QQueue>
 #include <QButtonGroup>
 #include <QList>
 
@@ -26,19 +29,24 @@ public:
 private slots:
     void onSerialError(const QString& );
     void onDataReceived(const QByteArray&);
+    void onFrameReceived(const ResponseFrame&);
     void onSerialOpened();
     void onSerialClosed();
-    //发送获取位姿的请求 用于拖动示教
+    //发送获取位姿的请求
     void onSendGetLPosRequest();
-
-    void onTeaching();
-
-    void onPlayRecord();
+    //刷新调度线程的抖动统计和点动位置
+    void onUpdateStats();
     void onJointAddBtnPressed(int);
     void onJointRecudeBtnPressed(int);
     void onPosAddBtnPressed(int);
     void onPosReduceBtnPressed(int);
     void onTeachBtnReleased();
+    //按住点动按键期间定时给调度线程发心跳
+    void onJogHeartbeat();
+    //调度线程自行停止了点动
+    void onJogHalted(bool bHeartbeatLost);
+    //后台预检结束，通过则开始回放
+    void onValidationFinished();
 private slots:
 
     void on_connect_Btn_clicked();
@@ -99,46 +107,55 @@ private slots:
 
     void on_setKd_Btn_clicked();
 
+    void on_dumpStats_Btn_clicked();
+
+    void on_resetStats_Btn_clicked();
+
+    void on_logLevel_cbBox_currentIndexChanged(int index);
+
 private:
     QByteArray constructCmd(CMD_TYPE cmd, const QStringList &paraList = QStringList());
-    void initMap();
+    //热路径使用，不经过QString
+    void sendCmd(CMD_TYPE cmd, const float* values = nullptr, int count = 0);
 
     void scanSerialPort();
 
-    void writeRecordFile(const QByteArray& data);
+    //创建轨迹：按插补参数追加一段直线，和上一段之间自动过渡
+    void appendPathLine(const float* start, const float* end);
+    PathOptions pathOptions() const;
 
-    void readRecordFile(const QString& fileName);
+    //示教记录目录下的文件路径
+    QString recordFilePath(const QString& fileName) const;
+    //从第fromIndex条记录开始回放当前选中的文件
+    void startPlayback(int fromIndex);
+    void stopPlayback();
 
     void updateFileList();
 
     //示教功能需要先获取当前位置或者关节角
     void sendTeachGetRequest();
+    //收到当前位置后从start开始点动
+    void startJog(const float* start);
+    //回放中按下点动键：放弃这次点动并提示
+    void refuseJog();
+    //点动第axis个值时的速度限制，最大速度按速度滑块缩放
+    ProfileLimits jogLimits(int axis) const;
+    //显示点动当前的设定值
+    void showJogSetpoint();
+    //6个数值保留两位小数，用于界面显示
+    static QString formatValues(const float* values);
 
     void keyPressEvent(QKeyEvent *event);
     void keyReleaseEvent(QKeyEvent *event);
 
-    void setPointPos(const QStringList&);
-
-    QList<QVector3D> generateCirclePoints(
-        const QVector3D &center,
-        const QVector3D &point1,
-        const QVector3D &point2,
-        int numPoints = 100);
+    void setPointPos(const float* pose);
 
 private:
     Ui::MainWidget *ui;
     SerialSender *m_serialSender;
-    //指令映射
-    QMap<CMD_TYPE,QString> m_CmdMap;
-
-    QTimer* m_timer;
-    QTimer* m_runTimer;
-    QTimer* m_teachTimer;
 
 //    float m_currentJoint[6] = {0.00, -75.00, 180.00, 0.00, 0.00, 0.00};
 //    float m_currentPos[6] = {93.37, 0.00, 165, -180.00, 75.00, -180.00};
-    QStringList m_CurAngleList;
-    QStringList m_CurPosList;
 
     typedef enum MoveType{
         MOVE_JOINT,
@@ -151,7 +168,6 @@ private:
         REDUCE_VALUE
     }OPERATETYPE;
 
-    bool m_bIsRecording = false;   //记录中
     bool m_bIsReappearing = false; //回放中
     bool m_bIsTeaching = false;    //示教中
     bool m_bIsCreatePoint = false;  //创建点
@@ -159,11 +175,19 @@ private:
     OperateType m_curOperateType;  //当前操作类型
     int m_nCurOpJoint = 0;
     int m_nCurOpPos = 0;
-    int m_nReadLines = 0;
     float m_fSpeed = 100;
-    QFile m_recordFile;
-
-    QQueue<QByteArray> m_cmdQueue;
+    //创建轨迹写入的文件
+    TrajectoryWriter m_pathWriter;
+    float m_lastPathPose[6];
+    quint32 m_nPathTimeMs = 0;
+
+    MotionScheduler* m_scheduler;
+    TrajectoryPlayer* m_player;
+    TrajectoryRecorder* m_recorder; //拖动示教采样，带时间戳写入.trj
+    ValidationThread* m_validation; //可选的回放前预检，连杆参数未校准，默认不用
+    QTimer* m_statsTimer;   //刷新抖动统计和点动位置
+    QTimer* m_jogHeartbeatTimer;
+    static const int JOG_HEARTBEAT_MS = 50;
 
     QButtonGroup* m_jointAddBtnGroup;
     QButtonGroup* m_jointReduceBtnGroup;
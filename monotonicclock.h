@@ -0,0 +1,29 @@
+#ifndef MONOTONICCLOCK_H
+#define MONOTONICCLOCK_H
+
+#include <QtGlobal>
+#include <QElapsedTimer>
+#ifdef Q_OS_LINUX
+#include <time.h>
+#endif
+
+// 进程内统一的单调时钟（纳秒），不同线程取的时间戳可以直接相减
+// Linux下与clock_nanosleep(CLOCK_MONOTONIC)同一时间基准
+inline qint64 monotonicNs()
+{
+#ifdef Q_OS_LINUX
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+    struct StartedClock
+    {
+        QElapsedTimer timer;
+        StartedClock() { timer.start(); }
+    };
+    static StartedClock s_clock;
+    return s_clock.timer.nsecsElapsed();
+#endif
+}
+
+#endif // MONOTONICCLOCK_H
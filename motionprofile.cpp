@@ -0,0 +1,166 @@
+#include "motionprofile.h"
+#include <cmath>
+
+MotionProfile::MotionProfile()
+{
+
+}
+
+bool MotionProfile::plan(PROFILE_TYPE type, double distance, const ProfileLimits &limits)
+{
+    m_nSegments = 0;
+    m_distance = 0;
+    m_duration = 0;
+    m_peakVelocity = 0;
+    if(distance < 0 || limits.maxVelocity <= 0 || limits.maxAcceleration <= 0
+            || (type == PROFILE_SCURVE && limits.maxJerk <= 0))
+    {
+        return false;
+    }
+
+    m_distance = distance;
+    if(distance == 0)
+    {
+        return true;
+    }
+
+    if(type == PROFILE_SCURVE)
+    {
+        planSCurve(limits);
+    }else{
+        planTrapezoid(limits);
+    }
+    return true;
+}
+
+void MotionProfile::planTrapezoid(const ProfileLimits &limits)
+{
+    double vmax = limits.maxVelocity;
+    double amax = limits.maxAcceleration;
+
+    double ta = vmax / amax;
+    double tv = 0;
+    if(m_distance < vmax * ta)
+    {
+        //距离太短达不到最大速度，三角形速度
+        vmax = std::sqrt(m_distance * amax);
+        ta = vmax / amax;
+    }else{
+        tv = (m_distance - vmax * ta) / vmax;
+    }
+
+    m_peakVelocity = vmax;
+    appendSegment(ta, amax, 0);
+    appendSegment(tv, 0, 0);
+    appendSegment(ta, -amax, 0);
+}
+
+void MotionProfile::planSCurve(const ProfileLimits &limits)
+{
+    double vmax = limits.maxVelocity;
+    double amax = limits.maxAcceleration;
+    double jmax = limits.maxJerk;
+
+    //加速段：Tj为加加速度段时长，Ta为整个加速段时长
+    double tj = 0;
+    double ta = 0;
+    if(vmax * jmax >= amax * amax)
+    {
+        tj = amax / jmax;
+        ta = tj + vmax / amax;
+    }else{
+        //达不到最大加速度
+        tj = std::sqrt(vmax / jmax);
+        ta = 2 * tj;
+    }
+    double tv = m_distance / vmax - ta;
+
+    if(tv < 0)
+    {
+        //达不到最大速度，没有匀速段
+        tv = 0;
+        tj = amax / jmax;
+        ta = tj / 2 + std::sqrt(tj * tj / 4 + m_distance / amax);
+        if(ta < 2 * tj)
+        {
+            //也达不到最大加速度
+            tj = std::cbrt(m_distance / (2 * jmax));
+            ta = 2 * tj;
+        }
+    }
+
+    double alim = jmax * tj;
+    m_peakVelocity = alim * (ta - tj);
+    appendSegment(tj, 0, jmax);
+    appendSegment(ta - 2 * tj, alim, 0);
+    appendSegment(tj, alim, -jmax);
+    appendSegment(tv, 0, 0);
+    appendSegment(tj, 0, -jmax);
+    appendSegment(ta - 2 * tj, -alim, 0);
+    appendSegment(tj, -alim, jmax);
+}
+
+void MotionProfile::appendSegment(double duration, double accel, double jerk)
+{
+    if(duration <= 0 || m_nSegments >= MAX_SEGMENTS)
+    {
+        return;
+    }
+
+    Segment seg;
+    seg.t0 = m_duration;
+    seg.p0 = 0;
+    seg.v0 = 0;
+    if(m_nSegments > 0)
+    {
+        //接上一段的末状态
+        const Segment& prev = m_segments[m_nSegments - 1];
+        double dt = seg.t0 - prev.t0;
+        seg.p0 = prev.p0 + prev.v0 * dt + prev.a0 * dt * dt / 2 + prev.jerk * dt * dt * dt / 6;
+        seg.v0 = prev.v0 + prev.a0 * dt + prev.jerk * dt * dt / 2;
+    }
+    seg.a0 = accel;
+    seg.jerk = jerk;
+    m_segments[m_nSegments++] = seg;
+    m_duration += duration;
+}
+
+const MotionProfile::Segment &MotionProfile::segmentAt(double t) const
+{
+    int i = m_nSegments - 1;
+    while(i > 0 && m_segments[i].t0 > t)
+    {
+        --i;
+    }
+    return m_segments[i];
+}
+
+double MotionProfile::position(double t) const
+{
+    if(m_nSegments == 0 || t <= 0)
+    {
+        return 0;
+    }
+    if(t >= m_duration)
+    {
+        return m_distance;
+    }
+
+    const Segment& seg = segmentAt(t);
+    double dt = t - seg.t0;
+    double p = seg.p0 + seg.v0 * dt + seg.a0 * dt * dt / 2 + seg.jerk * dt * dt * dt / 6;
+    //累计的舍入误差不能超出终点
+    return (p > m_distance) ? m_distance : p;
+}
+
+double MotionProfile::velocity(double t) const
+{
+    if(m_nSegments == 0 || t <= 0 || t >= m_duration)
+    {
+        return 0;
+    }
+
+    const Segment& seg = segmentAt(t);
+    double dt = t - seg.t0;
+    return seg.v0 + seg.a0 * dt + seg.jerk * dt * dt / 2;
+}
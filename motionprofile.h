@@ -0,0 +1,61 @@
+#ifndef MOTIONPROFILE_H
+#define MOTIONPROFILE_H
+
+typedef enum ProfileType
+{
+    PROFILE_TRAPEZOID,  //梯形速度，加速度阶跃
+    PROFILE_SCURVE      //S曲线速度，限制加加速度
+}PROFILE_TYPE;
+
+struct ProfileLimits
+{
+    double maxVelocity = 50;      //单位/s
+    double maxAcceleration = 200; //单位/s^2
+    double maxJerk = 2000;        //单位/s^3，仅S曲线使用
+};
+
+// 一维点到点速度规划，起止速度和加速度为0
+// 规划结果是若干段加加速度恒定的分段多项式，按时间求位置
+class MotionProfile
+{
+public:
+    MotionProfile();
+
+    bool plan(PROFILE_TYPE type, double distance, const ProfileLimits& limits);
+
+    double distance() const { return m_distance; }
+    double duration() const { return m_duration; }
+    //实际达到的最大速度，距离短时小于限制值
+    double peakVelocity() const { return m_peakVelocity; }
+
+    double position(double t) const;
+    double velocity(double t) const;
+
+private:
+    //分段起点的状态和本段的加加速度
+    struct Segment
+    {
+        double t0;
+        double p0;
+        double v0;
+        double a0;
+        double jerk;
+    };
+
+    void planTrapezoid(const ProfileLimits& limits);
+    void planSCurve(const ProfileLimits& limits);
+    //按(时长,起始加速度,加加速度)依次追加一段
+    void appendSegment(double duration, double accel, double jerk);
+    const Segment& segmentAt(double t) const;
+
+private:
+    static const int MAX_SEGMENTS = 7;
+
+    Segment m_segments[MAX_SEGMENTS];
+    int m_nSegments = 0;
+    double m_distance = 0;
+    double m_duration = 0;
+    double m_peakVelocity = 0;
+};
+
+#endif // MOTIONPROFILE_H
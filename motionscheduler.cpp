@@ -0,0 +1,353 @@
+#include "motionscheduler.h"
+#include "serialsender.h"
+#include "playbacksource.h"
+#include "commandencoder.h"
+#include "asynclogger.h"
+#include <QMutexLocker>
+#include <QDebug>
+#include "monotonicclock.h"
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <cerrno>
+#endif
+
+//SCHED_FIFO优先级，高于普通线程即可，不和内核线程抢
+#define SCHEDULER_RT_PRIORITY 50
+//按时间戳回放或第一条记录时预读跟不上，隔1ms再取
+#define PENDING_RETRY_NS 1000000
+
+MotionScheduler::MotionScheduler(SerialSender *sender, QObject *parent)
+    : QThread(parent)
+    , m_sender(sender)
+    , m_nHeartbeatNs(0)
+{
+}
+
+MotionScheduler::~MotionScheduler()
+{
+    m_mutex.lock();
+    m_bQuit = true;
+    m_mode = MODE_IDLE;
+    m_wakeup.wakeAll();
+    m_mutex.unlock();
+    wait();
+}
+
+bool MotionScheduler::startPlayback(PlaybackSource *source, PROTOCOL_TYPE protocol, int periodMs, float speed)
+{
+    //周期为0或负数时会不停地连续发送
+    if(periodMs <= 0)
+    {
+        qDebug() << "invalid playback period:" << periodMs;
+        return false;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_source = source;
+    m_fSpeed = speed;
+    m_bTimed = source->isTimed();
+    m_bHasPending = false;
+    begin(MODE_PLAYBACK, protocol, periodMs);
+    return true;
+}
+
+bool MotionScheduler::startJog(CMD_TYPE cmd, PROTOCOL_TYPE protocol, const JogGenerator &jog, float speed)
+{
+    QMutexLocker locker(&m_mutex);
+    //begin会清掉回放的模式和已发送计数，回放进度就丢了
+    if(m_mode == MODE_PLAYBACK)
+    {
+        AsyncLogger::log(LOG_WARN, "jog refused during playback, %1 records sent", m_nSent);
+        return false;
+    }
+    m_jogCmd = cmd;
+    m_jog = jog;
+    m_fSpeed = speed;
+    m_nHeartbeatNs.storeRelease(now());
+    begin(MODE_JOG, protocol, JOG_PERIOD_MS);
+    return true;
+}
+
+void MotionScheduler::setJogVelocity(double maxVelocity)
+{
+    QMutexLocker locker(&m_mutex);
+    m_jog.setMaxVelocity(maxVelocity);
+}
+
+void MotionScheduler::jogHeartbeat()
+{
+    m_nHeartbeatNs.storeRelease(now());
+}
+
+int MotionScheduler::stopPlayback()
+{
+    QMutexLocker locker(&m_mutex);
+    if(m_mode == MODE_PLAYBACK)
+    {
+        m_mode = MODE_IDLE;
+    }
+    m_source = nullptr;
+    m_bHasPending = false;
+    int nSent = m_nSent;
+    m_nSent = 0;
+    return nSent;
+}
+
+void MotionScheduler::stopJog()
+{
+    QMutexLocker locker(&m_mutex);
+    if(m_mode == MODE_JOG)
+    {
+        m_mode = MODE_IDLE;
+    }
+}
+
+bool MotionScheduler::isJogging() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_mode == MODE_JOG;
+}
+
+void MotionScheduler::jogSetpoint(float *values) const
+{
+    QMutexLocker locker(&m_mutex);
+    m_jog.setpoint(values);
+}
+
+SchedulerStats MotionScheduler::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+void MotionScheduler::begin(MODE mode, PROTOCOL_TYPE protocol, int periodMs)
+{
+    //调用者已加锁
+    m_mode = mode;
+    m_protocol = protocol;
+    m_nPeriodNs = qint64(periodMs) * 1000000;
+    m_nSent = 0;
+    m_bRestart = true;
+    m_stats = SchedulerStats();
+    m_bBlocked = false;
+    m_stats.periodUs = qint64(periodMs) * 1000;
+    m_wakeup.wakeAll();
+
+    if(!isRunning())
+    {
+        start();
+    }
+}
+
+void MotionScheduler::run()
+{
+    setRealtimePriority();
+
+    qint64 deadline = 0;
+    QMutexLocker locker(&m_mutex);
+    while(!m_bQuit)
+    {
+        if(m_mode == MODE_IDLE)
+        {
+            m_wakeup.wait(&m_mutex);
+            continue;
+        }
+        if(m_bRestart)
+        {
+            //第一拍立即发送
+            m_bRestart = false;
+            deadline = now();
+        }
+
+        locker.unlock();
+        sleepUntil(deadline);
+        qint64 wakeNs = now();
+        locker.relock();
+
+        //睡眠期间被停止或重新开始
+        if(m_mode == MODE_IDLE || m_bRestart)
+        {
+            continue;
+        }
+
+        recordLateness(wakeNs - deadline);
+        tick();
+
+        //下一拍由截止时间推算，不随发送耗时漂移
+        deadline = nextDeadline(deadline);
+        qint64 lagNs = now() - deadline;
+        if(lagNs > m_nPeriodNs)
+        {
+            //落后超过一个周期不补发，整体顺延
+            ++m_stats.overruns;
+            deadline += lagNs;
+            m_nTimeBaseNs += lagNs;
+        }
+    }
+}
+
+void MotionScheduler::tick()
+{
+    float values[MAX_CMD_VALUES];
+    CMD_TYPE cmd = m_jogCmd;
+    JogGenerator next;
+    if(m_mode == MODE_PLAYBACK)
+    {
+        //预读跟不上时跳过这一拍
+        if(!m_bHasPending && !takePending())
+        {
+            return;
+        }
+        for(int i = 0; i < 6; ++i)
+        {
+            values[i] = m_pending.pose[i];
+        }
+        values[6] = m_pending.speed ? m_pending.speed : m_fSpeed;
+        cmd = MOVEL;
+        m_bHasPending = false;
+        ++m_nSent;
+    }else{
+        //界面线程卡住或者松开事件丢失，不等松开直接停止
+        if(now() - m_nHeartbeatNs.loadAcquire() > qint64(JOG_HEARTBEAT_TIMEOUT_MS) * 1000000)
+        {
+            m_mode = MODE_IDLE;
+            AsyncLogger::log(LOG_WARN, "jog heartbeat lost, halted on axis %1", m_jog.axis());
+            emit signalJogHalted(true);
+            return;
+        }
+        //发送成功后才推进，发送通道满时下一拍从原状态重来
+        next = m_jog;
+        next.step(m_nPeriodNs / 1e9);
+        next.setpoint(values);
+        values[6] = m_fSpeed;
+    }
+
+    char buf[CommandEncoder::MAX_CMD_SIZE];
+    int nSize = CommandEncoder::encode(m_protocol, cmd, values, 7, buf, sizeof(buf));
+    m_bBlocked = (nSize > 0) && !m_sender->sendDatas(buf, nSize, CHANNEL_SCHEDULER);
+    if(m_bBlocked)
+    {
+        //串口发送繁忙，这一条留到下一拍重发，点动的设定值不前进
+        ++m_stats.blocked;
+        if(m_mode == MODE_PLAYBACK)
+        {
+            m_bHasPending = true;
+            --m_nSent;
+        }
+        return;
+    }
+
+    if(m_mode == MODE_JOG)
+    {
+        m_jog = next;
+        if(!m_jog.isMoving())
+        {
+            //停在限位前，最后一个设定值已经发出
+            m_mode = MODE_IDLE;
+            emit signalJogHalted(false);
+        }
+        return;
+    }
+
+    //按时间戳回放需要先取到下一条才知道下一拍的时刻
+    if(m_mode == MODE_PLAYBACK && m_bTimed)
+    {
+        takePending();
+    }
+}
+
+bool MotionScheduler::takePending()
+{
+    //持有m_mutex，不能等待预读线程，否则界面线程的stats()、stopPlayback()等都要跟着等
+    //第一条没取到时由nextDeadline安排1ms后重试
+    if(!m_source->take(m_pending, 0))
+    {
+        //读完才结束
+        if(m_source->atEnd())
+        {
+            m_mode = MODE_IDLE;
+            emit signalPlaybackFinished();
+        }
+        return false;
+    }
+
+    if(m_nSent == 0)
+    {
+        m_nTimeBaseNs = now();
+        m_nFirstTimestampMs = m_pending.timestampMs;
+    }
+    m_bHasPending = true;
+    return true;
+}
+
+qint64 MotionScheduler::nextDeadline(qint64 deadline) const
+{
+    if(m_mode == MODE_PLAYBACK && m_nSent == 0 && !m_bHasPending)
+    {
+        //第一条还没预读出来，不等一个完整周期
+        return deadline + PENDING_RETRY_NS;
+    }
+    if(m_mode == MODE_PLAYBACK && m_bTimed)
+    {
+        if(!m_bHasPending || m_bBlocked)
+        {
+            return deadline + PENDING_RETRY_NS;
+        }
+        return m_nTimeBaseNs + qint64(m_pending.timestampMs - m_nFirstTimestampMs) * 1000000;
+    }
+    return deadline + m_nPeriodNs;
+}
+
+void MotionScheduler::recordLateness(qint64 lateNs)
+{
+    qint64 lateUs = lateNs / 1000;
+    ++m_stats.ticks;
+    m_stats.lastLateUs = lateUs;
+    if(lateUs > m_stats.maxLateUs)
+    {
+        m_stats.maxLateUs = lateUs;
+    }
+    m_stats.meanLateUs += (lateUs - m_stats.meanLateUs) / m_stats.ticks;
+}
+
+qint64 MotionScheduler::now()
+{
+    return monotonicNs();
+}
+
+void MotionScheduler::sleepUntil(qint64 deadlineNs) const
+{
+#ifdef Q_OS_LINUX
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadlineNs / 1000000000);
+    ts.tv_nsec = static_cast<long>(deadlineNs % 1000000000);
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+    {
+    }
+#else
+    //其他平台没有绝对时间睡眠，按剩余时间睡眠
+    qint64 remainNs = deadlineNs - now();
+    if(remainNs > 0)
+    {
+        QThread::usleep(static_cast<unsigned long>(remainNs / 1000));
+    }
+#endif
+}
+
+void MotionScheduler::setRealtimePriority()
+{
+#ifdef Q_OS_LINUX
+    sched_param param;
+    param.sched_priority = SCHEDULER_RT_PRIORITY;
+    int nRet = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if(nRet != 0)
+    {
+        //没有CAP_SYS_NICE权限时保持普通优先级
+        qDebug() << "MotionScheduler: SCHED_FIFO not permitted, error" << nRet;
+        setPriority(QThread::TimeCriticalPriority);
+    }
+#else
+    setPriority(QThread::TimeCriticalPriority);
+#endif
+}
@@ -0,0 +1,120 @@
+#ifndef MOTIONSCHEDULER_H
+#define MOTIONSCHEDULER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInteger>
+#include "commanddefs.h"
+#include "trajectoryfile.h"
+#include "joggenerator.h"
+
+class SerialSender;
+class PlaybackSource;
+
+// 调度线程每拍相对截止时间的延迟统计
+struct SchedulerStats
+{
+    qint64 periodUs = 0;
+    quint64 ticks = 0;
+    qint64 lastLateUs = 0;
+    qint64 maxLateUs = 0;
+    double meanLateUs = 0;
+    quint64 overruns = 0;   //晚于一个周期，重新对齐的次数
+    quint64 blocked = 0;    //串口发送通道满，推迟发送的拍数
+};
+
+// 回放和点动的定时发送线程
+// 按绝对截止时间睡眠（单调时钟），不受界面线程重绘、弹窗的影响，
+// 编码后直接交给串口线程发送
+// 点动按心跳判断按键是否还按着，松开或心跳超时后的下一拍不再发送
+class MotionScheduler : public QThread
+{
+    Q_OBJECT
+public:
+    //点动设定值的发送周期
+    static const int JOG_PERIOD_MS = 10;
+    //超过这么久没有收到心跳就停止点动
+    static const int JOG_HEARTBEAT_TIMEOUT_MS = 150;
+
+    explicit MotionScheduler(SerialSender* sender, QObject *parent = nullptr);
+    ~MotionScheduler();
+
+    //从source取记录发送MOVEL，speed用于未记录速度的点
+    //带时间戳的记录按采集时的间隔发送，否则按periodMs固定周期发送，periodMs不大于0时返回false
+    bool startPlayback(PlaybackSource* source, PROTOCOL_TYPE protocol, int periodMs, float speed);
+    //从jog的当前状态开始连续点动，每JOG_PERIOD_MS推进一次并发送设定值，cmd为MOVEJ或MOVEL
+    //定时回放中返回false，不会替换回放，要点动须先stopPlayback取得回放进度
+    bool startJog(CMD_TYPE cmd, PROTOCOL_TYPE protocol, const JogGenerator& jog, float speed);
+    //点动中修改最大速度，速度平滑过渡
+    void setJogVelocity(double maxVelocity);
+    //按住点动按键期间界面线程定时调用，不加锁
+    void jogHeartbeat();
+    //停止后不会再发送任何指令
+    //返回本次回放发出的记录数，回放已自然结束时同样有效
+    int stopPlayback();
+    //松开按键，下一拍起不再发送设定值
+    void stopJog();
+
+    bool isJogging() const;
+    //点动当前的6个设定值
+    void jogSetpoint(float* values) const;
+    SchedulerStats stats() const;
+
+signals:
+    //回放的记录发送完毕
+    void signalPlaybackFinished();
+    //点动被调度线程停止：心跳超时，或者在限位前停下
+    void signalJogHalted(bool bHeartbeatLost);
+
+protected:
+    void run() override;
+
+private:
+    enum MODE
+    {
+        MODE_IDLE,
+        MODE_PLAYBACK,
+        MODE_JOG
+    };
+
+    void begin(MODE mode, PROTOCOL_TYPE protocol, int periodMs);
+    void tick();
+    //取下一条回放记录到m_pending，读完时结束回放
+    bool takePending();
+    qint64 nextDeadline(qint64 deadline) const;
+    void recordLateness(qint64 lateNs);
+    static qint64 now();
+    void sleepUntil(qint64 deadlineNs) const;
+    void setRealtimePriority();
+
+private:
+    SerialSender* m_sender;
+    PlaybackSource* m_source = nullptr;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wakeup;
+    MODE m_mode = MODE_IDLE;
+    bool m_bQuit = false;
+    bool m_bRestart = false;   //重新开始，截止时间从当前时刻算起
+    PROTOCOL_TYPE m_protocol = PROTOCOL_ASCII;
+    qint64 m_nPeriodNs = 0;
+    float m_fSpeed = 100;
+    int m_nSent = 0;
+
+    //按时间戳回放：第一条记录发送的时刻对应它的时间戳
+    bool m_bTimed = false;
+    bool m_bHasPending = false;
+    bool m_bBlocked = false;   //上一拍因发送通道满没有发出
+    TrajectoryRecord m_pending;
+    qint64 m_nTimeBaseNs = 0;
+    quint32 m_nFirstTimestampMs = 0;
+
+    CMD_TYPE m_jogCmd = MOVEJ;
+    JogGenerator m_jog;
+    QAtomicInteger<qint64> m_nHeartbeatNs;
+
+    SchedulerStats m_stats;
+};
+
+#endif // MOTIONSCHEDULER_H
@@ -0,0 +1,244 @@
+#include "networkbridge.h"
+#include "serialsender.h"
+#include "asynclogger.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QDebug>
+#include <cstdio>
+
+//遥测行前缀的最大长度：时间戳和指令名
+#define TELEMETRY_PREFIX_SIZE 48
+//遥测槽位预留的容量，大多数应答不需要再分配
+#define TELEMETRY_LINE_RESERVE 128
+
+NetworkBridge::NetworkBridge(SerialSender *sender, QObject *parent)
+    : QObject(parent)
+    , m_sender(sender)
+    , m_server(new QTcpServer(this))
+    , m_telemetry(TELEMETRY_CAPACITY)
+{
+    for(int i = 0; i < TELEMETRY_CAPACITY; ++i)
+    {
+        m_telemetry[i].reserve(TELEMETRY_LINE_RESERVE);
+    }
+    m_server->setMaxPendingConnections(MAX_CLIENTS);
+    connect(m_server, &QTcpServer::newConnection, this, &NetworkBridge::onNewConnection);
+    connect(m_sender, &SerialSender::signalFrameReceived, this, &NetworkBridge::onFrameReceived);
+}
+
+NetworkBridge::~NetworkBridge()
+{
+    close();
+}
+
+bool NetworkBridge::listen(const QHostAddress &address, quint16 port)
+{
+    if(!m_server->listen(address, port))
+    {
+        qDebug() << "bridge listen failed:" << m_server->errorString();
+        return false;
+    }
+    AsyncLogger::log(LOG_INFO, "bridge listening on port %1", m_server->serverPort());
+    return true;
+}
+
+void NetworkBridge::close()
+{
+    m_server->close();
+    QList<QTcpSocket*> sockets = m_clients.keys();
+    m_clients.clear();
+    for(int i = 0; i < sockets.size(); ++i)
+    {
+        sockets.at(i)->disconnect(this);
+        sockets.at(i)->abort();
+        sockets.at(i)->deleteLater();
+    }
+}
+
+bool NetworkBridge::isListening() const
+{
+    return m_server->isListening();
+}
+
+quint16 NetworkBridge::serverPort() const
+{
+    return m_server->serverPort();
+}
+
+void NetworkBridge::onNewConnection()
+{
+    while(m_server->hasPendingConnections())
+    {
+        QTcpSocket* socket = m_server->nextPendingConnection();
+        if(m_clients.size() >= MAX_CLIENTS)
+        {
+            socket->write("bridge err too many clients\n");
+            socket->disconnectFromHost();
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            continue;
+        }
+        //遥测是实时数据，小包立即发出
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        connect(socket, &QTcpSocket::readyRead, this, &NetworkBridge::onClientReadyRead);
+        connect(socket, &QTcpSocket::bytesWritten, this, &NetworkBridge::onClientBytesWritten);
+        connect(socket, &QTcpSocket::disconnected, this, &NetworkBridge::onClientDisconnected);
+
+        //新客户端从下一帧开始接收
+        BridgeClient client;
+        client.nextSeq = m_nHead;
+        m_clients.insert(socket, client);
+        qDebug() << "bridge client connected:" << peerName(socket);
+        emit signalClientConnected(peerName(socket));
+    }
+}
+
+void NetworkBridge::onClientDisconnected()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    if(!socket || !m_clients.contains(socket))
+    {
+        return;
+    }
+    m_clients.remove(socket);
+    qDebug() << "bridge client disconnected:" << peerName(socket);
+    emit signalClientDisconnected(peerName(socket));
+    socket->deleteLater();
+}
+
+void NetworkBridge::onClientBytesWritten(qint64 bytes)
+{
+    Q_UNUSED(bytes);
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    QHash<QTcpSocket*, BridgeClient>::iterator it = m_clients.find(socket);
+    if(it != m_clients.end())
+    {
+        pumpClient(socket, it.value());
+    }
+}
+
+void NetworkBridge::onFrameReceived(const ResponseFrame &frame)
+{
+    //每帧只格式化一次写入槽位，覆盖最旧的一帧
+    //共享的只是格式化结果：socket::write会把这一行拷进每个客户端自己的写缓冲，槽位因此可以直接复用
+    char prefix[TELEMETRY_PREFIX_SIZE];
+    const char* command = "-";
+    if(frame.command >= 0 && frame.command <= SETKD)
+    {
+        command = CommandEncoder::spec(static_cast<CMD_TYPE>(frame.command)).text;
+    }
+    int nPrefix = std::snprintf(prefix, sizeof(prefix), "%lld %s ",
+                                static_cast<long long>(frame.timestampNs / 1000), command);
+
+    QByteArray& line = m_telemetry[static_cast<int>(m_nHead & (TELEMETRY_CAPACITY - 1))];
+    line.resize(0);
+    line.append(prefix, nPrefix);
+    line.append(frame.line(), frame.lineSize);
+    line.append('\n');
+    m_nHead++;
+
+    for(QHash<QTcpSocket*, BridgeClient>::iterator it = m_clients.begin(); it != m_clients.end(); ++it)
+    {
+        pumpClient(it.key(), it.value());
+    }
+}
+
+void NetworkBridge::pumpClient(QTcpSocket *socket, BridgeClient &client)
+{
+    //需要的帧已被覆盖：跳到最新，旧的遥测对它已经没有意义
+    if(client.nextSeq < m_nHead - TELEMETRY_CAPACITY)
+    {
+        qint64 nLost = m_nHead - client.nextSeq;
+        client.nLost += nLost;
+        m_nDropped += quint64(nLost);
+        client.nextSeq = m_nHead;
+        AsyncLogger::log(LOG_WARN, "bridge client lagging, dropped %1 frames", nLost);
+    }
+
+    if(socket->bytesToWrite() >= CLIENT_HIGH_WATER)
+    {
+        return;
+    }
+    if(client.nLost > 0)
+    {
+        char notice[TELEMETRY_PREFIX_SIZE];
+        int nSize = std::snprintf(notice, sizeof(notice), "bridge dropped %lld\n",
+                                  static_cast<long long>(client.nLost));
+        socket->write(notice, nSize);
+        client.nLost = 0;
+    }
+    //每个客户端各拷贝一次，积压上限CLIENT_HIGH_WATER限制了每个客户端占的内存
+    while(client.nextSeq < m_nHead && socket->bytesToWrite() < CLIENT_HIGH_WATER)
+    {
+        socket->write(m_telemetry.at(static_cast<int>(client.nextSeq & (TELEMETRY_CAPACITY - 1))));
+        client.nextSeq++;
+    }
+}
+
+void NetworkBridge::onClientReadyRead()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    QHash<QTcpSocket*, BridgeClient>::iterator it = m_clients.find(socket);
+    if(it == m_clients.end())
+    {
+        return;
+    }
+    BridgeClient& client = it.value();
+    client.rxBuffer += socket->readAll();
+
+    int nStart = 0;
+    int nEnd;
+    while((nEnd = client.rxBuffer.indexOf('\n', nStart)) >= 0)
+    {
+        int nSize = nEnd - nStart;
+        if(nSize > 0 && client.rxBuffer.at(nEnd - 1) == '\r')
+        {
+            nSize--;
+        }
+        if(client.bDiscarding)
+        {
+            client.bDiscarding = false;
+        }else if(nSize > 0)
+        {
+            handleCommandLine(socket, client.rxBuffer.constData() + nStart, nSize);
+        }
+        nStart = nEnd + 1;
+    }
+    client.rxBuffer.remove(0, nStart);
+
+    //超长的行不会是合法指令，丢到下一个换行为止
+    if(client.rxBuffer.size() > MAX_COMMAND_LINE)
+    {
+        client.rxBuffer.clear();
+        if(!client.bDiscarding)
+        {
+            client.bDiscarding = true;
+            socket->write("bridge err line too long\n");
+        }
+    }
+}
+
+void NetworkBridge::handleCommandLine(QTcpSocket *socket, const char *line, int size)
+{
+    RobotCommand command;
+    if(!CommandEncoder::decodeAscii(line, size, command))
+    {
+        socket->write("bridge err invalid command\n");
+        AsyncLogger::logData(LOG_DEBUG, "bridge invalid command %1 bytes: %2", line, size);
+        return;
+    }
+
+    //按当前连接的协议重新编码，二进制协议的链路也可以接受ASCII客户端
+    char buf[CommandEncoder::MAX_CMD_SIZE];
+    int nSize = CommandEncoder::encode(m_sender->protocol(), command.cmd, command.values, command.count,
+                                       buf, sizeof(buf));
+    if(nSize <= 0 || !m_sender->sendDatas(buf, nSize, CHANNEL_NETWORK))
+    {
+        //通道满或串口积压，由客户端稍后重发
+        socket->write("bridge busy\n");
+    }
+}
+
+QString NetworkBridge::peerName(const QTcpSocket *socket)
+{
+    return QString("%1:%2").arg(socket->peerAddress().toString()).arg(socket->peerPort());
+}
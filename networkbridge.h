@@ -0,0 +1,88 @@
+#ifndef NETWORKBRIDGE_H
+#define NETWORKBRIDGE_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QByteArray>
+#include <QHostAddress>
+#include "responseframer.h"
+#include "commandencoder.h"
+
+class QTcpServer;
+class QTcpSocket;
+class SerialSender;
+
+// 网络指令桥：把机械臂指令通道和遥测开放给TCP客户端，只能在创建它的线程中使用
+// 指令：客户端每行一条ASCII指令，解析后按当前连接的协议重新编码，送入CHANNEL_NETWORK
+// 遥测：串口线程解析出的每一帧只格式化一次，放入共享的遥测环，客户端只记录自己下一条的序号；
+//   写给客户端时每个客户端的socket写缓冲各拷贝一份，省掉的是重复格式化，不是拷贝
+//   一行为 "<接收时刻us> <配对的指令或-> <应答原文>"
+// 背压：客户端的socket积压超过CLIENT_HIGH_WATER就暂停给它写，写出后再继续；
+//   落后超过TELEMETRY_CAPACITY帧时跳到最新并发一行 "bridge dropped <帧数>"
+//   慢客户端只丢自己的遥测，不会阻塞串口链路和其他客户端
+class NetworkBridge : public QObject
+{
+    Q_OBJECT
+public:
+    static const int TELEMETRY_CAPACITY = 1024;   //必须是2的幂
+    static const int CLIENT_HIGH_WATER = 16384;
+    static const int MAX_CLIENTS = 8;
+    //指令行不能超过编码器的单条指令长度
+    static const int MAX_COMMAND_LINE = CommandEncoder::MAX_CMD_SIZE;
+
+    explicit NetworkBridge(SerialSender* sender, QObject *parent = nullptr);
+    ~NetworkBridge();
+
+    //port为0时由系统分配，用serverPort()取得
+    bool listen(const QHostAddress& address, quint16 port);
+    //断开所有客户端并停止监听
+    void close();
+    bool isListening() const;
+    quint16 serverPort() const;
+
+    int clientCount() const { return m_clients.size(); }
+    //已放入遥测环的帧数
+    qint64 telemetryCount() const { return m_nHead; }
+    //所有客户端因落后被跳过的帧数之和
+    quint64 droppedCount() const { return m_nDropped; }
+
+signals:
+    void signalClientConnected(const QString& strPeer);
+    void signalClientDisconnected(const QString& strPeer);
+
+private slots:
+    void onNewConnection();
+    void onClientReadyRead();
+    void onClientBytesWritten(qint64 bytes);
+    void onClientDisconnected();
+    void onFrameReceived(const ResponseFrame& frame);
+
+private:
+    struct BridgeClient
+    {
+        //下一条要写给它的遥测序号
+        qint64 nextSeq = 0;
+        //跳过但还没通知客户端的帧数
+        qint64 nLost = 0;
+        QByteArray rxBuffer;
+        //当前行超长，丢弃到下一个换行
+        bool bDiscarding = false;
+    };
+
+    //按积压情况把遥测写给一个客户端
+    void pumpClient(QTcpSocket* socket, BridgeClient& client);
+    void handleCommandLine(QTcpSocket* socket, const char* line, int size);
+    static QString peerName(const QTcpSocket* socket);
+
+private:
+    SerialSender* m_sender;
+    QTcpServer* m_server;
+    //遥测环，按序号 & (TELEMETRY_CAPACITY - 1) 取槽位，所有客户端共用
+    QVector<QByteArray> m_telemetry;
+    qint64 m_nHead = 0;
+    quint64 m_nDropped = 0;
+    QHash<QTcpSocket*, BridgeClient> m_clients;
+};
+
+#endif // NETWORKBRIDGE_H
@@ -0,0 +1,201 @@
+#include "playbacksource.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QDebug>
+
+PlaybackSource::PlaybackSource(QObject *parent) : QThread(parent)
+{
+
+}
+
+PlaybackSource::~PlaybackSource()
+{
+    stop();
+}
+
+bool PlaybackSource::open(const QString &filePath, int startIndex)
+{
+    stop();
+
+    m_strFilePath = filePath;
+    m_strCachePath.clear();
+    m_nStartIndex = startIndex;
+
+    QFileInfo fileInfo(filePath);
+    if(fileInfo.suffix() == TRAJECTORY_SUFFIX)
+    {
+        if(!m_reader.open(filePath))
+        {
+            return false;
+        }
+    }else{
+        //缓存名带文本的修改时间和大小，存在即有效，否则边读文本边回放
+        QString cachePath = TrajectoryFile::cachePathFor(filePath);
+        if(!QFile::exists(cachePath) || !m_reader.open(cachePath))
+        {
+            if(!fileInfo.exists())
+            {
+                qDebug() << "Playback file not found:" << filePath;
+                return false;
+            }
+            m_strCachePath = cachePath;
+        }
+    }
+
+    //文本记录没有时间戳
+    m_bTimed = m_reader.isOpen() && m_reader.isTimed();
+
+    m_nHead = 0;
+    m_nSize = 0;
+    m_bAbort = false;
+    m_bFinished = false;
+    start();
+    return true;
+}
+
+void PlaybackSource::stop()
+{
+    m_mutex.lock();
+    m_bAbort = true;
+    m_notFull.wakeAll();
+    m_mutex.unlock();
+
+    wait();
+    m_reader.close();
+
+    QMutexLocker locker(&m_mutex);
+    m_nHead = 0;
+    m_nSize = 0;
+    m_bFinished = true;
+}
+
+bool PlaybackSource::take(TrajectoryRecord &record, int waitMs)
+{
+    QMutexLocker locker(&m_mutex);
+    if(m_nSize == 0 && !m_bFinished && waitMs > 0)
+    {
+        m_notEmpty.wait(&m_mutex, static_cast<unsigned long>(waitMs));
+    }
+    if(m_nSize == 0)
+    {
+        return false;
+    }
+
+    record = m_ring[m_nHead];
+    m_nHead = (m_nHead + 1) % RING_SIZE;
+    --m_nSize;
+    m_notFull.wakeOne();
+    return true;
+}
+
+bool PlaybackSource::atEnd() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bFinished && m_nSize == 0;
+}
+
+void PlaybackSource::run()
+{
+    if(m_reader.isOpen())
+    {
+        streamTrajectory();
+    }else{
+        streamText();
+    }
+    finish();
+}
+
+void PlaybackSource::streamTrajectory()
+{
+    //映射页在这里首次访问，缺页读盘发生在预读线程而不是界面线程
+    for(int i = m_nStartIndex; i < m_reader.count(); ++i)
+    {
+        if(!push(m_reader.record(i)))
+        {
+            return;
+        }
+    }
+}
+
+void PlaybackSource::streamText()
+{
+    QFile textFile(m_strFilePath);
+    if(!textFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        qDebug() << "Failed to open text record:" << m_strFilePath;
+        return;
+    }
+
+    //顺带写出二进制缓存，完整读完才发布，下次继续回放时可以直接定位
+    QString tempPath = TrajectoryFile::tempPathFor(m_strCachePath);
+    TrajectoryWriter writer;
+    if(!m_strCachePath.isEmpty())
+    {
+        writer.open(tempPath, TRAJECTORY_FLAG_UNTIMED);
+    }
+
+    bool bComplete = true;
+    int nIndex = 0;
+    char line[256];
+    TrajectoryRecord record;
+    while(textFile.readLine(line, sizeof(line)) > 0)
+    {
+        if(!TrajectoryFile::parseTextLine(line, record))
+        {
+            continue;
+        }
+        if(nIndex == 0)
+        {
+            record.flags |= RECORD_FLAG_SEGMENT_START;
+        }
+        if(writer.isOpen() && !writer.append(record))
+        {
+            //缓存写不下去不影响回放
+            writer.close();
+            QFile::remove(tempPath);
+        }
+        if(nIndex++ >= m_nStartIndex && !push(record))
+        {
+            bComplete = false;
+            break;
+        }
+    }
+    textFile.close();
+
+    if(writer.isOpen())
+    {
+        writer.close();
+        if(bComplete)
+        {
+            TrajectoryFile::publishCache(tempPath, m_strCachePath);
+        }else{
+            QFile::remove(tempPath);
+        }
+    }
+}
+
+bool PlaybackSource::push(const TrajectoryRecord &record)
+{
+    QMutexLocker locker(&m_mutex);
+    while(m_nSize == RING_SIZE && !m_bAbort)
+    {
+        m_notFull.wait(&m_mutex);
+    }
+    if(m_bAbort)
+    {
+        return false;
+    }
+
+    m_ring[(m_nHead + m_nSize) % RING_SIZE] = record;
+    ++m_nSize;
+    m_notEmpty.wakeOne();
+    return true;
+}
+
+void PlaybackSource::finish()
+{
+    QMutexLocker locker(&m_mutex);
+    m_bFinished = true;
+    m_notEmpty.wakeAll();
+}
@@ -0,0 +1,63 @@
+#ifndef PLAYBACKSOURCE_H
+#define PLAYBACKSOURCE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QString>
+#include "trajectoryfile.h"
+
+// 回放数据源：后台线程预读固定数量的记录，内存占用与文件大小无关
+// 文本记录边读边解析，不需要先整体转换；.trj文件从映射中顺序取出
+class PlaybackSource : public QThread
+{
+    Q_OBJECT
+public:
+    //开始回放时等待第一条记录的最长时间
+    static const int FIRST_RECORD_WAIT_MS = 5;
+
+    explicit PlaybackSource(QObject *parent = nullptr);
+    ~PlaybackSource();
+
+    //从第startIndex条记录开始预读，会先停止上一次的回放
+    bool open(const QString& filePath, int startIndex = 0);
+    void stop();
+
+    //取出下一条记录，队列为空时最多等待waitMs毫秒
+    bool take(TrajectoryRecord& record, int waitMs = 0);
+    //文件已读完且队列已取空
+    bool atEnd() const;
+    //记录带有效时间戳，可以按采集时的节奏回放
+    bool isTimed() const { return m_bTimed; }
+
+protected:
+    void run() override;
+
+private:
+    void streamText();
+    void streamTrajectory();
+    //队列满时阻塞，停止时返回false
+    bool push(const TrajectoryRecord& record);
+    void finish();
+
+private:
+    //预读窗口，32字节一条，共8KB
+    static const int RING_SIZE = 256;
+
+    TrajectoryRecord m_ring[RING_SIZE];
+    int m_nHead = 0;
+    int m_nSize = 0;
+    bool m_bAbort = false;
+    bool m_bFinished = true;
+    mutable QMutex m_mutex;
+    QWaitCondition m_notFull;
+    QWaitCondition m_notEmpty;
+
+    QString m_strFilePath;
+    QString m_strCachePath;   //文本记录读完后顺带生成的缓存，空表示不生成
+    int m_nStartIndex = 0;
+    bool m_bTimed = false;
+    TrajectoryReader m_reader;
+};
+
+#endif // PLAYBACKSOURCE_H
@@ -0,0 +1,90 @@
+#include "posemath.h"
+#include <QVector3D>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+#define RAD_TO_DEG (180.0 / M_PI)
+#define DEG_TO_RAD (M_PI / 180.0)
+
+QQuaternion PoseMath::fromAbc(const float *abc)
+{
+    return QQuaternion::fromAxisAndAngle(QVector3D(0, 0, 1), abc[2])
+            * QQuaternion::fromAxisAndAngle(QVector3D(0, 1, 0), abc[1])
+            * QQuaternion::fromAxisAndAngle(QVector3D(1, 0, 0), abc[0]);
+}
+
+void PoseMath::toAbc(const QQuaternion &q, float *abc)
+{
+    double w = q.scalar();
+    double x = q.x();
+    double y = q.y();
+    double z = q.z();
+
+    double m[9];
+    m[0] = 1 - 2 * (y * y + z * z);
+    m[1] = 2 * (x * y - w * z);
+    m[2] = 2 * (x * z + w * y);
+    m[3] = 2 * (x * y + w * z);
+    m[4] = 1 - 2 * (x * x + z * z);
+    m[5] = 2 * (y * z - w * x);
+    m[6] = 2 * (x * z - w * y);
+    m[7] = 2 * (y * z + w * x);
+    m[8] = 1 - 2 * (x * x + y * y);
+    fromMatrix(m, abc);
+}
+
+void PoseMath::toMatrix(const float *abc, double *m)
+{
+    double sa = std::sin(abc[0] * DEG_TO_RAD);
+    double ca = std::cos(abc[0] * DEG_TO_RAD);
+    double sb = std::sin(abc[1] * DEG_TO_RAD);
+    double cb = std::cos(abc[1] * DEG_TO_RAD);
+    double sc = std::sin(abc[2] * DEG_TO_RAD);
+    double cc = std::cos(abc[2] * DEG_TO_RAD);
+
+    m[0] = cc * cb;
+    m[1] = cc * sb * sa - sc * ca;
+    m[2] = cc * sb * ca + sc * sa;
+    m[3] = sc * cb;
+    m[4] = sc * sb * sa + cc * ca;
+    m[5] = sc * sb * ca - cc * sa;
+    m[6] = -sb;
+    m[7] = cb * sa;
+    m[8] = cb * ca;
+}
+
+void PoseMath::fromMatrix(const double *m, float *abc)
+{
+    double sinB = -m[6];
+    if(sinB > 1)
+    {
+        sinB = 1;
+    }else if(sinB < -1)
+    {
+        sinB = -1;
+    }
+    abc[1] = static_cast<float>(std::asin(sinB) * RAD_TO_DEG);
+
+    if(std::fabs(sinB) > 0.999999)
+    {
+        //万向节锁
+        abc[0] = 0;
+        abc[2] = static_cast<float>(std::atan2(-m[1], m[4]) * RAD_TO_DEG);
+    }else{
+        abc[0] = static_cast<float>(std::atan2(m[7], m[8]) * RAD_TO_DEG);
+        abc[2] = static_cast<float>(std::atan2(m[3], m[0]) * RAD_TO_DEG);
+    }
+}
+
+float PoseMath::angleBetween(const QQuaternion &q0, const QQuaternion &q1)
+{
+    double dot = std::fabs(double(q0.scalar()) * q1.scalar() + double(q0.x()) * q1.x()
+                           + double(q0.y()) * q1.y() + double(q0.z()) * q1.z());
+    if(dot > 1)
+    {
+        dot = 1;
+    }
+    return static_cast<float>(2 * std::acos(dot) * RAD_TO_DEG);
+}
@@ -0,0 +1,23 @@
+#ifndef POSEMATH_H
+#define POSEMATH_H
+
+#include <QQuaternion>
+
+// 控制器位姿中的姿态a b c（度）与四元数、旋转矩阵互转
+// 与固件一致：a绕X、b绕Y、c绕Z，R = Rz(c) * Ry(b) * Rx(a)
+class PoseMath
+{
+public:
+    static QQuaternion fromAbc(const float* abc);
+    //b为±90度时a、c不唯一，取a = 0
+    static void toAbc(const QQuaternion& q, float* abc);
+
+    //旋转矩阵按行存放，m[3 * row + col]
+    static void toMatrix(const float* abc, double* m);
+    static void fromMatrix(const double* m, float* abc);
+
+    //两个姿态之间的夹角（度）
+    static float angleBetween(const QQuaternion& q0, const QQuaternion& q1);
+};
+
+#endif // POSEMATH_H
@@ -0,0 +1,177 @@
+#include "replyparser.h"
+#include <QtGlobal>
+#include <cmath>
+
+//指数超出该范围时结果一定溢出为无穷或下溢为0
+#define MAX_EXPONENT 400
+
+//double可以精确表示的10的幂
+static const double s_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool isSeparator(char c)
+{
+    return c == ' ' || c == '\t' || c == ',' || c == '\r' || c == '\n';
+}
+
+static inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+int ReplyParser::parseValues(const char *data, int size, float *values, int maxCount)
+{
+    int nCount = 0;
+    int i = 0;
+    while(i < size)
+    {
+        char c = data[i];
+        if(isSeparator(c))
+        {
+            ++i;
+            continue;
+        }
+        //"ok"作为单独的一个词出现时跳过
+        if((c == 'o' || c == 'O') && i + 1 < size && (data[i + 1] == 'k' || data[i + 1] == 'K')
+                && (i + 2 == size || isSeparator(data[i + 2])))
+        {
+            i += 2;
+            continue;
+        }
+        if(nCount >= maxCount)
+        {
+            break;
+        }
+
+        float value;
+        int nUsed = parseFloat(data + i, size - i, value);
+        if(nUsed == 0)
+        {
+            return -1;
+        }
+        i += nUsed;
+        //数值后面必须是分隔符，"1.5x"这样的内容不算数值
+        if(i < size && !isSeparator(data[i]))
+        {
+            return -1;
+        }
+        values[nCount++] = value;
+    }
+    return nCount;
+}
+
+bool ReplyParser::parsePose(const char *data, int size, float *pose)
+{
+    //多取一个，用来判断是否恰好6个
+    float values[7];
+    if(parseValues(data, size, values, 7) != 6)
+    {
+        return false;
+    }
+    for(int i = 0; i < 6; ++i)
+    {
+        pose[i] = values[i];
+    }
+    return true;
+}
+
+int ReplyParser::parseFloat(const char *data, int size, float &value)
+{
+    int i = 0;
+    bool bNegative = false;
+    if(i < size && (data[i] == '+' || data[i] == '-'))
+    {
+        bNegative = (data[i] == '-');
+        ++i;
+    }
+
+    //有效数字累加到整数里，最后只做一次乘除，结果和逐位计算相比误差更小
+    quint64 mantissa = 0;
+    int nDigits = 0;
+    int exponent = 0;
+    bool bHasDigits = false;
+    while(i < size && isDigit(data[i]))
+    {
+        bHasDigits = true;
+        if(nDigits < MAX_DIGITS)
+        {
+            mantissa = mantissa * 10 + quint64(data[i] - '0');
+            if(mantissa != 0)
+            {
+                ++nDigits;
+            }
+        }else{
+            ++exponent;
+        }
+        ++i;
+    }
+    if(i < size && data[i] == '.')
+    {
+        ++i;
+        while(i < size && isDigit(data[i]))
+        {
+            bHasDigits = true;
+            if(nDigits < MAX_DIGITS)
+            {
+                mantissa = mantissa * 10 + quint64(data[i] - '0');
+                if(mantissa != 0)
+                {
+                    ++nDigits;
+                }
+                --exponent;
+            }
+            ++i;
+        }
+    }
+    if(!bHasDigits)
+    {
+        return 0;
+    }
+
+    //指数部分不完整时（如"1e"）只取前面的数值，由调用者判断后面的字符
+    if(i < size && (data[i] == 'e' || data[i] == 'E'))
+    {
+        int j = i + 1;
+        bool bNegativeExp = false;
+        if(j < size && (data[j] == '+' || data[j] == '-'))
+        {
+            bNegativeExp = (data[j] == '-');
+            ++j;
+        }
+        if(j < size && isDigit(data[j]))
+        {
+            int nExp = 0;
+            while(j < size && isDigit(data[j]))
+            {
+                if(nExp < MAX_EXPONENT * 10)
+                {
+                    nExp = nExp * 10 + (data[j] - '0');
+                }
+                ++j;
+            }
+            exponent += bNegativeExp ? -nExp : nExp;
+            i = j;
+        }
+    }
+
+    double result = double(mantissa);
+    if(mantissa == 0 || exponent < -MAX_EXPONENT)
+    {
+        result = 0;
+    }else if(exponent > MAX_EXPONENT)
+    {
+        result = HUGE_VAL;
+    }else if(exponent >= 0 && exponent <= 22)
+    {
+        result *= s_pow10[exponent];
+    }else if(exponent < 0 && exponent >= -22)
+    {
+        result /= s_pow10[-exponent];
+    }else{
+        result *= std::pow(10.0, exponent);
+    }
+    value = static_cast<float>(bNegative ? -result : result);
+    return i;
+}
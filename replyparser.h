@@ -0,0 +1,21 @@
+#ifndef REPLYPARSER_H
+#define REPLYPARSER_H
+
+// 位姿/关节角应答的数值解析，直接在接收缓冲区上进行，不分配内存、不依赖'\0'结尾和系统区域设置
+// 数值之间可以是任意个空格、制表符、逗号或换行，"ok"可以出现在数值之前或之后
+class ReplyParser
+{
+public:
+    //单个数值最多取这么多位有效数字，之后的数字只影响数量级
+    static const int MAX_DIGITS = 18;
+
+    //按顺序取出最多maxCount个数值，返回个数；遇到既不是数值也不是"ok"的内容返回-1
+    static int parseValues(const char* data, int size, float* values, int maxCount);
+    //恰好6个数值时写入pose并返回true
+    static bool parsePose(const char* data, int size, float* pose);
+
+    //从data开头解析一个十进制数[+-]digits[.digits][e[+-]digits]，返回消耗的字节数，不是数值返回0
+    static int parseFloat(const char* data, int size, float& value);
+};
+
+#endif // REPLYPARSER_H
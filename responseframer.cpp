@@ -0,0 +1,114 @@
+#include "responseframer.h"
+#include "replyparser.h"
+
+ResponseFramer::ResponseFramer()
+{
+
+}
+
+void ResponseFramer::append(const QByteArray &data)
+{
+    //之前的帧可能还在其他线程排队，不能在它们共享的缓冲区上原地删除
+    if(m_nReadPos >= m_buffer.size())
+    {
+        //帧都已取走（最常见）：直接共享本次读到的数据，不拷贝
+        m_buffer = data;
+    }else{
+        //只拷贝剩下的半帧；被帧引用的缓冲区append时会先分离
+        if(m_nReadPos > 0)
+        {
+            m_buffer = m_buffer.mid(m_nReadPos);
+        }
+        m_buffer.append(data);
+    }
+    m_nReadPos = 0;
+
+    //长时间收不到换行，说明数据错乱，整体丢弃
+    if(m_buffer.size() > MAX_LINE_LENGTH && m_buffer.indexOf('\n') < 0)
+    {
+        m_buffer.clear();
+    }
+}
+
+bool ResponseFramer::takeFrame(ResponseFrame &frame)
+{
+    while(m_nReadPos < m_buffer.size())
+    {
+        int nEnd = m_buffer.indexOf('\n', m_nReadPos);
+        if(nEnd < 0)
+        {
+            return false;
+        }
+
+        int nLineEnd = nEnd;
+        if(nLineEnd > m_nReadPos && m_buffer.at(nLineEnd - 1) == '\r')
+        {
+            --nLineEnd;
+        }
+
+        int nStart = m_nReadPos;
+        m_nReadPos = nEnd + 1;
+
+        //跳过空行
+        if(nLineEnd == nStart)
+        {
+            continue;
+        }
+
+        //共享缓冲区，只记录位置，不分配也不拷贝
+        frame.buffer = m_buffer;
+        frame.lineOffset = nStart;
+        frame.lineSize = nLineEnd - nStart;
+        classify(frame);
+        return true;
+    }
+    return false;
+}
+
+void ResponseFramer::clear()
+{
+    m_buffer.clear();
+    m_nReadPos = 0;
+}
+
+void ResponseFramer::classify(ResponseFrame &frame)
+{
+    const char* data = frame.line();
+    int nSize = frame.lineSize;
+    frame.payloadOffset = 0;
+
+    //六个数值即为位姿/关节角应答，多取一个用来排除更长的数值行
+    float values[7];
+    if(nSize >= 2 && data[0] == 'o' && data[1] == 'k')
+    {
+        frame.payloadOffset = 2;
+        int nCount = ReplyParser::parseValues(data + 2, nSize - 2, values, 7);
+        frame.type = (nCount == 6) ? FRAME_POSITION : FRAME_OK;
+        return;
+    }
+
+    //部分固件先发数值、最后才是"ok"
+    char c = data[0];
+    if((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.')
+    {
+        if(ReplyParser::parseValues(data, nSize, values, 7) == 6)
+        {
+            frame.type = FRAME_POSITION;
+            return;
+        }
+    }
+
+    if(startsWithNoCase(data, nSize, "err") || startsWithNoCase(data, nSize, "unknown")
+            || startsWithNoCase(data, nSize, "invalid"))
+    {
+        frame.type = FRAME_ERROR;
+    }else{
+        frame.type = FRAME_TEXT;
+    }
+}
+
+bool ResponseFramer::startsWithNoCase(const char *data, int size, const char *prefix)
+{
+    int nLength = int(qstrlen(prefix));
+    return size >= nLength && qstrnicmp(data, prefix, uint(nLength)) == 0;
+}
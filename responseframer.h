@@ -0,0 +1,65 @@
+#ifndef RESPONSEFRAMER_H
+#define RESPONSEFRAMER_H
+
+#include <QByteArray>
+#include <QMetaType>
+
+typedef enum FrameType
+{
+    FRAME_POSITION,  //位姿/关节角应答 "ok x y z a b c"，"ok"也可以在末尾
+    FRAME_OK,        //指令确认 "ok"
+    FRAME_ERROR,     //错误应答
+    FRAME_TEXT       //其他文本
+}FRAME_TYPE;
+
+// 控制器应答帧，一帧对应一行（不含\r\n）
+// 帧不单独拷贝这一行：buffer与拆帧器的接收缓冲区隐式共享，行是其中[lineOffset, lineOffset + lineSize)
+// 拆帧器不会原地修改仍被帧引用的缓冲区，排队送到其他线程的帧一直有效
+struct ResponseFrame
+{
+    FRAME_TYPE type = FRAME_TEXT;
+    QByteArray buffer;
+    int lineOffset = 0;
+    int lineSize = 0;
+    //数据部分相对行首的位置，位姿应答为"ok"之后
+    int payloadOffset = 0;
+    //串口线程收到这一帧的时刻，monotonicNs()
+    qint64 timestampNs = 0;
+    //按应答顺序配对到的指令CMD_TYPE，没有配对为-1
+    int command = -1;
+
+    const char* line() const { return buffer.constData() + lineOffset; }
+    const char* payload() const { return line() + payloadOffset; }
+    int payloadSize() const { return lineSize - payloadOffset; }
+};
+Q_DECLARE_METATYPE(ResponseFrame)
+
+// 串口线程中使用的流式拆帧器：累积字节，按行拆分并识别应答类型
+class ResponseFramer
+{
+public:
+    ResponseFramer();
+
+    //追加一次readyRead读到的数据
+    void append(const QByteArray& data);
+
+    //取出一个完整帧，没有完整帧时返回false
+    bool takeFrame(ResponseFrame& frame);
+
+    void clear();
+
+private:
+    static void classify(ResponseFrame& frame);
+    static bool startsWithNoCase(const char* data, int size, const char* prefix);
+
+private:
+    //单行最大长度，超过仍未收到换行则丢弃，防止缓冲区无限增长
+    static const int MAX_LINE_LENGTH = 1024;
+
+    //取出的帧共享这块缓冲区
+    QByteArray m_buffer;
+    //已经取走的数据位置，下次append时统一丢弃
+    int m_nReadPos = 0;
+};
+
+#endif // RESPONSEFRAMER_H
@@ -0,0 +1,94 @@
+#include "robotstate.h"
+#include "commanddefs.h"
+#include "replyparser.h"
+#include <atomic>
+#include <cstring>
+
+RobotState::RobotState()
+    : m_nSeqLock(0)
+{
+}
+
+void RobotState::beginWrite()
+{
+    //序号变为奇数，之后的数据写入不能排到它前面
+    m_nSeqLock.store(m_nSeqLock.load() + 1);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void RobotState::endWrite()
+{
+    ++m_data.sequence;
+    m_nSeqLock.storeRelease(m_nSeqLock.load() + 1);
+}
+
+void RobotState::updateJoints(const float *joints, qint64 timestampNs)
+{
+    beginWrite();
+    memcpy(m_data.joints, joints, sizeof(m_data.joints));
+    m_data.jointTimestampNs = timestampNs;
+    endWrite();
+}
+
+void RobotState::updatePose(const float *pose, qint64 timestampNs)
+{
+    beginWrite();
+    memcpy(m_data.pose, pose, sizeof(m_data.pose));
+    m_data.poseTimestampNs = timestampNs;
+    endWrite();
+}
+
+bool RobotState::update(const ResponseFrame &frame, int cmd)
+{
+    if(frame.type != FRAME_POSITION || (cmd != GETJPOS && cmd != GETLPOS))
+    {
+        return false;
+    }
+    //直接在接收缓冲区上解析，不拷贝
+    float values[6];
+    if(!ReplyParser::parsePose(frame.payload(), frame.payloadSize(), values))
+    {
+        return false;
+    }
+    if(cmd == GETJPOS)
+    {
+        updateJoints(values, frame.timestampNs);
+    }else{
+        updatePose(values, frame.timestampNs);
+    }
+    return true;
+}
+
+void RobotState::clear()
+{
+    beginWrite();
+    quint32 nSequence = m_data.sequence;
+    m_data = RobotSnapshot();
+    m_data.sequence = nSequence;
+    endWrite();
+}
+
+RobotSnapshot RobotState::snapshot() const
+{
+    RobotSnapshot data;
+    for(;;)
+    {
+        quint32 nBegin = m_nSeqLock.loadAcquire();
+        if(nBegin & 1)
+        {
+            //正在写，写入只有几十纳秒，直接重试
+            continue;
+        }
+        memcpy(&data, &m_data, sizeof(data));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(m_nSeqLock.load() == nBegin)
+        {
+            return data;
+        }
+    }
+}
+
+quint32 RobotState::sequence() const
+{
+    return m_nSeqLock.loadAcquire() / 2;
+}
@@ -0,0 +1,50 @@
+#ifndef ROBOTSTATE_H
+#define ROBOTSTATE_H
+
+#include <QAtomicInteger>
+#include "responseframer.h"
+
+// 机械臂状态的一份快照，时间戳为串口线程收到应答的时刻monotonicNs()，0表示还没有收到
+struct RobotSnapshot
+{
+    float joints[6] = {0, 0, 0, 0, 0, 0};
+    float pose[6] = {0, 0, 0, 0, 0, 0};
+    qint64 jointTimestampNs = 0;
+    qint64 poseTimestampNs = 0;
+    //每次更新加1
+    quint32 sequence = 0;
+
+    bool hasJoints() const { return jointTimestampNs != 0; }
+    bool hasPose() const { return poseTimestampNs != 0; }
+};
+
+// 串口线程解析位姿应答后写入，其他线程无锁读取
+// 顺序锁：写入前后各把序号加1，读者读到奇数或前后序号不同就重读，写者从不等待
+class RobotState
+{
+public:
+    RobotState();
+
+    //只允许串口线程调用
+    void updateJoints(const float* joints, qint64 timestampNs);
+    void updatePose(const float* pose, qint64 timestampNs);
+    //cmd为与这一帧配对的指令，只处理GETJPOS、GETLPOS的位姿应答，返回是否更新
+    bool update(const ResponseFrame& frame, int cmd);
+    //断开连接后旧数据作废
+    void clear();
+
+    //任意线程调用，返回一致的快照
+    RobotSnapshot snapshot() const;
+    //已完成的更新次数，可用于判断有没有新数据
+    quint32 sequence() const;
+
+private:
+    void beginWrite();
+    void endWrite();
+
+private:
+    QAtomicInteger<quint32> m_nSeqLock;
+    RobotSnapshot m_data;
+};
+
+#endif // ROBOTSTATE_H
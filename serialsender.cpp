@@ -1,11 +1,24 @@
 #include "serialsender.h"
+#include "controllermodel.h"
+#include "monotonicclock.h"
+#include "asynclogger.h"
 #include <QDebug>
+#include <QTimer>
+#include <cstring>
+
+//轮询请求发出后等待应答的最长时间，超时重发
+#define POLL_TIMEOUT_MS 500
 
 SerialDataPort::SerialDataPort(QObject *parent) : QObject(parent)
 {
 
 }
 
+SerialDataPort::~SerialDataPort()
+{
+    delete m_loopback;
+}
+
 void SerialDataPort::onError(QSerialPort::SerialPortError value)
 {
     if(value != 0)
@@ -20,12 +33,23 @@ void SerialDataPort::onInit()
 {
     m_serialPort = new QSerialPort;
     connect(m_serialPort, SIGNAL(readyRead()), this, SLOT(onRead()));
+    connect(m_serialPort, SIGNAL(bytesWritten(qint64)), this, SLOT(onBytesWritten(qint64)));
     connect(m_serialPort, SIGNAL(error(QSerialPort::SerialPortError)), this, SLOT(onError(QSerialPort::SerialPortError)));
 
 }
 
-void SerialDataPort::onOpen(const QString &portName, const int &baudRate)
+void SerialDataPort::onOpen(const QString &portName, const int &baudRate, const int &protocol)
 {
+    m_framer.clear();
+    m_protocol = static_cast<PROTOCOL_TYPE>(protocol);
+    if(portName == LOOPBACK_PORT_NAME)
+    {
+        delete m_loopback;
+        m_loopback = new ControllerModel(static_cast<PROTOCOL_TYPE>(protocol));
+        emit signalConnected();
+        return;
+    }
+
     m_serialPort->setPortName(portName);
     if(m_serialPort->open(QIODevice::ReadWrite))
     {
@@ -44,37 +68,253 @@ void SerialDataPort::onRead()
 {
     if (m_serialPort)
     {
+       //先取时间戳，不计入后面的处理耗时
+       qint64 timestampNs = monotonicNs();
        QByteArray data = m_serialPort->readAll();
-       emit signalReceived(data);
-       qDebug() << "serialport received : " << data.size() << data << endl;
+       AsyncLogger::logData(LOG_TRACE, "serialport received %1 bytes: %2", data.constData(), data.size());
+       handleReceived(data, timestampNs);
+    }
+}
+
+void SerialDataPort::setStats(const QSharedPointer<LinkStats> &stats)
+{
+    m_stats = stats;
+}
+
+void SerialDataPort::setChannel(SEND_CHANNEL channel, const QSharedPointer<CommandRing> &ring)
+{
+    m_channels[channel] = ring;
+}
+
+void SerialDataPort::setState(const QSharedPointer<RobotState> &state)
+{
+    m_state = state;
+}
+
+void SerialDataPort::onDrainChannels()
+{
+    int nSize = 0;
+    for(int i = 0; i < CHANNEL_COUNT; ++i)
+    {
+        CommandRing* ring = m_channels[i].data();
+        if(!ring)
+        {
+            continue;
+        }
+        ring->clearPending();
+        //界面通道的停止等指令不受积压限制
+        if(i != CHANNEL_GUI && m_bThrottled)
+        {
+            continue;
+        }
+        int nCmdSize = 0;
+        const char* data;
+        while((data = ring->front(nCmdSize)) != nullptr)
+        {
+            if(nSize + nCmdSize > TX_BUFFER_SIZE)
+            {
+                writeData(m_txBuffer, nSize);
+                nSize = 0;
+                if(i != CHANNEL_GUI && isTxBusy())
+                {
+                    setThrottled(true);
+                    break;
+                }
+            }
+            memcpy(m_txBuffer + nSize, data, size_t(nCmdSize));
+            nSize += nCmdSize;
+            m_stats->onDequeued();
+            ring->pop();
+        }
+    }
+    if(nSize > 0)
+    {
+        writeData(m_txBuffer, nSize);
+    }
+    if(isTxBusy())
+    {
+        setThrottled(true);
     }
 }
 
-void SerialDataPort::onWrite(const QByteArray &data)
+void SerialDataPort::onBytesWritten(qint64 bytes)
 {
-    m_serialPort->write(data);
+    Q_UNUSED(bytes);
+    if(m_bThrottled && m_serialPort->bytesToWrite() < TX_LOW_WATER)
+    {
+        setThrottled(false);
+        //暂停期间留在通道里的指令
+        onDrainChannels();
+    }
+}
+
+bool SerialDataPort::isTxBusy() const
+{
+    return !m_loopback && m_serialPort->bytesToWrite() >= TX_HIGH_WATER;
+}
+
+void SerialDataPort::setThrottled(bool bThrottled)
+{
+    if(m_bThrottled == bThrottled)
+    {
+        return;
+    }
+    m_bThrottled = bThrottled;
+    for(int i = 0; i < CHANNEL_COUNT; ++i)
+    {
+        if(i != CHANNEL_GUI && m_channels[i])
+        {
+            m_channels[i]->setThrottled(bThrottled);
+        }
+    }
+    AsyncLogger::log(LOG_DEBUG, "tx throttled %1, backlog %2 bytes", bThrottled, m_serialPort->bytesToWrite());
+}
+
+void SerialDataPort::writeData(const char *data, int size)
+{
+    if(m_loopback)
+    {
+        m_stats->onWritten(data, size, m_protocol, monotonicNs(), 0);
+        //模拟控制器的应答放到下一次事件循环，和真实串口一样异步到达
+        m_loopbackReply += m_loopback->feed(QByteArray::fromRawData(data, size));
+        if(!m_loopbackReply.isEmpty())
+        {
+            QTimer::singleShot(0, this, SLOT(onLoopbackRead()));
+        }
+        return;
+    }
+    //写入前取时间戳，和应答的时间戳相减即为链路加控制器的延迟
+    m_stats->onWritten(data, size, m_protocol, monotonicNs(), m_serialPort->bytesToWrite());
+    m_serialPort->write(data, size);
 }
 
 void SerialDataPort::onClose()
 {
-    m_serialPort->close();
+    if(m_loopback)
+    {
+        delete m_loopback;
+        m_loopback = nullptr;
+        m_loopbackReply.clear();
+    }else{
+        m_serialPort->close();
+    }
+    setThrottled(false);
+    onStopPolling();
+    m_state->clear();
+    m_framer.clear();
     emit signalDisconnected();
 }
 
+void SerialDataPort::onLoopbackRead()
+{
+    if(m_loopbackReply.isEmpty())
+    {
+        return;
+    }
+    QByteArray data = m_loopbackReply;
+    m_loopbackReply.clear();
+    handleReceived(data, monotonicNs());
+}
+
+void SerialDataPort::handleReceived(const QByteArray &data, qint64 timestampNs)
+{
+    emit signalReceived(data);
+    m_stats->onBytesReceived(data.size());
+
+    //一次readyRead可能只有半帧，也可能有多帧
+    m_framer.append(data);
+    ResponseFrame frame;
+    bool bPollReplied = false;
+    while(m_framer.takeFrame(frame))
+    {
+        frame.timestampNs = timestampNs;
+        frame.command = m_stats->onFrame(frame);
+        //先更新状态再通知界面线程，收到信号时快照里已经是这一帧的数据
+        m_state->update(frame, frame.command);
+        bPollReplied |= (frame.type == FRAME_POSITION);
+        emit signalFrameReceived(frame);
+    }
+
+    //收到应答再发下一次请求，采样率只受链路和控制器的限制
+    if(m_bPolling && bPollReplied)
+    {
+        qint64 nRemainMs = m_nPollIntervalMs - m_pollClock.elapsed();
+        if(nRemainMs <= 0)
+        {
+            sendPoll();
+        }else{
+            m_pollTimer->start(static_cast<int>(nRemainMs));
+        }
+    }
+}
+
+void SerialDataPort::onStartPolling(const QByteArray &request, int intervalMs)
+{
+    if(!m_pollTimer)
+    {
+        m_pollTimer = new QTimer(this);
+        m_pollTimer->setSingleShot(true);
+        m_pollTimer->setTimerType(Qt::PreciseTimer);
+        connect(m_pollTimer, SIGNAL(timeout()), this, SLOT(onPollTimeout()));
+    }
+    m_pollRequest = request;
+    m_nPollIntervalMs = intervalMs;
+    m_bPolling = true;
+    sendPoll();
+}
+
+void SerialDataPort::onStopPolling()
+{
+    m_bPolling = false;
+    if(m_pollTimer)
+    {
+        m_pollTimer->stop();
+    }
+}
+
+void SerialDataPort::onPollTimeout()
+{
+    //间隔到了，或者应答丢失
+    if(m_bPolling)
+    {
+        sendPoll();
+    }
+}
+
+void SerialDataPort::sendPoll()
+{
+    writeData(m_pollRequest.constData(), m_pollRequest.size());
+    m_pollClock.start();
+    m_pollTimer->start(POLL_TIMEOUT_MS);
+}
+
 SerialSender::SerialSender(QObject *parent) : QObject(parent)
 {
+    qRegisterMetaType<ResponseFrame>("ResponseFrame");
     m_thread = new QThread;
     m_serialDataPort = new SerialDataPort();
+    //统计由两个线程共用，串口线程的对象晚于本对象删除，用共享指针
+    m_stats = QSharedPointer<LinkStats>(new LinkStats);
+    m_serialDataPort->setStats(m_stats);
+    for(int i = 0; i < CHANNEL_COUNT; ++i)
+    {
+        m_channels[i] = QSharedPointer<CommandRing>(new CommandRing);
+        m_serialDataPort->setChannel(static_cast<SEND_CHANNEL>(i), m_channels[i]);
+    }
+    m_state = QSharedPointer<RobotState>(new RobotState);
+    m_serialDataPort->setState(m_state);
     //向串口操作
     //打开
-    connect(this, SIGNAL(signalOpen(QString, int)), m_serialDataPort, SLOT(onOpen(QString, int)));
-    //写入
-    connect(this, SIGNAL(signalWrite(const QByteArray&)), m_serialDataPort, SLOT(onWrite(const QByteArray&)));
+    connect(this, SIGNAL(signalOpen(QString, int, int)), m_serialDataPort, SLOT(onOpen(QString, int, int)));
     //关闭
     connect(this, SIGNAL(signalClose()), m_serialDataPort, SLOT(onClose()));
+    //轮询
+    connect(this, SIGNAL(signalStartPolling(const QByteArray&, int)), m_serialDataPort, SLOT(onStartPolling(const QByteArray&, int)));
+    connect(this, SIGNAL(signalStopPolling()), m_serialDataPort, SLOT(onStopPolling()));
     //接收串口信号
     //接收
     connect(m_serialDataPort, SIGNAL(signalReceived(const QByteArray&)), this, SLOT(onReceiveDatas(const QByteArray&)));//发送接收数据
+    connect(m_serialDataPort, SIGNAL(signalFrameReceived(ResponseFrame)), this, SLOT(onReceiveFrame(ResponseFrame)));//发送应答帧
     //错误
     connect(m_serialDataPort, SIGNAL(signalError(QString)), this, SIGNAL(signalError(QString)));
     //连接
@@ -101,27 +341,62 @@ SerialSender::~SerialSender()
     emit signalQuiting();
 }
 
-void SerialSender::sendDatas(const QByteArray &data)
+bool SerialSender::sendDatas(const QByteArray &data, SEND_CHANNEL channel)
 {
-    write(data);
+    return sendDatas(data.constData(), data.size(), channel);
 }
 
-void SerialSender::open(const QString &strAddress, const int &number)
+bool SerialSender::sendDatas(const char *data, int size, SEND_CHANNEL channel)
 {
-    emit signalOpen(strAddress,number);
+    CommandRing* ring = m_channels[channel].data();
+    if(ring->isThrottled())
+    {
+        //串口积压，由调用者稍后重发
+        m_stats->onRejected();
+        return false;
+    }
+    if(!ring->push(data, size))
+    {
+        m_stats->onRejected();
+        AsyncLogger::log(LOG_WARN, "send channel %1 rejected %2 bytes", channel, size);
+        return false;
+    }
+    m_stats->onQueued();
+    //串口线程已经有待处理的唤醒时不再投递事件
+    if(ring->markPending())
+    {
+        QMetaObject::invokeMethod(m_serialDataPort, "onDrainChannels", Qt::QueuedConnection);
+    }
+    return true;
 }
 
-void SerialSender::close()
+void SerialSender::open(const QString &strAddress, const int &number, PROTOCOL_TYPE protocol)
 {
-    emit signalClose();
+    m_protocol = protocol;
+    emit signalOpen(strAddress,number,protocol);
+}
+
+void SerialSender::startPolling(const QByteArray &request, int intervalMs)
+{
+    emit signalStartPolling(request, intervalMs);
+}
+
+void SerialSender::stopPolling()
+{
+    emit signalStopPolling();
 }
 
-void SerialSender::write(const QByteArray &data)
+void SerialSender::close()
 {
-    emit signalWrite(data);
+    emit signalClose();
 }
 
 void SerialSender::onReceiveDatas(const QByteArray &rawData)
 {
     emit signalReceived(rawData);
 }
+
+void SerialSender::onReceiveFrame(const ResponseFrame &frame)
+{
+    emit signalFrameReceived(frame);
+}
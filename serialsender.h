@@ -8,47 +8,98 @@
 #include <QMutex>
 #include <QWaitCondition>
 #include <QByteArray>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include "responseframer.h"
+#include "linkstats.h"
+#include "commanddefs.h"
+#include "commandring.h"
+#include "robotstate.h"
 
-typedef enum CmdType
+//本地模拟控制器的端口名，无机械臂时用于测试
+#define LOOPBACK_PORT_NAME "LOOPBACK"
+
+class ControllerModel;
+
+//发送通道：每个通道只允许一个线程写入，串口线程按顺序取出，排在前面的优先
+typedef enum SendChannel
 {
-    STOP,
-    START,
-    HOME,
-    CALIBRATION,
-    RESET,
-    DISABLE,
-    GETJPOS,
-    GETLPOS,
-    CMDMODE,
-    MOVEJ,
-    MOVEL,
-    SETKP,
-    SETKI,
-    SETKD
-}CMD_TYPE;
+    CHANNEL_GUI,        //界面线程的单条指令
+    CHANNEL_SCHEDULER,  //调度线程的回放和点动
+    CHANNEL_NETWORK,    //NetworkBridge转发的远程客户端指令
+    CHANNEL_COUNT
+}SEND_CHANNEL;
 
 // 工作线程中执行串口操作的类
+// 每次被唤醒时把各通道中已有的指令拼成一块连续数据，一次write发出
+// 串口驱动积压超过TX_HIGH_WATER时只发界面通道，其余通道暂停接收，降到TX_LOW_WATER以下再恢复，
+// 积压的数据在当前波特率下最多需要TX_HIGH_WATER + TX_BUFFER_SIZE个字节的发送时间
 class SerialDataPort : public QObject
 {
     Q_OBJECT
 public:
+    static const int TX_BUFFER_SIZE = 1024;
+    static const int TX_HIGH_WATER = 512;
+    static const int TX_LOW_WATER = 128;
+
     explicit SerialDataPort(QObject *parent = nullptr);
+    ~SerialDataPort();
+
+    //移入线程之前设置
+    void setStats(const QSharedPointer<LinkStats>& stats);
+    void setChannel(SEND_CHANNEL channel, const QSharedPointer<CommandRing>& ring);
+    void setState(const QSharedPointer<RobotState>& state);
 
 signals:
     void signalReceived(const QByteArray& data);
+    void signalFrameReceived(const ResponseFrame& frame);
     void signalError(QString);
     void signalConnected();
     void signalDisconnected();
 public slots:
     void onError(QSerialPort::SerialPortError);
     void onInit();
-    void onOpen(const QString& portName, const int& baudRate);
+    void onOpen(const QString& portName, const int& baudRate, const int& protocol);
     void onRead();
-    void onWrite(const QByteArray& data);
+    //取出各发送通道中的全部指令写到串口
+    void onDrainChannels();
     void onClose();
+    //应答驱动的轮询：收到位姿应答后间隔intervalMs再发request，0表示立即发
+    void onStartPolling(const QByteArray& request, int intervalMs);
+    void onStopPolling();
+private slots:
+    void onLoopbackRead();
+    void onPollTimeout();
+    //串口驱动取走数据后检查是否可以恢复暂停的通道
+    void onBytesWritten(qint64 bytes);
+private:
+    void handleReceived(const QByteArray& data, qint64 timestampNs);
+    void writeData(const char* data, int size);
+    bool isTxBusy() const;
+    void setThrottled(bool bThrottled);
+    void sendPoll();
 private:
     QSerialPort* m_serialPort;
+    //本地模拟控制器，仅在打开LOOPBACK端口时存在
+    ControllerModel* m_loopback = nullptr;
+    QByteArray m_loopbackReply;
     mutable QMutex m_mutex;
+    //应答拆帧
+    ResponseFramer m_framer;
+    PROTOCOL_TYPE m_protocol = PROTOCOL_ASCII;
+    QSharedPointer<LinkStats> m_stats;
+    QSharedPointer<CommandRing> m_channels[CHANNEL_COUNT];
+    QSharedPointer<RobotState> m_state;
+    //合并后待写出的数据
+    char m_txBuffer[TX_BUFFER_SIZE];
+    bool m_bThrottled = false;
+    //轮询
+    QByteArray m_pollRequest;
+    int m_nPollIntervalMs = 0;
+    bool m_bPolling = false;
+    QTimer* m_pollTimer = nullptr;
+    QElapsedTimer m_pollClock;
 };
 
 // 供主线程使用的串口发送器类
@@ -59,37 +110,55 @@ public:
     explicit SerialSender(QObject *parent = nullptr);
     ~SerialSender();
 
-    void sendDatas(const QByteArray& data);
+    //数据拷贝进发送通道，由串口线程发送；同一通道只能由一个线程调用
+    //通道满、通道因串口积压暂停接收、或单条指令超过CommandRing::SLOT_SIZE时丢弃并返回false
+    bool sendDatas(const QByteArray& data, SEND_CHANNEL channel = CHANNEL_GUI);
+    bool sendDatas(const char* data, int size, SEND_CHANNEL channel = CHANNEL_GUI);
+
+    //在串口线程中轮询，见SerialDataPort::onStartPolling
+    void startPolling(const QByteArray& request, int intervalMs);
+    void stopPolling();
 
-    //打开 串口：串口号、波特率 网络：地址、端口
-    void open(const QString& strAddress, const int& number);
+    //打开串口：串口号、波特率；远程客户端通过NetworkBridge接入，不在这里打开
+    void open(const QString& strAddress, const int& number, PROTOCOL_TYPE protocol = PROTOCOL_ASCII);
 
     void close();
 
-private:
-    void write(const QByteArray& data);
+    //当前连接使用的指令编码方式
+    PROTOCOL_TYPE protocol() const { return m_protocol; }
+
+    //链路统计，可在任意线程读取
+    LinkStats* linkStats() const { return m_stats.data(); }
+    //最近一次收到的关节角和位姿，可在任意线程读取
+    RobotState* robotState() const { return m_state.data(); }
 
 private slots:
     //接收到数据
     void onReceiveDatas(const QByteArray &rawData);
+    //接收到完整应答帧
+    void onReceiveFrame(const ResponseFrame& frame);
 
 signals:
     //对外
     void signalReceived(const QByteArray& data);
+    void signalFrameReceived(const ResponseFrame& frame);
     void signalError(QString);
     void signalOpened();
     void signalClosed();
     //对内
-    void signalWrite(const QByteArray& data);
-    void signalOpen(QString str, int number);
+    void signalOpen(QString str, int number, int protocol);
     void signalClose();
+    void signalStartPolling(const QByteArray& request, int intervalMs);
+    void signalStopPolling();
     void signalQuiting();
 
 private:
     QThread* m_thread;
     SerialDataPort* m_serialDataPort;
-    //接收缓冲区
-    QByteArray m_receiveBuffer;
+    PROTOCOL_TYPE m_protocol = PROTOCOL_ASCII;
+    QSharedPointer<LinkStats> m_stats;
+    QSharedPointer<CommandRing> m_channels[CHANNEL_COUNT];
+    QSharedPointer<RobotState> m_state;
 };
 
 #endif // SERIALSENDER_H
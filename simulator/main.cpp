@@ -0,0 +1,69 @@
+// Dummy控制器模拟器：创建伪终端，上位机或基准测试打开打印出来的设备即可，不需要机械臂
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include "ptysimulator.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("dummy_simulator");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Dummy controller simulator on a pseudo terminal");
+    parser.addHelpOption();
+    QCommandLineOption linkOption("link", "Create a symlink to the pty slave.", "path");
+    QCommandLineOption baudOption("baud", "Simulated baud rate, 0 for unlimited (default 115200).", "rate", "115200");
+    QCommandLineOption latencyOption("latency", "Default command latency in us (default 500).", "us", "500");
+    QCommandLineOption cmdLatencyOption("cmd-latency", "Latency for one command, e.g. GETJPOS=2000. Repeatable.", "name=us");
+    QCommandLineOption fragmentOption("fragment", "Split replies into chunks of at most n bytes.", "n", "0");
+    QCommandLineOption gapOption("fragment-gap", "Extra gap between reply chunks in us.", "us", "0");
+    QCommandLineOption binaryOption("binary", "Speak the binary protocol instead of ASCII.");
+    QCommandLineOption verboseOption("verbose", "Log every command and reply.");
+    parser.addOption(linkOption);
+    parser.addOption(baudOption);
+    parser.addOption(latencyOption);
+    parser.addOption(cmdLatencyOption);
+    parser.addOption(fragmentOption);
+    parser.addOption(gapOption);
+    parser.addOption(binaryOption);
+    parser.addOption(verboseOption);
+    parser.process(a);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    SimulatorOptions options;
+    options.protocol = parser.isSet(binaryOption) ? PROTOCOL_BINARY : PROTOCOL_ASCII;
+    options.baudRate = parser.value(baudOption).toInt();
+    options.fragmentSize = parser.value(fragmentOption).toInt();
+    options.fragmentGapUs = parser.value(gapOption).toInt();
+    options.bVerbose = parser.isSet(verboseOption);
+    int nLatencyUs = parser.value(latencyOption).toInt();
+    for(int i = 0; i <= SETKD; ++i)
+    {
+        options.latencyUs[i] = nLatencyUs;
+    }
+    const QStringList cmdLatencies = parser.values(cmdLatencyOption);
+    for(int i = 0; i < cmdLatencies.size(); ++i)
+    {
+        QStringList pair = cmdLatencies.at(i).split('=');
+        CMD_TYPE cmd;
+        if(pair.size() != 2 || !PtySimulator::commandFromName(pair.at(0), cmd))
+        {
+            err << "bad --cmd-latency: " << cmdLatencies.at(i) << endl;
+            return 1;
+        }
+        options.latencyUs[cmd] = pair.at(1).toInt();
+    }
+
+    PtySimulator simulator(options);
+    if(!simulator.open(parser.value(linkOption)))
+    {
+        return 1;
+    }
+    //第一行输出设备名，脚本读这一行即可连接
+    out << simulator.slaveName() << endl;
+
+    return a.exec();
+}
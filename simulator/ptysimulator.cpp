@@ -0,0 +1,224 @@
+#include "ptysimulator.h"
+#include "monotonicclock.h"
+#include "commandencoder.h"
+#include <QSocketNotifier>
+#include <QFile>
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+//定时器只有毫秒精度，到期前这么久以内的分片直接睡到时刻再写
+#define SPIN_WINDOW_NS 1000000
+
+PtySimulator::PtySimulator(const SimulatorOptions &options, QObject *parent)
+    : QObject(parent), m_options(options), m_model(options.protocol)
+{
+    m_writeTimer = new QTimer(this);
+    m_writeTimer->setSingleShot(true);
+    m_writeTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_writeTimer, SIGNAL(timeout()), this, SLOT(onWriteTimeout()));
+}
+
+PtySimulator::~PtySimulator()
+{
+    close();
+}
+
+bool PtySimulator::open(const QString &linkPath)
+{
+    close();
+
+    m_nMasterFd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if(m_nMasterFd < 0 || grantpt(m_nMasterFd) != 0 || unlockpt(m_nMasterFd) != 0)
+    {
+        qDebug() << "failed to create pty:" << strerror(errno);
+        close();
+        return false;
+    }
+    m_strSlaveName = QString::fromLocal8Bit(ptsname(m_nMasterFd));
+
+    //原始模式，不回显、不转换换行，和真实串口一样透传字节
+    m_nSlaveFd = ::open(m_strSlaveName.toLocal8Bit().constData(), O_RDWR | O_NOCTTY);
+    if(m_nSlaveFd < 0)
+    {
+        qDebug() << "failed to open pty slave:" << m_strSlaveName;
+        close();
+        return false;
+    }
+    struct termios tio;
+    tcgetattr(m_nSlaveFd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(m_nSlaveFd, TCSANOW, &tio);
+
+    if(!linkPath.isEmpty())
+    {
+        QFile::remove(linkPath);
+        if(!QFile::link(m_strSlaveName, linkPath))
+        {
+            qDebug() << "failed to create link:" << linkPath;
+        }else{
+            m_strLinkPath = linkPath;
+        }
+    }
+
+    m_notifier = new QSocketNotifier(m_nMasterFd, QSocketNotifier::Read, this);
+    connect(m_notifier, SIGNAL(activated(int)), this, SLOT(onReadyRead()));
+    return true;
+}
+
+void PtySimulator::close()
+{
+    m_writeTimer->stop();
+    m_pending.clear();
+    delete m_notifier;
+    m_notifier = nullptr;
+    if(!m_strLinkPath.isEmpty())
+    {
+        QFile::remove(m_strLinkPath);
+        m_strLinkPath.clear();
+    }
+    if(m_nSlaveFd >= 0)
+    {
+        ::close(m_nSlaveFd);
+        m_nSlaveFd = -1;
+    }
+    if(m_nMasterFd >= 0)
+    {
+        ::close(m_nMasterFd);
+        m_nMasterFd = -1;
+    }
+}
+
+bool PtySimulator::commandFromName(const QString &name, CMD_TYPE &cmd)
+{
+    for(int i = 0; i <= SETKD; ++i)
+    {
+        if(name.compare(QLatin1String(CommandEncoder::spec(static_cast<CMD_TYPE>(i)).name), Qt::CaseInsensitive) == 0)
+        {
+            cmd = static_cast<CMD_TYPE>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void PtySimulator::onReadyRead()
+{
+    char buf[4096];
+    QByteArray data;
+    ssize_t nRead = 0;
+    while((nRead = ::read(m_nMasterFd, buf, sizeof(buf))) > 0)
+    {
+        data.append(buf, static_cast<int>(nRead));
+    }
+    if(data.isEmpty())
+    {
+        return;
+    }
+    qint64 arrivalNs = monotonicNs();
+    m_nBytesReceived += data.size();
+
+    //伪终端瞬间送达，按波特率补上接收这些字节需要的时间
+    //控制器逐条处理指令，后一条等前一条处理完
+    qint64 readyNs = arrivalNs + transferNs(data.size());
+    QVector<ControllerReply> replies;
+    m_model.feed(data, replies);
+    for(int i = 0; i < replies.size(); ++i)
+    {
+        const ControllerReply& reply = replies.at(i);
+        if(reply.bValid)
+        {
+            readyNs += qint64(m_options.latencyUs[reply.cmd]) * 1000;
+        }
+        if(m_options.bVerbose)
+        {
+            qDebug() << (reply.bValid ? CommandEncoder::spec(reply.cmd).name : "INVALID")
+                     << "reply in" << (readyNs - arrivalNs) / 1000 << "us:" << reply.data.trimmed();
+        }
+        schedule(readyNs, reply.data);
+    }
+    armTimer();
+}
+
+void PtySimulator::onWriteTimeout()
+{
+    while(!m_pending.isEmpty())
+    {
+        qint64 nowNs = monotonicNs();
+        const PendingChunk& chunk = m_pending.head();
+        if(chunk.dueNs > nowNs + SPIN_WINDOW_NS)
+        {
+            break;
+        }
+        if(chunk.dueNs > nowNs)
+        {
+            struct timespec due;
+            due.tv_sec = static_cast<time_t>(chunk.dueNs / 1000000000);
+            due.tv_nsec = static_cast<long>(chunk.dueNs % 1000000000);
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, nullptr);
+        }
+
+        ssize_t nWritten = ::write(m_nMasterFd, chunk.data.constData(), chunk.data.size());
+        if(nWritten < 0)
+        {
+            //上位机没在读，缓冲区满了，稍后再写
+            if(errno == EAGAIN)
+            {
+                m_writeTimer->start(1);
+            }
+            return;
+        }
+        m_nBytesSent += nWritten;
+        if(nWritten < chunk.data.size())
+        {
+            m_pending.head().data.remove(0, static_cast<int>(nWritten));
+            continue;
+        }
+        m_pending.dequeue();
+    }
+    armTimer();
+}
+
+qint64 PtySimulator::transferNs(int bytes) const
+{
+    if(m_options.baudRate <= 0)
+    {
+        return 0;
+    }
+    //1位起始位、8位数据位、1位停止位
+    return qint64(bytes) * 10 * 1000000000 / m_options.baudRate;
+}
+
+void PtySimulator::schedule(qint64 readyNs, const QByteArray &reply)
+{
+    int nFragment = (m_options.fragmentSize > 0) ? m_options.fragmentSize : reply.size();
+    for(int nOffset = 0; nOffset < reply.size(); nOffset += nFragment)
+    {
+        PendingChunk chunk;
+        chunk.data = reply.mid(nOffset, nFragment);
+        //分片在线路上传完才写出，线路忙时排在前一个分片后面
+        qint64 startNs = qMax(readyNs, m_nLineFreeNs);
+        chunk.dueNs = startNs + transferNs(chunk.data.size());
+        m_nLineFreeNs = chunk.dueNs;
+        if(nOffset + nFragment < reply.size())
+        {
+            m_nLineFreeNs += qint64(m_options.fragmentGapUs) * 1000;
+        }
+        m_pending.enqueue(chunk);
+    }
+}
+
+void PtySimulator::armTimer()
+{
+    if(m_pending.isEmpty() || m_writeTimer->isActive())
+    {
+        return;
+    }
+    qint64 waitNs = m_pending.head().dueNs - monotonicNs() - SPIN_WINDOW_NS;
+    m_writeTimer->start(static_cast<int>(qMax<qint64>(0, waitNs / 1000000)));
+}
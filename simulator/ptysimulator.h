@@ -0,0 +1,86 @@
+#ifndef PTYSIMULATOR_H
+#define PTYSIMULATOR_H
+
+#include <QObject>
+#include <QQueue>
+#include <QString>
+#include <QTimer>
+#include "controllermodel.h"
+
+class QSocketNotifier;
+
+struct SimulatorOptions
+{
+    PROTOCOL_TYPE protocol = PROTOCOL_ASCII;
+    int baudRate = 115200;          //按每字节10位计算传输时间，0为不限速
+    int latencyUs[SETKD + 1];       //各指令的处理时间，微秒
+    int fragmentSize = 0;           //应答拆成的最大分片，0为不拆
+    int fragmentGapUs = 0;          //分片之间的额外间隔，微秒
+    bool bVerbose = false;
+
+    SimulatorOptions()
+    {
+        for(int i = 0; i <= SETKD; ++i)
+        {
+            latencyUs[i] = 500;
+        }
+    }
+};
+
+// 在伪终端上模拟Dummy控制器：上位机打开从端，和真机一样收发
+// 应答按指令处理时间、波特率和分片规则延后写出，用于无机械臂时测试和测量链路
+class PtySimulator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PtySimulator(const SimulatorOptions& options, QObject *parent = nullptr);
+    ~PtySimulator();
+
+    //创建伪终端，linkPath不为空时再建一个指向从端的符号链接
+    bool open(const QString& linkPath = QString());
+    void close();
+
+    //上位机应打开的设备名
+    QString slaveName() const { return m_strSlaveName; }
+
+    int commandCount() const { return m_model.commandCount(); }
+    qint64 bytesReceived() const { return m_nBytesReceived; }
+    qint64 bytesSent() const { return m_nBytesSent; }
+
+    //指令名（STOP、GETJPOS...）对应的类型，找不到返回false
+    static bool commandFromName(const QString& name, CMD_TYPE& cmd);
+
+private slots:
+    void onReadyRead();
+    void onWriteTimeout();
+
+private:
+    //一个待写出的分片，到时间后写入主端
+    struct PendingChunk
+    {
+        qint64 dueNs;
+        QByteArray data;
+    };
+
+    //字节数在当前波特率下的传输时间
+    qint64 transferNs(int bytes) const;
+    void schedule(qint64 readyNs, const QByteArray& reply);
+    void armTimer();
+
+private:
+    SimulatorOptions m_options;
+    ControllerModel m_model;
+    int m_nMasterFd = -1;
+    //自己保持一个从端打开，上位机关闭串口时主端不会读到EIO
+    int m_nSlaveFd = -1;
+    QString m_strSlaveName;
+    QString m_strLinkPath;
+    QSocketNotifier* m_notifier = nullptr;
+    QTimer* m_writeTimer;
+    QQueue<PendingChunk> m_pending;
+    qint64 m_nLineFreeNs = 0;   //发送方向的线路空闲时刻
+    qint64 m_nBytesReceived = 0;
+    qint64 m_nBytesSent = 0;
+};
+
+#endif // PTYSIMULATOR_H
@@ -0,0 +1,28 @@
+QT       -= gui
+QT       += core
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = dummy_simulator
+
+# 用POSIX伪终端模拟控制器的串口，只支持unix
+!unix {
+    error("dummy_simulator requires POSIX pseudo terminals (posix_openpt)")
+}
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    main.cpp \
+    ptysimulator.cpp \
+    ../binaryprotocol.cpp \
+    ../commandencoder.cpp \
+    ../controllermodel.cpp
+
+HEADERS += \
+    ptysimulator.h \
+    ../binaryprotocol.h \
+    ../commanddefs.h \
+    ../commandencoder.h \
+    ../controllermodel.h
@@ -0,0 +1,354 @@
+#include "trajectoryfile.h"
+#include "commandencoder.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QThread>
+#include <QDebug>
+#include <cstring>
+
+TrajectoryWriter::TrajectoryWriter()
+{
+    std::memset(&m_header, 0, sizeof(m_header));
+}
+
+TrajectoryWriter::~TrajectoryWriter()
+{
+    close();
+}
+
+bool TrajectoryWriter::open(const QString &filePath, quint32 flags)
+{
+    close();
+    m_file.setFileName(filePath);
+    if(!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qDebug() << "Failed to open trajectory file:" << filePath;
+        return false;
+    }
+
+    std::memset(&m_header, 0, sizeof(m_header));
+    std::memcpy(m_header.magic, TRAJECTORY_MAGIC, 4);
+    m_header.version = TRAJECTORY_VERSION;
+    m_header.recordSize = sizeof(TrajectoryRecord);
+    m_header.indexStride = INDEX_STRIDE;
+    m_header.flags = flags;
+    m_index.clear();
+
+    //先写入文件头占位，记录数和索引位置在close时回填
+    //异常退出时indexOffset为0，读取端按文件长度恢复记录数
+    m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    return true;
+}
+
+bool TrajectoryWriter::append(const TrajectoryRecord &record)
+{
+    if(!m_file.isOpen())
+    {
+        return false;
+    }
+
+    if(m_header.recordCount % INDEX_STRIDE == 0)
+    {
+        TrajectoryIndexEntry entry;
+        entry.timestampMs = record.timestampMs;
+        entry.recordIndex = m_header.recordCount;
+        m_index.append(entry);
+    }
+
+    if(m_file.write(reinterpret_cast<const char*>(&record), sizeof(record)) != sizeof(record))
+    {
+        return false;
+    }
+    ++m_header.recordCount;
+    return true;
+}
+
+bool TrajectoryWriter::close()
+{
+    if(!m_file.isOpen())
+    {
+        return false;
+    }
+
+    m_header.indexOffset = static_cast<quint64>(m_file.pos());
+    m_header.indexCount = static_cast<quint32>(m_index.size());
+    qint64 nIndexSize = m_index.size() * static_cast<qint64>(sizeof(TrajectoryIndexEntry));
+    bool bOk = m_file.write(reinterpret_cast<const char*>(m_index.constData()), nIndexSize) == nIndexSize;
+    bOk = bOk && m_file.seek(0);
+    bOk = bOk && m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header)) == qint64(sizeof(m_header));
+    //磁盘满时缓冲区的数据在flush时才写失败
+    bOk = m_file.flush() && bOk;
+    m_file.close();
+    m_index.clear();
+    return bOk;
+}
+
+TrajectoryReader::TrajectoryReader()
+{
+    std::memset(&m_header, 0, sizeof(m_header));
+}
+
+TrajectoryReader::~TrajectoryReader()
+{
+    close();
+}
+
+bool TrajectoryReader::open(const QString &filePath)
+{
+    close();
+    m_file.setFileName(filePath);
+    if(!m_file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Failed to open trajectory file:" << filePath;
+        return false;
+    }
+
+    qint64 nFileSize = m_file.size();
+    if(nFileSize < static_cast<qint64>(sizeof(TrajectoryHeader)))
+    {
+        m_file.close();
+        return false;
+    }
+
+    m_pMap = m_file.map(0, nFileSize);
+    if(!m_pMap)
+    {
+        m_file.close();
+        return false;
+    }
+
+    std::memcpy(&m_header, m_pMap, sizeof(m_header));
+    if(std::memcmp(m_header.magic, TRAJECTORY_MAGIC, 4) != 0
+            || m_header.version != TRAJECTORY_VERSION
+            || m_header.recordSize != sizeof(TrajectoryRecord))
+    {
+        qDebug() << "Invalid trajectory file:" << filePath;
+        close();
+        return false;
+    }
+
+    qint64 nRecordBytes = nFileSize - static_cast<qint64>(sizeof(TrajectoryHeader));
+    if(m_header.indexOffset == 0)
+    {
+        //写入未正常结束，按文件长度恢复
+        m_nCount = static_cast<int>(nRecordBytes / sizeof(TrajectoryRecord));
+        m_nIndexCount = 0;
+    }else{
+        qint64 nRecordsEnd = sizeof(TrajectoryHeader) + qint64(m_header.recordCount) * sizeof(TrajectoryRecord);
+        qint64 nIndexEnd = qint64(m_header.indexOffset) + qint64(m_header.indexCount) * sizeof(TrajectoryIndexEntry);
+        if(nRecordsEnd > qint64(m_header.indexOffset) || nIndexEnd > nFileSize)
+        {
+            qDebug() << "Corrupted trajectory file:" << filePath;
+            close();
+            return false;
+        }
+        m_nCount = static_cast<int>(m_header.recordCount);
+        m_nIndexCount = static_cast<int>(m_header.indexCount);
+        m_pIndex = reinterpret_cast<const TrajectoryIndexEntry*>(m_pMap + m_header.indexOffset);
+    }
+    m_pRecords = reinterpret_cast<const TrajectoryRecord*>(m_pMap + sizeof(TrajectoryHeader));
+    return true;
+}
+
+void TrajectoryReader::close()
+{
+    if(m_pMap)
+    {
+        m_file.unmap(m_pMap);
+        m_pMap = nullptr;
+    }
+    if(m_file.isOpen())
+    {
+        m_file.close();
+    }
+    m_pRecords = nullptr;
+    m_pIndex = nullptr;
+    m_nCount = 0;
+    m_nIndexCount = 0;
+}
+
+int TrajectoryReader::indexOfTime(quint32 timestampMs) const
+{
+    //先在索引中找到所在的区间，再在区间内顺序查找
+    int nStart = 0;
+    int nLow = 0;
+    int nHigh = m_nIndexCount - 1;
+    while(nLow <= nHigh)
+    {
+        int nMid = (nLow + nHigh) / 2;
+        if(m_pIndex[nMid].timestampMs <= timestampMs)
+        {
+            nStart = static_cast<int>(m_pIndex[nMid].recordIndex);
+            nLow = nMid + 1;
+        }else{
+            nHigh = nMid - 1;
+        }
+    }
+
+    for(int i = nStart; i < m_nCount; ++i)
+    {
+        if(m_pRecords[i].timestampMs >= timestampMs)
+        {
+            return i;
+        }
+    }
+    return m_nCount;
+}
+
+bool TrajectoryFile::parseTextLine(const char *line, TrajectoryRecord &record)
+{
+    if(CommandEncoder::parseValues(line, record.pose, 6) != 6)
+    {
+        return false;
+    }
+    record.timestampMs = 0;
+    record.speed = 0;
+    record.flags = 0;
+    return true;
+}
+
+bool TrajectoryFile::convertFromText(const QString &textPath, const QString &trajectoryPath)
+{
+    QFile textFile(textPath);
+    if(!textFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        qDebug() << "Failed to open text record:" << textPath;
+        return false;
+    }
+
+    //先写临时文件，转换完成后再发布，避免留下不完整的缓存
+    QString tempPath = tempPathFor(trajectoryPath);
+    TrajectoryWriter writer;
+    if(!writer.open(tempPath, TRAJECTORY_FLAG_UNTIMED))
+    {
+        return false;
+    }
+
+    char line[256];
+    TrajectoryRecord record;
+    while(textFile.readLine(line, sizeof(line)) > 0)
+    {
+        if(!parseTextLine(line, record))
+        {
+            continue;
+        }
+        if(writer.count() == 0)
+        {
+            record.flags |= RECORD_FLAG_SEGMENT_START;
+        }
+        if(!writer.append(record))
+        {
+            writer.close();
+            QFile::remove(tempPath);
+            qDebug() << "Failed to write trajectory file:" << tempPath;
+            return false;
+        }
+    }
+    writer.close();
+    textFile.close();
+
+    return publishCache(tempPath, trajectoryPath);
+}
+
+QString TrajectoryFile::cachePathFor(const QString &textPath)
+{
+    QFileInfo info(textPath);
+    QDir cacheDir(info.absolutePath() + "/.cache");
+    if(!cacheDir.exists())
+    {
+        cacheDir.mkpath(".");
+    }
+    QString strVersion = QString("%1_%2").arg(info.lastModified().toMSecsSinceEpoch()).arg(info.size());
+    return cacheDir.filePath(info.completeBaseName() + "." + strVersion + "." + TRAJECTORY_SUFFIX);
+}
+
+//fileName是否为baseName某个版本的缓存：<baseName>.<版本>.trj，版本中没有'.'
+static bool isCacheOf(const QString& fileName, const QString& baseName)
+{
+    QString strSuffix = QString(".") + TRAJECTORY_SUFFIX;
+    if(!fileName.startsWith(baseName + ".") || !fileName.endsWith(strSuffix))
+    {
+        return false;
+    }
+    int nVersionSize = fileName.size() - baseName.size() - 1 - strSuffix.size();
+    return nVersionSize > 0 && !fileName.mid(baseName.size() + 1, nVersionSize).contains('.');
+}
+
+bool TrajectoryFile::publishCache(const QString &tempPath, const QString &cachePath)
+{
+    //同一版本的内容相同，另一个线程先写完就直接用它的
+    if(!QFile::exists(cachePath) && !QFile::rename(tempPath, cachePath))
+    {
+        QFile::remove(tempPath);
+        qDebug() << "Failed to publish trajectory cache:" << cachePath;
+        return false;
+    }
+    QFile::remove(tempPath);
+
+    //旧版本仍被映射时删除会失败，留到下次
+    QFileInfo cacheInfo(cachePath);
+    QString baseName = cacheInfo.fileName().section('.', 0, -3);
+    QDir cacheDir = cacheInfo.absoluteDir();
+    const QStringList names = cacheDir.entryList(QDir::Files);
+    for(int i = 0; i < names.size(); ++i)
+    {
+        if(names.at(i) != cacheInfo.fileName() && isCacheOf(names.at(i), baseName))
+        {
+            QFile::remove(cacheDir.filePath(names.at(i)));
+        }
+    }
+    return true;
+}
+
+void TrajectoryFile::removeCaches(const QString &textPath)
+{
+    QFileInfo info(textPath);
+    QDir cacheDir(info.absolutePath() + "/.cache");
+    const QStringList names = cacheDir.entryList(QDir::Files);
+    for(int i = 0; i < names.size(); ++i)
+    {
+        if(isCacheOf(names.at(i), info.completeBaseName()))
+        {
+            QFile::remove(cacheDir.filePath(names.at(i)));
+        }
+    }
+}
+
+QString TrajectoryFile::tempPathFor(const QString &targetPath)
+{
+    return QString("%1.%2.tmp").arg(targetPath)
+            .arg(static_cast<qulonglong>(reinterpret_cast<quintptr>(QThread::currentThreadId())), 0, 16);
+}
+
+bool TrajectoryFile::replaceFile(const QString &tempPath, const QString &targetPath)
+{
+    if(!QFile::exists(targetPath))
+    {
+        if(QFile::rename(tempPath, targetPath))
+        {
+            return true;
+        }
+        QFile::remove(tempPath);
+        return false;
+    }
+
+    QString backupPath = targetPath + ".bak";
+    QFile::remove(backupPath);
+    if(!QFile::rename(targetPath, backupPath))
+    {
+        //原文件还被占用，保持不变
+        QFile::remove(tempPath);
+        qDebug() << "Trajectory file in use, not replaced:" << targetPath;
+        return false;
+    }
+    if(!QFile::rename(tempPath, targetPath))
+    {
+        QFile::rename(backupPath, targetPath);
+        QFile::remove(tempPath);
+        qDebug() << "Failed to replace trajectory file:" << targetPath;
+        return false;
+    }
+    QFile::remove(backupPath);
+    return true;
+}
@@ -0,0 +1,132 @@
+#ifndef TRAJECTORYFILE_H
+#define TRAJECTORYFILE_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+/*
+ * 二进制轨迹文件(.trj)，小端：
+ *   TrajectoryHeader  64字节
+ *   TrajectoryRecord  32字节 x recordCount，第i条位于 sizeof(header) + i * recordSize
+ *   TrajectoryIndexEntry x indexCount，每indexStride条记录一项，用于按时间定位
+ * 记录定长，按序号定位不需要解析前面的数据，文件可以直接内存映射
+ */
+
+#define TRAJECTORY_MAGIC "DTRJ"
+#define TRAJECTORY_VERSION 1
+#define TRAJECTORY_SUFFIX "trj"
+
+//文件标志
+#define TRAJECTORY_FLAG_UNTIMED 0x0001  //时间戳无效（由旧文本记录转换而来）
+
+//记录标志
+#define RECORD_FLAG_SEGMENT_START 0x0001 //新的一段轨迹的起点
+
+struct TrajectoryHeader
+{
+    char magic[4];
+    quint16 version;
+    quint16 recordSize;
+    quint32 recordCount;
+    quint32 indexStride;
+    quint32 indexCount;
+    quint32 flags;
+    quint64 indexOffset;
+    quint8 reserved[32];
+};
+static_assert(sizeof(TrajectoryHeader) == 64, "TrajectoryHeader layout");
+
+struct TrajectoryRecord
+{
+    float pose[6];          //x y z a b c
+    quint32 timestampMs;    //相对第一条记录的时间
+    quint16 speed;          //0表示使用回放时的速度
+    quint16 flags;
+};
+static_assert(sizeof(TrajectoryRecord) == 32, "TrajectoryRecord layout");
+
+struct TrajectoryIndexEntry
+{
+    quint32 timestampMs;
+    quint32 recordIndex;
+};
+static_assert(sizeof(TrajectoryIndexEntry) == 8, "TrajectoryIndexEntry layout");
+
+// 顺序写入轨迹文件，close时写入索引并回填文件头
+class TrajectoryWriter
+{
+public:
+    TrajectoryWriter();
+    ~TrajectoryWriter();
+
+    bool open(const QString& filePath, quint32 flags = 0);
+    bool isOpen() const { return m_file.isOpen(); }
+    bool append(const TrajectoryRecord& record);
+    //写入索引和文件头，任何一步写入失败返回false
+    bool close();
+
+    int count() const { return static_cast<int>(m_header.recordCount); }
+    QString fileName() const { return m_file.fileName(); }
+
+private:
+    static const quint32 INDEX_STRIDE = 256;
+
+    QFile m_file;
+    TrajectoryHeader m_header;
+    QVector<TrajectoryIndexEntry> m_index;
+};
+
+// 内存映射读取轨迹文件，按序号O(1)定位
+class TrajectoryReader
+{
+public:
+    TrajectoryReader();
+    ~TrajectoryReader();
+
+    bool open(const QString& filePath);
+    void close();
+    bool isOpen() const { return m_pMap != nullptr; }
+
+    int count() const { return m_nCount; }
+    bool isTimed() const { return !(m_header.flags & TRAJECTORY_FLAG_UNTIMED); }
+    const TrajectoryRecord& record(int index) const { return m_pRecords[index]; }
+
+    //第一条时间戳不小于timestampMs的记录序号
+    int indexOfTime(quint32 timestampMs) const;
+
+private:
+    QFile m_file;
+    uchar* m_pMap = nullptr;
+    TrajectoryHeader m_header;
+    const TrajectoryRecord* m_pRecords = nullptr;
+    const TrajectoryIndexEntry* m_pIndex = nullptr;
+    int m_nCount = 0;
+    int m_nIndexCount = 0;
+};
+
+class TrajectoryFile
+{
+public:
+    //解析一行旧文本记录 " x y z a b c"
+    static bool parseTextLine(const char* line, TrajectoryRecord& record);
+
+    //把旧的文本记录转换为二进制轨迹文件
+    static bool convertFromText(const QString& textPath, const QString& trajectoryPath);
+
+    //文本记录对应的二进制缓存路径：TeachRecords/.cache/<name>.<修改时间>_<大小>.trj
+    //文本修改后缓存换一个名字，旧缓存可能还被其他读取者映射，不在原位置覆盖
+    static QString cachePathFor(const QString& textPath);
+    //把写好的临时文件发布为缓存：同一版本的缓存已存在时丢弃临时文件，之后尽量删除旧版本的缓存
+    static bool publishCache(const QString& tempPath, const QString& cachePath);
+    //删除文本记录的所有版本的缓存
+    static void removeCaches(const QString& textPath);
+
+    //写入target的临时文件路径，各线程不同，同时转换同一个文件也不会互相覆盖
+    static QString tempPathFor(const QString& targetPath);
+    //用写完的临时文件替换targetPath：先把原文件改名备份，替换成功后再删除备份
+    //原文件被占用（Windows上被映射时不能改名）或替换失败时保留原文件并删除临时文件，返回false
+    static bool replaceFile(const QString& tempPath, const QString& targetPath);
+};
+
+#endif // TRAJECTORYFILE_H
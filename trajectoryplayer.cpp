@@ -0,0 +1,159 @@
+#include "trajectoryplayer.h"
+#include "serialsender.h"
+#include "motionscheduler.h"
+#include "playbacksource.h"
+#include "commandencoder.h"
+#include "asynclogger.h"
+#include <QTimer>
+#include <QDebug>
+
+TrajectoryPlayer::TrajectoryPlayer(SerialSender *sender, MotionScheduler *scheduler, QObject *parent)
+    : QObject(parent)
+    , m_sender(sender)
+    , m_scheduler(scheduler)
+{
+    m_playback = new PlaybackSource(this);
+
+    m_runTimer = new QTimer(this);
+    m_runTimer->setInterval(PLAY_PERIOD_MS);
+    connect(m_runTimer, &QTimer::timeout, this, &TrajectoryPlayer::onPlayRecord);
+    connect(m_scheduler, &MotionScheduler::signalPlaybackFinished, this, &TrajectoryPlayer::onSchedulerFinished);
+    connect(m_sender, &SerialSender::signalFrameReceived, this, &TrajectoryPlayer::onFrameReceived);
+}
+
+bool TrajectoryPlayer::start(const QString &filePath, int fromIndex, int window, float speed)
+{
+    stop();
+
+    //后台预读，不等整个文件读完
+    if(!m_playback->open(filePath, fromIndex))
+    {
+        qDebug() << "Failed to open playback file:" << filePath;
+        return false;
+    }
+    m_nPlayIndex = fromIndex;
+    setSpeed(speed);
+    m_bPlaying = true;
+    m_creditWindow.setWindow(window);
+
+    if(m_creditWindow.isEnabled())
+    {
+        m_runTimer->start();
+        //第一条不等定时器，预读线程解析出来就立即发送
+        fillCreditWindow(PlaybackSource::FIRST_RECORD_WAIT_MS);
+    }else{
+        //定时回放交给调度线程
+        if(!m_scheduler->startPlayback(m_playback, m_sender->protocol(),
+                                       static_cast<int>(PLAY_PERIOD_MS * (100 / m_fSpeed)), m_fSpeed))
+        {
+            m_playback->stop();
+            m_bPlaying = false;
+            return false;
+        }
+    }
+    return true;
+}
+
+void TrajectoryPlayer::stop()
+{
+    m_runTimer->stop();
+    //调度线程发出的记录数计入回放进度
+    m_nPlayIndex += m_scheduler->stopPlayback();
+    m_playback->stop();
+    m_creditWindow.reset();
+    //没发出的记录不计入进度，继续回放时从它开始
+    m_bHasPending = false;
+    m_bPlaying = false;
+}
+
+void TrajectoryPlayer::setSpeed(float speed)
+{
+    m_fSpeed = qMax(static_cast<float>(MIN_SPEED), speed);
+}
+
+void TrajectoryPlayer::onFrameReceived(const ResponseFrame &frame)
+{
+    //只有配对到MOVEL的应答才归还额度，出错也归还；点动、界面和网络指令的应答不算
+    if((frame.type == FRAME_OK || frame.type == FRAME_ERROR) && frame.command == MOVEL
+            && m_runTimer->isActive() && m_creditWindow.onAck())
+    {
+        fillCreditWindow(0);
+        checkPlaybackEnd();
+    }
+}
+
+void TrajectoryPlayer::onPlayRecord()
+{
+    //流控模式下定时器只负责补发（含通道满时被拒收的记录）和超时检查，主要由应答驱动
+    int nLost = m_creditWindow.expire(ACK_TIMEOUT_MS);
+    if(nLost > 0)
+    {
+        AsyncLogger::log(LOG_WARN, "playback ack timeout, lost %1", nLost);
+    }
+    fillCreditWindow(0);
+    checkPlaybackEnd();
+}
+
+void TrajectoryPlayer::onSchedulerFinished()
+{
+    if(m_bPlaying)
+    {
+        finish();
+    }
+}
+
+bool TrajectoryPlayer::playNextRecord(int waitMs)
+{
+    if(!m_bHasPending)
+    {
+        //预读跟不上时跳过这一拍
+        if(!m_playback->take(m_pendingRecord, waitMs))
+        {
+            return false;
+        }
+        m_bHasPending = true;
+    }
+
+    const TrajectoryRecord& record = m_pendingRecord;
+    float values[MAX_CMD_VALUES];
+    for(int i = 0; i < 6; ++i)
+    {
+        values[i] = record.pose[i];
+    }
+    values[6] = record.speed ? record.speed : m_fSpeed;
+
+    char buf[CommandEncoder::MAX_CMD_SIZE];
+    int nSize = CommandEncoder::encode(m_sender->protocol(), MOVEL, values, 7, buf, sizeof(buf));
+    //通道满或串口积压时保留这条记录，不占额度，等通道排空后由定时器或下一个应答重发
+    if(nSize <= 0 || !m_sender->sendDatas(buf, nSize))
+    {
+        return false;
+    }
+    m_bHasPending = false;
+    m_nPlayIndex++;
+    return true;
+}
+
+void TrajectoryPlayer::fillCreditWindow(int waitMs)
+{
+    while(m_creditWindow.canSend() && playNextRecord(waitMs))
+    {
+        m_creditWindow.onSent();
+        waitMs = 0;
+    }
+}
+
+void TrajectoryPlayer::checkPlaybackEnd()
+{
+    //文件读完、没有待重发的记录且发出的指令都已应答才结束
+    if(m_playback->atEnd() && !m_bHasPending && m_creditWindow.outstanding() == 0)
+    {
+        finish();
+    }
+}
+
+void TrajectoryPlayer::finish()
+{
+    stop();
+    emit signalFinished();
+}
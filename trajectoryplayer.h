@@ -0,0 +1,76 @@
+#ifndef TRAJECTORYPLAYER_H
+#define TRAJECTORYPLAYER_H
+
+#include <QObject>
+#include <QString>
+#include "creditwindow.h"
+#include "responseframer.h"
+#include "trajectoryfile.h"
+
+class QTimer;
+class SerialSender;
+class MotionScheduler;
+class PlaybackSource;
+
+// 轨迹回放：后台预读记录文件，按两种方式发送MOVEL
+// 定时回放交给MotionScheduler按固定周期或记录的时间戳发送；
+// 流控回放最多允许window条指令未应答，收到应答再补发，由所在线程的事件循环驱动
+// 界面和守护进程共用，只能在创建它的线程中使用
+class TrajectoryPlayer : public QObject
+{
+    Q_OBJECT
+public:
+    //定时回放速度为100时的发送周期，也是流控回放超时检查的周期
+    static const int PLAY_PERIOD_MS = 20;
+    static const int ACK_TIMEOUT_MS = 1000;
+    //定时回放的周期和速度成反比，速度不能为0
+    static const int MIN_SPEED = 1;
+
+    explicit TrajectoryPlayer(SerialSender* sender, MotionScheduler* scheduler, QObject *parent = nullptr);
+
+    //从第fromIndex条记录开始回放，window为0时定时回放，speed用于未记录速度的点
+    //speed小于MIN_SPEED时按MIN_SPEED回放
+    bool start(const QString& filePath, int fromIndex, int window, float speed);
+    void stop();
+    bool isPlaying() const { return m_bPlaying; }
+
+    //流控回放中修改速度，之后发出的记录生效
+    void setSpeed(float speed);
+    //下一条要回放的记录序号，stop之后可以从这里继续
+    int playIndex() const { return m_nPlayIndex; }
+    const CreditWindow& creditWindow() const { return m_creditWindow; }
+
+signals:
+    //所有记录都已发出，流控回放还要等到全部应答
+    void signalFinished();
+
+private slots:
+    void onFrameReceived(const ResponseFrame& frame);
+    //流控回放的补发和超时检查
+    void onPlayRecord();
+    void onSchedulerFinished();
+
+private:
+    //发送下一条回放记录，没有可用记录或发送通道拒收时返回false
+    //被拒收的记录留在m_pendingRecord，序号不前进，下次补发时重试
+    bool playNextRecord(int waitMs);
+    //按剩余额度连续发送
+    void fillCreditWindow(int waitMs);
+    void checkPlaybackEnd();
+    void finish();
+
+private:
+    SerialSender* m_sender;
+    MotionScheduler* m_scheduler;
+    PlaybackSource* m_playback;
+    QTimer* m_runTimer;
+    CreditWindow m_creditWindow;
+    bool m_bPlaying = false;
+    int m_nPlayIndex = 0;
+    //已从预读取出、还没能发出的记录
+    TrajectoryRecord m_pendingRecord;
+    bool m_bHasPending = false;
+    float m_fSpeed = 100;
+};
+
+#endif // TRAJECTORYPLAYER_H
@@ -0,0 +1,72 @@
+#include "trajectoryrecorder.h"
+#include "serialsender.h"
+#include "commandencoder.h"
+#include "replyparser.h"
+#include <QDebug>
+
+TrajectoryRecorder::TrajectoryRecorder(SerialSender *sender, QObject *parent)
+    : QObject(parent)
+    , m_sender(sender)
+{
+    connect(m_sender, &SerialSender::signalFrameReceived, this, &TrajectoryRecorder::onFrameReceived);
+}
+
+bool TrajectoryRecorder::start(const QString &filePath, int intervalMs)
+{
+    if(m_bRecording)
+    {
+        stop();
+    }
+    if(!m_writer.open(filePath))
+    {
+        qDebug() << "Failed to open record file:" << filePath;
+        return false;
+    }
+
+    //由串口线程按应答轮询位姿
+    char buf[CommandEncoder::MAX_CMD_SIZE];
+    int nSize = CommandEncoder::encode(m_sender->protocol(), GETLPOS, nullptr, 0, buf, sizeof(buf));
+    m_sender->startPolling(QByteArray(buf, nSize), intervalMs);
+    m_bRecording = true;
+    return true;
+}
+
+int TrajectoryRecorder::stop()
+{
+    if(!m_bRecording)
+    {
+        return 0;
+    }
+    m_sender->stopPolling();
+    m_bRecording = false;
+    int nCount = m_writer.count();
+    m_writer.close();
+    return nCount;
+}
+
+void TrajectoryRecorder::onFrameReceived(const ResponseFrame &frame)
+{
+    //关节角应答不是位姿
+    if(!m_bRecording || frame.type != FRAME_POSITION || frame.command == GETJPOS)
+    {
+        return;
+    }
+
+    //直接解析接收缓冲区中的数值，不复制
+    TrajectoryRecord record;
+    if(!ReplyParser::parsePose(frame.payload(), frame.payloadSize(), record.pose))
+    {
+        return;
+    }
+    record.speed = 0;
+    record.flags = 0;
+
+    //时间戳取自串口线程收到应答的时刻，不受界面线程延迟影响
+    if(m_writer.count() == 0)
+    {
+        m_nStartNs = frame.timestampNs;
+        record.flags |= RECORD_FLAG_SEGMENT_START;
+    }
+    record.timestampMs = static_cast<quint32>((frame.timestampNs - m_nStartNs) / 1000000);
+    m_writer.append(record);
+}
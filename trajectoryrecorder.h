@@ -0,0 +1,38 @@
+#ifndef TRAJECTORYRECORDER_H
+#define TRAJECTORYRECORDER_H
+
+#include <QObject>
+#include <QString>
+#include "trajectoryfile.h"
+#include "responseframer.h"
+
+class SerialSender;
+
+// 拖动示教采样：串口线程按应答轮询GETLPOS，收到的位姿带接收时刻写入.trj
+// 界面和守护进程共用，只能在创建它的线程中使用
+class TrajectoryRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TrajectoryRecorder(SerialSender* sender, QObject *parent = nullptr);
+
+    //打开filePath并开始轮询，intervalMs为收到应答后到下一次请求的间隔
+    bool start(const QString& filePath, int intervalMs);
+    //停止轮询并关闭文件，返回写入的记录数
+    int stop();
+
+    bool isRecording() const { return m_bRecording; }
+    int count() const { return m_writer.count(); }
+    QString fileName() const { return m_writer.fileName(); }
+
+private slots:
+    void onFrameReceived(const ResponseFrame& frame);
+
+private:
+    SerialSender* m_sender;
+    TrajectoryWriter m_writer;
+    bool m_bRecording = false;
+    qint64 m_nStartNs = 0;
+};
+
+#endif // TRAJECTORYRECORDER_H
@@ -0,0 +1,214 @@
+#include "trajectorysimplifier.h"
+#include <QFile>
+#include <QPair>
+#include <QDebug>
+#include <cmath>
+
+void TrajectorySimplifier::difference(const TrajectoryRecord &a, const TrajectoryRecord &b,
+                                      const float *scale, double *diff)
+{
+    for(int i = 0; i < 6; ++i)
+    {
+        double d = double(b.pose[i]) - a.pose[i];
+        if(i >= 3)
+        {
+            //-180和180是同一个姿态
+            d = std::remainder(d, 360.0);
+        }
+        diff[i] = d * scale[i];
+    }
+}
+
+double TrajectorySimplifier::segmentDistance(const TrajectoryRecord &a, const TrajectoryRecord &b,
+                                             const TrajectoryRecord &p, const float *scale)
+{
+    double v[6];
+    double w[6];
+    difference(a, b, scale, v);
+    difference(a, p, scale, w);
+
+    double vv = 0;
+    double wv = 0;
+    for(int i = 0; i < 6; ++i)
+    {
+        vv += v[i] * v[i];
+        wv += w[i] * v[i];
+    }
+    double t = (vv > 0) ? wv / vv : 0;
+    if(t < 0)
+    {
+        t = 0;
+    }else if(t > 1)
+    {
+        t = 1;
+    }
+
+    double dist2 = 0;
+    for(int i = 0; i < 6; ++i)
+    {
+        double e = w[i] - t * v[i];
+        dist2 += e * e;
+    }
+    return std::sqrt(dist2);
+}
+
+QVector<int> TrajectorySimplifier::simplify(const TrajectoryRecord *records, int count,
+                                            const SimplifyOptions &options, SimplifyResult *result)
+{
+    QVector<int> keptList;
+    if(result)
+    {
+        *result = SimplifyResult();
+        result->inputCount = count;
+    }
+    if(count <= 0)
+    {
+        return keptList;
+    }
+
+    //按容差归一化，距离不超过1即在容差内
+    float stationaryScale[6];
+    float toleranceScale[6];
+    for(int i = 0; i < 6; ++i)
+    {
+        bool bPos = i < 3;
+        stationaryScale[i] = 1.0f / (bPos ? options.stationaryPosition : options.stationaryOrientation);
+        toleranceScale[i] = 1.0f / (bPos ? options.positionTolerance : options.orientationTolerance);
+    }
+
+    //1. 去掉静止段中间的点，保留静止段的第一个点和离开前的最后一个点，回放时停留时间不变
+    QVector<int> candidates;
+    QVector<char> forced;
+    candidates.reserve(count);
+    forced.reserve(count);
+    candidates.append(0);
+    forced.append(1);
+    int nLastKept = 0;
+    int nStationary = 0;
+    double diff[6];
+    auto isNear = [&](int a, int b) {
+        difference(records[a], records[b], stationaryScale, diff);
+        for(int i = 0; i < 6; ++i)
+        {
+            if(std::fabs(diff[i]) > 1.0)
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    for(int i = 1; i < count; ++i)
+    {
+        bool bSegStart = records[i].flags & RECORD_FLAG_SEGMENT_START;
+        bool bLast = (i == count - 1);
+        bool bNearKept = !bSegStart && isNear(nLastKept, i);
+        if(bNearKept && !bLast && !(records[i + 1].flags & RECORD_FLAG_SEGMENT_START)
+                && isNear(nLastKept, i + 1))
+        {
+            //停下的点也要保留，否则停留前的一段会被拉直
+            forced.last() = 1;
+            ++nStationary;
+            continue;
+        }
+        candidates.append(i);
+        //静止段的端点和每段起点不参与折线简化
+        forced.append((bSegStart || bLast || bNearKept) ? 1 : 0);
+        nLastKept = i;
+    }
+
+    //2. 在相邻的必保留点之间做RDP，用显式栈避免长录制递归过深
+    int nCandidates = candidates.size();
+    QVector<char> keep = forced;
+    QVector<QPair<int, int> > stack;
+    int nStart = 0;
+    for(int j = 1; j < nCandidates; ++j)
+    {
+        if(keep[j])
+        {
+            stack.append(qMakePair(nStart, j));
+            nStart = j;
+        }
+    }
+    while(!stack.isEmpty())
+    {
+        QPair<int, int> range = stack.takeLast();
+        if(range.second - range.first < 2)
+        {
+            continue;
+        }
+        const TrajectoryRecord& a = records[candidates[range.first]];
+        const TrajectoryRecord& b = records[candidates[range.second]];
+        double maxDist = 0;
+        int nMax = -1;
+        for(int j = range.first + 1; j < range.second; ++j)
+        {
+            double dist = segmentDistance(a, b, records[candidates[j]], toleranceScale);
+            if(dist > maxDist)
+            {
+                maxDist = dist;
+                nMax = j;
+            }
+        }
+        if(maxDist > 1.0)
+        {
+            keep[nMax] = 1;
+            stack.append(qMakePair(range.first, nMax));
+            stack.append(qMakePair(nMax, range.second));
+        }
+    }
+
+    for(int j = 0; j < nCandidates; ++j)
+    {
+        if(keep[j])
+        {
+            keptList.append(candidates[j]);
+        }
+    }
+    if(result)
+    {
+        result->stationaryRemoved = nStationary;
+        result->outputCount = keptList.size();
+    }
+    return keptList;
+}
+
+bool TrajectorySimplifier::simplifyFile(const QString &filePath, const SimplifyOptions &options, SimplifyResult &result)
+{
+    TrajectoryReader reader;
+    if(!reader.open(filePath))
+    {
+        return false;
+    }
+    if(reader.count() == 0)
+    {
+        result = SimplifyResult();
+        return true;
+    }
+
+    QVector<int> keptList = simplify(&reader.record(0), reader.count(), options, &result);
+
+    //先写临时文件再替换
+    QString tempPath = TrajectoryFile::tempPathFor(filePath);
+    TrajectoryWriter writer;
+    if(!writer.open(tempPath, reader.isTimed() ? 0 : TRAJECTORY_FLAG_UNTIMED))
+    {
+        return false;
+    }
+    bool bWritten = true;
+    for(int i = 0; i < keptList.size() && bWritten; ++i)
+    {
+        bWritten = writer.append(reader.record(keptList[i]));
+    }
+    bWritten = writer.close() && bWritten;
+    //映射着的文件在Windows上不能改名，替换前先关闭
+    reader.close();
+    if(!bWritten)
+    {
+        //磁盘满等写入不完整，保留原记录
+        QFile::remove(tempPath);
+        qDebug() << "Failed to write simplified trajectory:" << tempPath;
+        return false;
+    }
+
+    return TrajectoryFile::replaceFile(tempPath, filePath);
+}
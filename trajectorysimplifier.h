@@ -0,0 +1,47 @@
+#ifndef TRAJECTORYSIMPLIFIER_H
+#define TRAJECTORYSIMPLIFIER_H
+
+#include <QString>
+#include <QVector>
+#include "trajectoryfile.h"
+
+// 简化参数，位置单位mm，姿态单位度
+struct SimplifyOptions
+{
+    //简化后的折线与原轨迹的最大偏差
+    float positionTolerance = 0.5f;
+    float orientationTolerance = 0.5f;
+    //变化小于该值视为静止
+    float stationaryPosition = 0.05f;
+    float stationaryOrientation = 0.05f;
+};
+
+struct SimplifyResult
+{
+    int inputCount = 0;
+    int stationaryRemoved = 0;   //去掉的静止点
+    int outputCount = 0;
+};
+
+// 录制轨迹的后处理：去掉静止不动的采样点，再在6维位姿空间做Ramer-Douglas-Peucker折线简化
+// 位置和姿态分别按各自的容差归一化，姿态差按±180度取最短角度
+class TrajectorySimplifier
+{
+public:
+    //返回保留的记录序号（升序），首尾点和每段起点总是保留
+    static QVector<int> simplify(const TrajectoryRecord* records, int count,
+                                 const SimplifyOptions& options, SimplifyResult* result = nullptr);
+
+    //简化.trj文件并替换原文件，临时文件写完整后才替换，失败时原文件保持不变
+    static bool simplifyFile(const QString& filePath, const SimplifyOptions& options, SimplifyResult& result);
+
+private:
+    //归一化后的差值 b - a
+    static void difference(const TrajectoryRecord& a, const TrajectoryRecord& b,
+                           const float* scale, double* diff);
+    //点p到线段ab的归一化距离
+    static double segmentDistance(const TrajectoryRecord& a, const TrajectoryRecord& b,
+                                  const TrajectoryRecord& p, const float* scale);
+};
+
+#endif // TRAJECTORYSIMPLIFIER_H
@@ -0,0 +1,290 @@
+#include "trajectoryvalidator.h"
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QDebug>
+#include <cmath>
+
+//回零位的关节角，没有前一条记录时以它为参考
+static const float REST_JOINTS[6] = {0, -75, 180, 0, 0, 0};
+
+static ArmGeometry unlimitedGeometry(const ArmGeometry& geometry)
+{
+    ArmGeometry unlimited = geometry;
+    for(int i = 0; i < 6; ++i)
+    {
+        unlimited.jointMin[i] = -1e6f;
+        unlimited.jointMax[i] = 1e6f;
+    }
+    return unlimited;
+}
+
+//两组关节角中变化最大的关节
+static int maxJointStep(const float* from, const float* to, float& step)
+{
+    int nJoint = 0;
+    step = 0;
+    for(int i = 0; i < 6; ++i)
+    {
+        float delta = std::fabs(to[i] - from[i]);
+        if(delta > step)
+        {
+            step = delta;
+            nJoint = i;
+        }
+    }
+    return nJoint;
+}
+
+// 线程池里求解一块记录
+class ValidateTask : public QRunnable
+{
+public:
+    ValidateTask(const TrajectoryValidator* validator, const TrajectoryRecord* records,
+                 int begin, int end, const ValidationOptions& options,
+                 float* joints, ValidationResult* result)
+        : m_validator(validator), m_records(records), m_nBegin(begin), m_nEnd(end),
+          m_options(options), m_joints(joints), m_result(result)
+    {
+
+    }
+
+    void run() override
+    {
+        *m_result = m_validator->solveRange(m_records, m_nBegin, m_nEnd, nullptr, m_options, m_joints);
+    }
+
+private:
+    const TrajectoryValidator* m_validator;
+    const TrajectoryRecord* m_records;
+    int m_nBegin;
+    int m_nEnd;
+    ValidationOptions m_options;
+    float* m_joints;
+    ValidationResult* m_result;
+};
+
+TrajectoryValidator::TrajectoryValidator(const Kinematics &kinematics)
+    : m_kinematics(kinematics), m_unlimited(unlimitedGeometry(kinematics.geometry()))
+{
+
+}
+
+ValidationResult TrajectoryValidator::validate(const TrajectoryRecord *records, int count,
+                                               const ValidationOptions &options) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    //每个线程分几块，求解慢的块不会拖住整体
+    int nThreads = qMax(1, QThread::idealThreadCount());
+    int nChunkSize = qMax(MIN_CHUNK_SIZE, (count + nThreads * 4 - 1) / (nThreads * 4));
+    int nChunks = (count + nChunkSize - 1) / nChunkSize;
+
+    QVector<float> joints(6 * count);
+    QVector<ValidationResult> chunkResults(nChunks);
+    QThreadPool pool;
+    for(int n = 0; n < nChunks; ++n)
+    {
+        int nBegin = n * nChunkSize;
+        int nEnd = qMin(count, nBegin + nChunkSize);
+        pool.start(new ValidateTask(this, records, nBegin, nEnd, options,
+                                    joints.data(), &chunkResults[n]));
+    }
+    pool.waitForDone();
+
+    //按顺序拼接：块内从回零位出发，第一条可能选了另一种构型
+    //和上一块的末尾衔接不上或块内出现跳变时，以上一块的末尾为参考顺序重算
+    ValidationResult result;
+    for(int n = 0; n < nChunks; ++n)
+    {
+        int nBegin = n * nChunkSize;
+        int nEnd = qMin(count, nBegin + nChunkSize);
+        ValidationResult chunk = chunkResults.at(n);
+        if(n > 0)
+        {
+            const float* previous = joints.constData() + 6 * (nBegin - 1);
+            float step = 0;
+            bool bFirstSolved = (chunk.error == VALIDATION_OK || chunk.index > nBegin);
+            if(bFirstSolved)
+            {
+                maxJointStep(previous, joints.constData() + 6 * nBegin, step);
+            }
+            if(chunk.error == VALIDATION_JOINT_JUMP
+                    || step > allowedJointStep(records[nBegin - 1], records[nBegin], options))
+            {
+                chunk = solveRange(records, nBegin, nEnd, previous, options, joints.data());
+            }
+        }
+        if(chunk.error != VALIDATION_OK)
+        {
+            result = chunk;
+            break;
+        }
+    }
+
+    result.recordCount = count;
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
+
+ValidationResult TrajectoryValidator::validateFile(const QString &filePath, const ValidationOptions &options) const
+{
+    ValidationResult result;
+    QString trajectoryPath = filePath;
+    QFileInfo fileInfo(filePath);
+    if(fileInfo.suffix() != TRAJECTORY_SUFFIX)
+    {
+        //缓存名带文本的修改时间和大小，不存在就转换出这个版本
+        trajectoryPath = TrajectoryFile::cachePathFor(filePath);
+        if(!QFile::exists(trajectoryPath))
+        {
+            if(!TrajectoryFile::convertFromText(filePath, trajectoryPath))
+            {
+                result.error = VALIDATION_FILE_ERROR;
+                return result;
+            }
+        }
+    }
+
+    TrajectoryReader reader;
+    if(!reader.open(trajectoryPath))
+    {
+        result.error = VALIDATION_FILE_ERROR;
+        return result;
+    }
+    if(reader.count() == 0)
+    {
+        return result;
+    }
+    //映射的记录连续存放，直接交给各线程读
+    return validate(&reader.record(0), reader.count(), options);
+}
+
+QString TrajectoryValidator::describe(const ValidationResult &result)
+{
+    //序号从1开始，和文本记录的行号一致
+    int nLine = result.index + 1;
+    switch(result.error)
+    {
+    case VALIDATION_OK:
+        return QString("%1 records ok, %2 ms").arg(result.recordCount).arg(result.elapsedMs);
+    case VALIDATION_FILE_ERROR:
+        return QString("failed to open trajectory file");
+    case VALIDATION_UNREACHABLE:
+        return QString("record %1: pose out of reach").arg(nLine);
+    case VALIDATION_JOINT_LIMIT:
+        return QString("record %1: joint limit exceeded").arg(nLine);
+    case VALIDATION_JOINT_JUMP:
+        return QString("record %1: joint %2 jumps %3 deg")
+                .arg(nLine).arg(result.joint + 1).arg(result.jointStep, 0, 'f', 1);
+    }
+    return QString();
+}
+
+float TrajectoryValidator::allowedJointStep(const TrajectoryRecord &from, const TrajectoryRecord &to,
+                                            const ValidationOptions &options)
+{
+    float dx = to.pose[0] - from.pose[0];
+    float dy = to.pose[1] - from.pose[1];
+    float dz = to.pose[2] - from.pose[2];
+    float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+    //姿态角按最近的一圈比较，-179和179只差2度
+    float turn = 0;
+    for(int i = 3; i < 6; ++i)
+    {
+        turn = qMax(turn, float(std::fabs(std::remainder(to.pose[i] - from.pose[i], 360.0f))));
+    }
+    return options.maxJointStep + options.jointStepPerMm * distance + turn;
+}
+
+ValidationResult TrajectoryValidator::solveRange(const TrajectoryRecord *records, int begin, int end,
+                                                 const float *previous, const ValidationOptions &options,
+                                                 float *joints) const
+{
+    ValidationResult result;
+    const float* reference = (previous != nullptr) ? previous : REST_JOINTS;
+    for(int n = begin; n < end; ++n)
+    {
+        float* solution = joints + 6 * n;
+        if(!m_kinematics.inverse(records[n].pose, reference, solution))
+        {
+            float unlimited[6];
+            result.error = m_unlimited.inverse(records[n].pose, reference, unlimited)
+                    ? VALIDATION_JOINT_LIMIT : VALIDATION_UNREACHABLE;
+            result.index = n;
+            return result;
+        }
+
+        //块的第一条没有前一条可比，由拼接时检查
+        if(n > begin || previous != nullptr)
+        {
+            float step = 0;
+            int nJoint = maxJointStep(reference, solution, step);
+            if(step > allowedJointStep(records[n - 1], records[n], options))
+            {
+                result.error = VALIDATION_JOINT_JUMP;
+                result.index = n;
+                result.joint = nJoint;
+                result.jointStep = step;
+                return result;
+            }
+        }
+        reference = solution;
+    }
+    return result;
+}
+
+ValidationThread::ValidationThread(const Kinematics &kinematics, QObject *parent)
+    : QThread(parent), m_validator(kinematics)
+{
+
+}
+
+ValidationThread::~ValidationThread()
+{
+    //求解不能中途取消，等这一次做完
+    wait();
+}
+
+bool ValidationThread::check(const QString &filePath, const ValidationOptions &options)
+{
+    if(isRunning())
+    {
+        return false;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_strFilePath = filePath;
+    m_options = options;
+    m_result = ValidationResult();
+    locker.unlock();
+    start();
+    return true;
+}
+
+QString ValidationThread::filePath() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_strFilePath;
+}
+
+ValidationResult ValidationThread::result() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_result;
+}
+
+void ValidationThread::run()
+{
+    QMutexLocker locker(&m_mutex);
+    QString filePath = m_strFilePath;
+    ValidationOptions options = m_options;
+    locker.unlock();
+
+    ValidationResult result = m_validator.validateFile(filePath, options);
+
+    locker.relock();
+    m_result = result;
+}
@@ -0,0 +1,100 @@
+#ifndef TRAJECTORYVALIDATOR_H
+#define TRAJECTORYVALIDATOR_H
+
+#include <QString>
+#include <QVector>
+#include <QThread>
+#include <QMutex>
+#include "kinematics.h"
+#include "trajectoryfile.h"
+
+typedef enum ValidationError
+{
+    VALIDATION_OK,
+    VALIDATION_FILE_ERROR,      //文件打不开
+    VALIDATION_UNREACHABLE,     //超出工作空间
+    VALIDATION_JOINT_LIMIT,     //可达但所有解都超出关节限位
+    VALIDATION_JOINT_JUMP       //相邻两条记录的关节变化过大，一般是换了构型
+}VALIDATION_ERROR;
+
+// 相邻两条记录单个关节允许的变化随这一段的位移和姿态变化放宽：
+//   maxJointStep + jointStepPerMm * 位移(mm) + 姿态角的最大变化(度)
+// 简化过的记录点距很大，固定阈值会把正常的长段误报为跳变
+struct ValidationOptions
+{
+    float maxJointStep = 30;    //几乎不动时单个关节的最大变化，度
+    float jointStepPerMm = 1;   //每毫米位移额外允许的关节变化，度
+};
+
+struct ValidationResult
+{
+    VALIDATION_ERROR error = VALIDATION_OK;
+    int index = -1;             //第一条出错记录的序号，从0开始
+    int joint = -1;             //跳变最大的关节，从0开始
+    float jointStep = 0;
+    int recordCount = 0;
+    qint64 elapsedMs = 0;
+};
+
+// 回放前的预检：逐条求逆解，检查可达性、关节限位和相邻记录的关节跳变
+// 记录分块交给线程池并行求解，拼接时块边界对不上的再顺序重算
+class TrajectoryValidator
+{
+public:
+    //每块至少这么多条，块太小时线程调度的开销比求解大
+    static const int MIN_CHUNK_SIZE = 1024;
+
+    explicit TrajectoryValidator(const Kinematics& kinematics);
+
+    ValidationResult validate(const TrajectoryRecord* records, int count,
+                              const ValidationOptions& options) const;
+
+    //文本记录先转换为二进制缓存，回放时可直接使用
+    ValidationResult validateFile(const QString& filePath, const ValidationOptions& options) const;
+
+    static QString describe(const ValidationResult& result);
+
+    //从from到to这一段允许的单个关节最大变化
+    static float allowedJointStep(const TrajectoryRecord& from, const TrajectoryRecord& to,
+                                  const ValidationOptions& options);
+
+private:
+    friend class ValidateTask;
+
+    //顺序求解[begin, end)，结果写入joints，返回第一条出错的结果
+    //previous为前一条记录的关节角，为空时从回零位出发且不检查第一条的跳变
+    ValidationResult solveRange(const TrajectoryRecord* records, int begin, int end,
+                                const float* previous, const ValidationOptions& options,
+                                float* joints) const;
+
+    Kinematics m_kinematics;
+    //不限位的求解器，用来区分超出工作空间和超出关节限位
+    Kinematics m_unlimited;
+};
+
+// 后台预检：在自己的线程里转换并检查整个文件，界面线程不等待
+// 结束时发出QThread::finished，再用result()取结果
+class ValidationThread : public QThread
+{
+    Q_OBJECT
+public:
+    explicit ValidationThread(const Kinematics& kinematics, QObject *parent = nullptr);
+    ~ValidationThread();
+
+    //开始预检，上一次还没结束时返回false
+    bool check(const QString& filePath, const ValidationOptions& options);
+    QString filePath() const;
+    ValidationResult result() const;
+
+protected:
+    void run() override;
+
+private:
+    TrajectoryValidator m_validator;
+    mutable QMutex m_mutex;
+    QString m_strFilePath;
+    ValidationOptions m_options;
+    ValidationResult m_result;
+};
+
+#endif // TRAJECTORYVALIDATOR_H